@@ -0,0 +1,283 @@
+#include "xml_batch.h"
+
+#include <math.h>
+#include <limits.h>
+
+#define XML_BATCH_MAX_CUTS 32   /* considered step separators of a path */
+
+typedef struct {
+    const char  *xpath;                     /* expression of query */
+    int         query;                      /* index of query */
+    int         cut_cnt;                    /* number of cuts */
+    int         link;                       /* shared leading path with the next path or 0 */
+    int         cuts[XML_BATCH_MAX_CUTS];   /* offsets of top level / step separators */
+} XmlBatchPath;
+
+/* offsets of top level single / separators, -1 if expr is no plain absolute location path */
+static int __xml_batch_cuts(const char *expr, int cuts[]) {
+
+    if ( expr[0] != '/' ) {
+        return -1;
+    }
+
+    int cnt = 0;
+    int depth = 0;
+    char quote = 0;
+
+    for ( int curchar = 0; expr[curchar] != '\0'; ++curchar ) {
+
+        const char c = expr[curchar];
+
+        if ( quote != 0 ) {
+            quote = ( c == quote ? 0 : quote );
+        } else if ( c == '\'' || c == '"' ) {
+            quote = c;
+        } else if ( c == '[' || c == '(' ) {
+            ++depth;
+        } else if ( c == ']' || c == ')' ) {
+            if ( --depth < 0 ) {
+                return -1;
+            }
+        } else if ( depth > 0 ) {
+            continue;
+        } else if ( c == '/' ) {
+            if ( curchar > 0 && expr[curchar - 1] != '/' && expr[curchar + 1] != '/' &&
+                 expr[curchar + 1] != '\0' && cnt < XML_BATCH_MAX_CUTS ) {
+                cuts[cnt++] = curchar;
+            }
+        } else if ( c == '*' ) {
+            /* name test, otherwise a multiplication */
+            const char prev = expr[curchar - 1];
+            if ( prev != '/' && prev != '@' && prev != ':' ) {
+                return -1;
+            }
+        } else if ( strchr(" \t\r\n|=<>!+,$", c) != NULL ) {
+            return -1;
+        }
+    }
+
+    return ( quote == 0 && depth == 0 ? cnt : -1 );
+}
+
+static bool __xml_batch_has_cut(const XmlBatchPath *path, int cut) {
+
+    for ( int curcut = 0; curcut < path->cut_cnt; ++curcut ) {
+        if ( path->cuts[curcut] == cut ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* longest common leading path of a and b up to limit, 0 if there is none */
+static int __xml_batch_shared(const XmlBatchPath *a, const XmlBatchPath *b, int limit) {
+
+    for ( int curcut = a->cut_cnt - 1; curcut >= 0; --curcut ) {
+
+        const int cut = a->cuts[curcut];
+
+        if ( cut <= limit && __xml_batch_has_cut(b, cut) && strncmp(a->xpath, b->xpath, cut) == 0 ) {
+            return cut;
+        }
+    }
+
+    return 0;
+}
+
+static int __xml_batch_path_cmp(const void *a, const void *b) {
+    return strcmp(((const XmlBatchPath *)a)->xpath, ((const XmlBatchPath *)b)->xpath);
+}
+
+static void __xml_batch_reset(XmlBatchQuery *query) {
+    query->valid = false;
+    query->group = -1;
+    query->nodes = NULL;
+    query->string = NULL;
+    query->number = NAN;
+    query->boolean = false;
+}
+
+/* takes result */
+static void __xml_batch_result(XmlBatchQuery *query, xmlXPathObjectPtr result) {
+
+    if ( result == NULL ) {
+        return;
+    }
+
+    query->valid = true;
+
+    switch ( query->kind ) {
+        case XML_BATCH_NODESET:
+            query->nodes = result;
+            return;
+        case XML_BATCH_STRING:
+            query->string = xmlXPathCastToString(result);
+            break;
+        case XML_BATCH_NUMBER:
+            query->number = xmlXPathCastToNumber(result);
+            break;
+        case XML_BATCH_BOOLEAN:
+            query->boolean = ( xmlXPathCastToBoolean(result) != 0 );
+            break;
+        case XML_BATCH_EXISTS:
+            query->boolean = xml_xpath_has_result(result);
+            break;
+    }
+
+    xmlXPathFreeObject(result);
+}
+
+/* remaining steps of query relative to the nodes of the leading path, NULL on failure */
+static xmlXPathObjectPtr __xml_batch_eval_rest(XmlCtx *ctx, xmlNodeSetPtr leading, const char *rest) {
+
+    xmlNodeSetPtr merged = xmlXPathNodeSetCreate(NULL);
+
+    for ( int curnode = 0; merged != NULL && curnode < leading->nodeNr; ++curnode ) {
+
+        xmlXPathObjectPtr found = xml_ctx_xpath_node(ctx, leading->nodeTab[curnode], rest);
+
+        if ( found == NULL || found->type != XPATH_NODESET ) {
+            xmlXPathFreeObject(found);
+            xmlXPathFreeNodeSet(merged);
+            return NULL;
+        }
+
+        if ( found->nodesetval != NULL && found->nodesetval->nodeNr > 0 ) {
+            merged = xmlXPathNodeSetMerge(merged, found->nodesetval);
+        }
+
+        xmlXPathFreeObject(found);
+    }
+
+    if ( merged != NULL && leading->nodeNr > 1 ) {
+        xmlXPathNodeSetSort(merged);
+    }
+
+    return ( merged != NULL ? xmlXPathWrapNodeSet(merged) : NULL );
+}
+
+static void __xml_batch_eval_group(XmlCtx *ctx, XmlBatchQuery *queries, const XmlBatchPath *paths, int cnt, int shared, int group) {
+
+    char *leadingPath = malloc(shared + 1);
+    memcpy(leadingPath, paths[0].xpath, shared);
+    leadingPath[shared] = '\0';
+
+    xmlXPathObjectPtr leading = xml_ctx_xpath(ctx, leadingPath);
+    const bool isNodeset = ( leading != NULL && leading->type == XPATH_NODESET );
+
+    for ( int curpath = 0; curpath < cnt; ++curpath ) {
+
+        XmlBatchQuery *query = &queries[paths[curpath].query];
+        xmlXPathObjectPtr result = NULL;
+
+        if ( isNodeset && leading->nodesetval != NULL ) {
+            result = __xml_batch_eval_rest(ctx, leading->nodesetval, query->xpath + shared + 1);
+        } else if ( isNodeset ) {
+            result = xmlXPathNewNodeSet(NULL);
+        }
+
+        if ( result != NULL ) {
+            query->group = group;
+        } else {
+            result = xml_ctx_xpath(ctx, query->xpath);
+        }
+
+        __xml_batch_result(query, result);
+    }
+
+    xmlXPathFreeObject(leading);
+    free(leadingPath);
+}
+
+int xml_ctx_batch(XmlCtx *ctx, XmlBatchQuery *queries, int cnt) {
+
+    if ( ctx == NULL || ctx->doc == NULL ) {
+        return -1;
+    }
+
+    if ( queries == NULL || cnt <= 0 ) {
+        return 0;
+    }
+
+    XmlBatchPath *paths = malloc(cnt * sizeof(XmlBatchPath));
+    int pathCnt = 0;
+
+    for ( int curquery = 0; curquery < cnt; ++curquery ) {
+
+        XmlBatchQuery *query = &queries[curquery];
+        XmlBatchPath *path = &paths[pathCnt];
+
+        __xml_batch_reset(query);
+
+        if ( query->xpath == NULL ) {
+            continue;
+        }
+
+        path->xpath = query->xpath;
+        path->query = curquery;
+        path->cut_cnt = __xml_batch_cuts(query->xpath, path->cuts);
+
+        if ( path->cut_cnt > 0 ) {
+            ++pathCnt;
+        } else {
+            __xml_batch_result(query, xml_ctx_xpath(ctx, query->xpath));
+        }
+    }
+
+    /* equal leading paths are neighbours after sorting */
+    qsort(paths, pathCnt, sizeof(XmlBatchPath), __xml_batch_path_cmp);
+
+    for ( int curpath = 0; curpath < pathCnt; ++curpath ) {
+        paths[curpath].link = ( curpath + 1 < pathCnt ? __xml_batch_shared(&paths[curpath], &paths[curpath + 1], INT_MAX) : 0 );
+    }
+
+    int group = 0;
+
+    for ( int start = 0, end; start < pathCnt; start = end ) {
+
+        int shared = INT_MAX;
+
+        /* a path joins its neighbour, unless one of them shares a longer leading path with its other neighbour */
+        for ( end = start + 1; end < pathCnt; ++end ) {
+
+            const int link = paths[end - 1].link;
+
+            if ( link == 0 || ( end - 1 > start && link < paths[end - 2].link ) || link < paths[end].link ) {
+                break;
+            }
+
+            shared = ( link < shared ? link : shared );
+        }
+
+        if ( end - start > 1 ) {
+            __xml_batch_eval_group(ctx, queries, &paths[start], end - start, shared, group++);
+        } else {
+            __xml_batch_result(&queries[paths[start].query], xml_ctx_xpath(ctx, paths[start].xpath));
+        }
+    }
+
+    free(paths);
+
+    int invalid = 0;
+
+    for ( int curquery = 0; curquery < cnt; ++curquery ) {
+        if ( !queries[curquery].valid ) {
+            ++invalid;
+        }
+    }
+
+    return invalid;
+}
+
+void xml_batch_free(XmlBatchQuery *queries, int cnt) {
+
+    for ( int curquery = 0; queries != NULL && curquery < cnt; ++curquery ) {
+
+        xmlXPathFreeObject(queries[curquery].nodes);
+        xmlFree(queries[curquery].string);
+
+        queries[curquery].nodes = NULL;
+        queries[curquery].string = NULL;
+    }
+}
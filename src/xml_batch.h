@@ -0,0 +1,94 @@
+#ifndef XML_BATCH_H
+#define XML_BATCH_H
+
+#if 0
+    Batched evaluation of many xpath queries against one context.
+
+    All queries of a batch share the evaluation context and the compiled expression
+    cache of the xml context. Absolute location paths with a common leading part are
+    grouped, the common part is evaluated once and the remaining steps of each query
+    are evaluated relative to its nodes:
+
+        /hero/talents/group/talent[@name = 'Dolche']/@value
+        /hero/talents/group/talent[@name = 'Säbel']/@value     -> /hero/talents/group once
+        /hero/talents/group[@name = 'Kampf']/talent
+
+    Only paths without top level operators or unions are grouped, and the common part
+    ends before a single / step separator. Other expressions like count(...) are
+    evaluated one by one. The results are the same as of separate evaluations,
+    node-sets are in document order.
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <libxml/xpath.h>
+
+#include "xml_utils.h"
+
+typedef enum {
+    XML_BATCH_NODESET,      /* xpath result object like xml_ctx_xpath */
+    XML_BATCH_STRING,       /* string value of the result, first node of node-sets */
+    XML_BATCH_NUMBER,       /* number value of the result, NaN if there is none */
+    XML_BATCH_BOOLEAN,      /* boolean value of the result */
+    XML_BATCH_EXISTS        /* result has nodes, like xml_ctx_exist */
+} XmlBatchKind;
+
+typedef struct {
+    const char          *xpath;     /* expression */
+    XmlBatchKind        kind;       /* kind of result */
+    bool                valid;      /* false if the expression could not be evaluated */
+    int                 group;      /* index of shared leading path or -1 */
+    xmlXPathObjectPtr   nodes;      /* XML_BATCH_NODESET result or NULL */
+    xmlChar             *string;    /* XML_BATCH_STRING result or NULL */
+    double              number;     /* XML_BATCH_NUMBER result */
+    bool                boolean;    /* XML_BATCH_BOOLEAN and XML_BATCH_EXISTS result */
+} XmlBatchQuery;
+
+/*
+
+    This Function evaluates all queries against the context document. The results are
+    written to the queries, the query array is not reordered.
+
+    Example:
+        XmlBatchQuery queries[] = {
+            { .xpath = "/hero/@name", .kind = XML_BATCH_STRING },
+            { .xpath = "/hero/attributes/attribute[@shortname = 'MU']/@value", .kind = XML_BATCH_NUMBER },
+            { .xpath = "/hero/attributes/attribute[@shortname = 'KL']/@value", .kind = XML_BATCH_NUMBER },
+            { .xpath = "/hero/talents//talent[@value > 0]", .kind = XML_BATCH_NODESET }
+        };
+
+        xml_ctx_batch(ctx, queries, 4);
+        ...
+        xml_batch_free(queries, 4);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context
+    queries         queries with xpath and kind set
+    cnt             number of queries
+
+    returns number of invalid queries, 0 if all were evaluated, -1 if ctx has no document
+*/
+int xml_ctx_batch(XmlCtx *ctx, XmlBatchQuery *queries, int cnt);
+
+/*
+
+    This Function frees the node-set and string results of the queries. The expressions
+    are kept, so the queries can be evaluated again.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    queries         evaluated queries
+    cnt             number of queries
+
+*/
+void xml_batch_free(XmlBatchQuery *queries, int cnt);
+
+#endif
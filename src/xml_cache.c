@@ -0,0 +1,271 @@
+#include "xml_cache.h"
+
+/* estimated memory of document nodes and source data, dictionary names are not counted */
+static size_t __xml_cache_doc_size(XmlCtx *ctx) {
+
+    size_t size = sizeof(XmlCtx) + sizeof(xmlDoc);
+
+    if ( ctx->src != NULL ) {
+        size += *ctx->src->src_size;
+    }
+
+    xmlDictPtr dict = ctx->doc->dict;
+    xmlNodePtr root = xmlDocGetRootElement(ctx->doc);
+    xmlNodePtr cur = root;
+
+    while ( cur != NULL ) {
+
+        size += sizeof(xmlNode);
+
+        if ( cur->type == XML_ELEMENT_NODE ) {
+
+            for ( xmlAttrPtr attr = cur->properties; attr != NULL; attr = attr->next ) {
+                size += sizeof(xmlAttr);
+
+                for ( xmlNodePtr text = attr->children; text != NULL; text = text->next ) {
+                    size += sizeof(xmlNode);
+                    if ( text->content != NULL && text->content != (xmlChar *)&text->properties &&
+                         ( dict == NULL || !xmlDictOwns(dict, text->content) ) ) {
+                        size += xmlStrlen(text->content) + 1;
+                    }
+                }
+            }
+
+            if ( cur->children != NULL ) {
+                cur = cur->children;
+                continue;
+            }
+
+        } else if ( cur->content != NULL && cur->content != (xmlChar *)&cur->properties &&
+                    ( dict == NULL || !xmlDictOwns(dict, cur->content) ) ) {
+            size += xmlStrlen(cur->content) + 1;
+        }
+
+        while ( cur != root && cur->next == NULL ) {
+            cur = cur->parent;
+        }
+
+        cur = ( cur != root ? cur->next : NULL );
+    }
+
+    return size;
+}
+
+static void __xml_cache_unlink(XmlCache *cache, XmlCacheEntry *entry) {
+
+    if ( entry->prev != NULL ) entry->prev->next = entry->next; else cache->head = entry->next;
+    if ( entry->next != NULL ) entry->next->prev = entry->prev; else cache->tail = entry->prev;
+
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+static void __xml_cache_push_front(XmlCache *cache, XmlCacheEntry *entry) {
+
+    entry->prev = NULL;
+    entry->next = cache->head;
+
+    if ( cache->head != NULL ) cache->head->prev = entry;
+
+    cache->head = entry;
+
+    if ( cache->tail == NULL ) cache->tail = entry;
+}
+
+static void __xml_cache_unload(XmlCache *cache, XmlCacheEntry *entry) {
+    free_xml_ctx_src(&entry->ctx);
+    cache->stats.used -= entry->size;
+    entry->size = 0;
+}
+
+/* frees unused documents from least recently used until used memory fits the budget */
+static void __xml_cache_shrink(XmlCache *cache) {
+
+    XmlCacheEntry *entry = cache->tail;
+
+    while ( entry != NULL && cache->stats.budget > 0 && cache->stats.used > cache->stats.budget ) {
+
+        XmlCacheEntry *prev = entry->prev;
+
+        if ( entry->refs == 0 && entry->ctx != NULL ) {
+            __xml_cache_unload(cache, entry);
+            ++cache->stats.evictions;
+        }
+
+        entry = prev;
+    }
+}
+
+static void __xml_cache_entry_free(void *payload, const xmlChar *name) {
+    (void)(name);
+
+    XmlCacheEntry *entry = payload;
+
+    free_xml_ctx_src(&entry->ctx);
+    xmlFree(entry->name);
+    free(entry);
+}
+
+XmlCache* xml_cache_new(int options, size_t budget) {
+
+    XmlCache *cache = malloc(sizeof(XmlCache));
+
+    cache->options = options;
+    cache->entries = xmlHashCreate(32);
+    cache->head = NULL;
+    cache->tail = NULL;
+
+    memset(&cache->stats, 0, sizeof(XmlCacheStats));
+    cache->stats.budget = budget;
+
+    return cache;
+}
+
+XmlCtx* xml_cache_get(XmlCache *cache, ArchiveResource *ar, const char *name) {
+
+    if ( cache == NULL || ar == NULL || name == NULL ) {
+        return NULL;
+    }
+
+    char key[32];
+    snprintf(key, sizeof(key), "%p", (void *)ar);
+
+    XmlCacheEntry *entry = xmlHashLookup2(cache->entries, (const xmlChar *)name, (const xmlChar *)key);
+
+    if ( entry == NULL ) {
+        entry = malloc(sizeof(XmlCacheEntry));
+        entry->name = xmlStrdup((const xmlChar *)name);
+        memcpy(entry->key, key, sizeof(key));
+        entry->ar = ar;
+        entry->ctx = NULL;
+        entry->refs = 0;
+        entry->size = 0;
+        entry->prev = NULL;
+        entry->next = NULL;
+
+        xmlHashAddEntry2(cache->entries, entry->name, (const xmlChar *)entry->key, entry);
+    } else {
+        __xml_cache_unlink(cache, entry);
+    }
+
+    __xml_cache_push_front(cache, entry);
+
+    if ( entry->ctx == NULL ) {
+
+        XmlCtx *ctx = xml_ctx_new_opts(xml_source_from_resname(ar, name), cache->options);
+
+        if ( ctx->doc == NULL ) {
+            free_xml_ctx_src(&ctx);
+
+            /* handles only exist of parsed documents, so there is none of entry */
+            __xml_cache_unlink(cache, entry);
+            xmlHashRemoveEntry2(cache->entries, entry->name, (const xmlChar *)entry->key, __xml_cache_entry_free);
+
+            ++cache->stats.failed;
+
+            return NULL;
+        }
+
+        entry->ctx = ctx;
+        entry->size = __xml_cache_doc_size(ctx);
+
+        cache->stats.used += entry->size;
+        ++cache->stats.parses;
+
+        ++entry->refs;
+
+        __xml_cache_shrink(cache);
+
+    } else {
+        ++cache->stats.hits;
+        ++entry->refs;
+    }
+
+    return entry->ctx;
+}
+
+void xml_cache_release(XmlCache *cache, XmlCtx **ctx) {
+
+    if ( cache == NULL || ctx == NULL || *ctx == NULL ) {
+        return;
+    }
+
+    XmlCacheEntry *entry = cache->head;
+
+    while ( entry != NULL && entry->ctx != *ctx ) {
+        entry = entry->next;
+    }
+
+    if ( entry != NULL && entry->refs > 0 ) {
+
+        --entry->refs;
+
+        if ( entry->refs == 0 ) {
+            __xml_cache_shrink(cache);
+        }
+    }
+
+    *ctx = NULL;
+}
+
+void xml_cache_set_budget(XmlCache *cache, size_t budget) {
+
+    if ( cache != NULL ) {
+        cache->stats.budget = budget;
+        __xml_cache_shrink(cache);
+    }
+}
+
+void xml_cache_stats(const XmlCache *cache, XmlCacheStats *stats) {
+
+    if ( cache != NULL && stats != NULL ) {
+        memcpy(stats, &cache->stats, sizeof(XmlCacheStats));
+    }
+}
+
+int xml_cache_archive_free(XmlCache *cache, const ArchiveResource *ar) {
+
+    int kept = 0;
+
+    if ( cache == NULL || ar == NULL ) {
+        return kept;
+    }
+
+    XmlCacheEntry *entry = cache->head;
+
+    while ( entry != NULL ) {
+
+        XmlCacheEntry *next = entry->next;
+
+        if ( entry->ar == ar ) {
+
+            if ( entry->refs > 0 ) {
+                ++kept;
+            } else {
+                if ( entry->ctx != NULL ) {
+                    __xml_cache_unload(cache, entry);
+                }
+
+                __xml_cache_unlink(cache, entry);
+                xmlHashRemoveEntry2(cache->entries, entry->name, (const xmlChar *)entry->key, __xml_cache_entry_free);
+            }
+        }
+
+        entry = next;
+    }
+
+    return kept;
+}
+
+void xml_cache_free(XmlCache **cache) {
+
+    if ( cache != NULL && *cache != NULL ) {
+
+        XmlCache *to_delete = *cache;
+
+        xmlHashFree(to_delete->entries, __xml_cache_entry_free);
+        free(to_delete);
+
+        *cache = NULL;
+    }
+}
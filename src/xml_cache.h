@@ -0,0 +1,172 @@
+#ifndef XML_CACHE_H
+#define XML_CACHE_H
+
+#if 0
+    Cache of parsed archive documents.
+
+    Documents are parsed once per archive and resource name and handed out as shared
+    XmlCtx handles with reference counting. Unused documents stay parsed until the
+    memory budget is exceeded, then the least recently used unused documents are
+    freed and parsed again on their next use.
+
+    The handed out contexts are shared, they must not be changed and the cache is
+    not thread safe. Even queries write the state, the xpath cache and the evaluation
+    context of a context (see xml_utils.h), so all holders of one cached context have
+    to use it from the same thread or one thread at a time.
+
+    Resources which are missing or could not be parsed are not kept, they are counted
+    as failed and parsed again by the next xml_cache_get.
+
+    Documents are keyed by the address of their archive, so the documents of an
+    archive have to be freed by xml_cache_archive_free before the archive is freed.
+    Otherwise a new archive at the same address would get the documents of the freed
+    one.
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <libxml/hash.h>
+#include <libxml/tree.h>
+
+#include "resource.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+
+typedef struct _xml_cache_entry {
+    xmlChar                     *name;      /* resource name */
+    char                        key[32];    /* address of archive, second hash key */
+    ArchiveResource             *ar;        /* archive of resource */
+    XmlCtx                      *ctx;       /* parsed context, NULL if evicted */
+    int                         refs;       /* handed out handles */
+    size_t                      size;       /* estimated memory of parsed document */
+    struct _xml_cache_entry     *prev;      /* more recently used entry */
+    struct _xml_cache_entry     *next;      /* less recently used entry */
+} XmlCacheEntry;
+
+typedef struct {
+    size_t  hits;       /* handles of parsed documents */
+    size_t  parses;     /* parsed documents, first use and reparse */
+    size_t  evictions;  /* documents freed because of budget */
+    size_t  failed;     /* parses of missing or invalid resources */
+    size_t  used;       /* estimated memory of all parsed documents */
+    size_t  budget;     /* memory budget, 0 for unlimited */
+} XmlCacheStats;
+
+typedef struct {
+    int             options;    /* XmlCtxOption of parsing */
+    xmlHashTablePtr entries;    /* (name, archive) => XmlCacheEntry */
+    XmlCacheEntry   *head;      /* most recently used */
+    XmlCacheEntry   *tail;      /* least recently used */
+    XmlCacheStats   stats;
+} XmlCache;
+
+/*
+
+    This Function creates a document cache.
+
+    Example:
+        XmlCache *cache = xml_cache_new(XML_CTX_OPT_COMPACT_READONLY, 32 * 1024 * 1024);
+
+        XmlCtx *breeds = xml_cache_get(cache, ar, "breeds");
+        ...
+        xml_cache_release(cache, &breeds);
+
+        xml_cache_free(&cache);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    options         combination of XmlCtxOption used for parsing
+    budget          memory budget of parsed documents in bytes, 0 for unlimited
+
+    returns new cache
+*/
+XmlCache* xml_cache_new(int options, size_t budget);
+
+/*
+
+    This Function returns the shared context of resource name of archive ar, parsed
+    on demand. Every handle has to be released by xml_cache_release.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    cache           document cache
+    ar              archive resource
+    name            name of resource like xml_source_from_resname
+
+    returns shared context or NULL if the resource was not found or is invalid
+*/
+XmlCtx* xml_cache_get(XmlCache *cache, ArchiveResource *ar, const char *name);
+
+/*
+
+    This Function releases a handle of xml_cache_get. The pointer will be NULL.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    cache           document cache
+    ctx             pointer to handle
+
+*/
+void xml_cache_release(XmlCache *cache, XmlCtx **ctx);
+
+/*
+
+    This Functions change the budget and read the statistics of the cache.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    cache           document cache
+    budget          memory budget in bytes, 0 for unlimited
+    stats           target of statistics
+
+*/
+void xml_cache_set_budget(XmlCache *cache, size_t budget);
+void xml_cache_stats(const XmlCache *cache, XmlCacheStats *stats);
+
+/*
+
+    This Function frees all documents of archive ar. It has to be called before the
+    archive is freed. All handles of these documents have to be released before,
+    documents with handles are kept.
+
+    Example:
+        xml_cache_archive_free(cache, ar);
+        archive_resource_free(&ar);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    cache           document cache
+    ar              archive resource
+
+    returns number of kept documents with handles, 0 if all documents of ar are freed
+*/
+int xml_cache_archive_free(XmlCache *cache, const ArchiveResource *ar);
+
+/*
+
+    This Function frees the cache and all parsed documents. All handles have to be
+    released before. The pointer will be NULL.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    cache           pointer to document cache
+
+*/
+void xml_cache_free(XmlCache **cache);
+
+#endif
@@ -0,0 +1,188 @@
+#include "xml_column.h"
+
+/* error of a value which could not be parsed */
+static XmlColumnError __xml_column_failed(xmlNodePtr node) {
+
+    xmlChar *text = xmlXPathCastNodeToString(node);
+    const xmlChar *cur = text;
+
+    while ( cur != NULL && xmlIsBlank_ch(*cur) ) {
+        ++cur;
+    }
+
+    const XmlColumnError error = ( cur == NULL || *cur == '\0' ? XML_COLUMN_EMPTY : XML_COLUMN_INVALID );
+
+    xmlFree(text);
+
+    return error;
+}
+
+static void __xml_column_parse(XmlColumnType type, const xmlNodeSetPtr nodes, int cnt, void *values, XmlColumnError errors[]) {
+
+    for ( int curnode = 0; curnode < cnt; ++curnode ) {
+
+        xmlNodePtr node = nodes->nodeTab[curnode];
+        XmlColumnError error = XML_COLUMN_OK;
+
+        if ( type == XML_COLUMN_DOUBLE ) {
+
+            const double value = xpath_node_to_number(node);
+
+            if ( isnan(value) ) {
+                error = __xml_column_failed(node);
+            }
+
+            ((double *)values)[curnode] = value;
+
+        } else {
+
+            int64_t value = 0;
+            const int parsed = xpath_node_to_int64(node, &value);
+
+            if ( parsed != 0 ) {
+                error = ( parsed > 0 ? XML_COLUMN_RANGE : __xml_column_failed(node) );
+                value = 0;
+            }
+
+            ((int64_t *)values)[curnode] = value;
+        }
+
+        if ( errors != NULL ) {
+            errors[curnode] = error;
+        }
+    }
+}
+
+static size_t __xml_column_size(XmlColumnType type) {
+    return ( type == XML_COLUMN_DOUBLE ? sizeof(double) : sizeof(int64_t) );
+}
+
+/* evaluates xpath, returns NULL if the result is no node-set */
+static xmlXPathObjectPtr __xml_column_eval(XmlCtx *ctx, const char *xpath) {
+
+    xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
+
+    if ( found != NULL && found->type != XPATH_NODESET ) {
+        xmlXPathFreeObject(found);
+        found = NULL;
+    }
+
+    return found;
+}
+
+/* cached column of current document version, NULL if xpath is invalid */
+static XmlColumn* __xml_column_cached(XmlCtx *ctx, const char *xpath, XmlColumnType type) {
+
+    XmlColumn *column = ctx->columns;
+
+    while ( column != NULL && ( column->type != type || !xmlStrEqual(column->xpath, (const xmlChar *)xpath) ) ) {
+        column = column->next;
+    }
+
+    if ( column != NULL && column->version == ctx->version ) {
+        return column;
+    }
+
+    xmlXPathObjectPtr found = __xml_column_eval(ctx, xpath);
+
+    if ( found == NULL ) {
+        return NULL;
+    }
+
+    if ( column == NULL ) {
+        column = calloc(1, sizeof(XmlColumn));
+        column->xpath = xmlStrdup((const xmlChar *)xpath);
+        column->type = type;
+        column->next = ctx->columns;
+        ctx->columns = column;
+    }
+
+    const int cnt = ( found->nodesetval != NULL ? found->nodesetval->nodeNr : 0 );
+    const size_t slots = ( cnt > 0 ? (size_t)cnt : 1 );
+
+    column->values = realloc(column->values, slots * __xml_column_size(type));
+    column->errors = realloc(column->errors, slots * sizeof(XmlColumnError));
+    column->cnt = cnt;
+    column->version = ctx->version;
+
+    __xml_column_parse(type, found->nodesetval, cnt, column->values, column->errors);
+
+    xmlXPathFreeObject(found);
+
+    return column;
+}
+
+static int __xml_column_extract(XmlCtx *ctx, const char *xpath, int flags, XmlColumnType type, void *values, XmlColumnError errors[], int max) {
+
+    if ( ctx == NULL || ctx->doc == NULL || xpath == NULL ) {
+        return -1;
+    }
+
+    max = ( max > 0 && values != NULL ? max : 0 );
+
+    if ( flags & XML_COLUMN_CACHE ) {
+
+        const XmlColumn *column = __xml_column_cached(ctx, xpath, type);
+
+        if ( column == NULL ) {
+            return -1;
+        }
+
+        const int cnt = ( column->cnt < max ? column->cnt : max );
+
+        if ( cnt > 0 ) {
+            memcpy(values, column->values, cnt * __xml_column_size(type));
+        }
+
+        if ( cnt > 0 && errors != NULL ) {
+            memcpy(errors, column->errors, cnt * sizeof(XmlColumnError));
+        }
+
+        return column->cnt;
+    }
+
+    xmlXPathObjectPtr found = __xml_column_eval(ctx, xpath);
+
+    if ( found == NULL ) {
+        return -1;
+    }
+
+    const int matched = ( found->nodesetval != NULL ? found->nodesetval->nodeNr : 0 );
+
+    __xml_column_parse(type, found->nodesetval, ( matched < max ? matched : max ), values, errors);
+
+    xmlXPathFreeObject(found);
+
+    return matched;
+}
+
+int xml_ctx_column_double(XmlCtx *ctx, const char *xpath, int flags, double values[], XmlColumnError errors[], int max) {
+    return __xml_column_extract(ctx, xpath, flags, XML_COLUMN_DOUBLE, values, errors, max);
+}
+
+int xml_ctx_column_int64(XmlCtx *ctx, const char *xpath, int flags, int64_t values[], XmlColumnError errors[], int max) {
+    return __xml_column_extract(ctx, xpath, flags, XML_COLUMN_INT64, values, errors, max);
+}
+
+void xml_ctx_column_cache_free(XmlCtx *ctx) {
+
+    if ( ctx == NULL ) {
+        return;
+    }
+
+    XmlColumn *column = ctx->columns;
+
+    while ( column != NULL ) {
+
+        XmlColumn *next = column->next;
+
+        xmlFree(column->xpath);
+        free(column->values);
+        free(column->errors);
+        free(column);
+
+        column = next;
+    }
+
+    ctx->columns = NULL;
+}
@@ -0,0 +1,103 @@
+#ifndef XML_COLUMN_H
+#define XML_COLUMN_H
+
+#if 0
+    Numeric columns of xpath results.
+
+    One expression is evaluated and the values of all matched nodes are parsed into
+    an array of the caller, like all talent values of //talent/@value. Numbers are
+    read like the xpath function number() without copy of the node values, plain
+    integers and decimals up to 15 digits by a fast path of xpath_utils. Every
+    value has its own error code instead of one failure for the whole column.
+
+    With XML_COLUMN_CACHE the parsed column is kept by the context and copied by the
+    next extractions of the same expression, until the document was changed by
+    xml_ctx functions (see xml_ctx_doc_changed).
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+
+#include "xml_utils.h"
+#include "xpath_utils.h"
+
+typedef enum {
+    XML_COLUMN_CACHE = 1            /* keep parsed column in context */
+} XmlColumnFlag;
+
+typedef enum {
+    XML_COLUMN_OK = 0,              /* value parsed */
+    XML_COLUMN_EMPTY,               /* node value is empty or blank */
+    XML_COLUMN_INVALID,             /* node value is no number, or no integer for int64 */
+    XML_COLUMN_RANGE                /* integer out of int64 range */
+} XmlColumnError;
+
+typedef enum {
+    XML_COLUMN_DOUBLE,
+    XML_COLUMN_INT64
+} XmlColumnType;
+
+typedef struct _xml_column {
+    xmlChar                 *xpath;     /* expression of column */
+    XmlColumnType           type;       /* type of values */
+    void                    *values;    /* double or int64_t values */
+    XmlColumnError          *errors;    /* error of each value */
+    int                     cnt;        /* number of values */
+    unsigned long           version;    /* context version the column was parsed for */
+    struct _xml_column      *next;      /* next cached column of same context */
+} XmlColumn;
+
+/*
+
+    This Functions parse the values of all nodes matched by xpath.
+
+    xml_ctx_column_double   values like number(), NaN on errors
+    xml_ctx_column_int64    integer values, 0 on errors
+
+    Example:
+        double values[200];
+        XmlColumnError errors[200];
+
+        int cnt = xml_ctx_column_double(ctx, "//talent/@value", XML_COLUMN_CACHE, values, errors, 200);
+
+        for ( int cur = 0; cur < cnt && cur < 200; ++cur ) {
+            if ( errors[cur] == XML_COLUMN_OK ) ... values[cur]
+        }
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context
+    xpath           xpath with node-set result
+    flags           combination of XmlColumnFlag
+    values          target of max values in document order
+    errors          target of max errors or NULL
+    max             size of values and errors
+
+    returns number of matched nodes, which could be more than max, or -1 if xpath is
+    invalid or no node-set. Only the first max values are written.
+*/
+int xml_ctx_column_double(XmlCtx *ctx, const char *xpath, int flags, double values[], XmlColumnError errors[], int max);
+int xml_ctx_column_int64(XmlCtx *ctx, const char *xpath, int flags, int64_t values[], XmlColumnError errors[], int max);
+
+/*
+
+    This Function frees all cached columns of the context.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context
+
+*/
+void xml_ctx_column_cache_free(XmlCtx *ctx);
+
+#endif
@@ -0,0 +1,311 @@
+#include "xml_cursor.h"
+
+/* true if the axis name in front of "::" at end is child, attribute or self */
+static bool __xml_cursor_local_axis(const char *rest, int end) {
+
+    int start = end;
+
+    while ( start > 0 && ( isalpha((unsigned char)rest[start - 1]) || rest[start - 1] == '-' ) ) {
+        --start;
+    }
+
+    const int len = end - start;
+
+    return ( ( len == 5 && strncmp(&rest[start], "child", 5) == 0 ) ||
+             ( len == 9 && strncmp(&rest[start], "attribute", 9) == 0 ) ||
+             ( len == 4 && strncmp(&rest[start], "self", 4) == 0 ) );
+}
+
+/* true if rest only has child, attribute or self steps at top level */
+static bool __xml_cursor_local(const char *rest) {
+
+    if ( rest[0] == '\0' || rest[0] == '/' ) {
+        return false;
+    }
+
+    int depth = 0;
+    char quote = 0;
+
+    for ( int curchar = 0; rest[curchar] != '\0'; ++curchar ) {
+
+        const char c = rest[curchar];
+        const char next = rest[curchar + 1];
+
+        if ( quote != 0 ) {
+            quote = ( c == quote ? 0 : quote );
+        } else if ( c == '\'' || c == '"' ) {
+            quote = c;
+        } else if ( c == '[' || c == '(' ) {
+            ++depth;
+        } else if ( c == ']' || c == ')' ) {
+            if ( --depth < 0 ) {
+                return false;
+            }
+        } else if ( depth > 0 ) {
+            continue;
+        } else if ( c == ':' && next == ':' ) {
+            if ( !__xml_cursor_local_axis(rest, curchar) ) {
+                return false;
+            }
+            ++curchar;
+        } else if ( ( c == '/' && next == '/' ) || ( c == '.' && next == '.' ) ) {
+            return false;
+        } else if ( c == '*' && curchar > 0 && rest[curchar - 1] != '/' && rest[curchar - 1] != '@' ) {
+            return false;
+        } else if ( strchr(" \t\r\n|=<>!+,$", c) != NULL ) {
+            return false;
+        }
+    }
+
+    return ( quote == 0 && depth == 0 );
+}
+
+/* restricted leading path and local rest of xpath */
+static bool __xml_cursor_split(XmlCursor *cursor, const char *xpath) {
+
+    /* steps of a valid location path select nodes, a rest like count(@value) of
+       //talent/count(@value) compiles alone, but not as part of the expression */
+    xmlXPathCompExprPtr whole = xmlXPathCompile((const xmlChar *)xpath);
+
+    if ( whole == NULL ) {
+        return false;
+    }
+
+    xmlXPathFreeCompExpr(whole);
+
+    const size_t len = strlen(xpath);
+
+    for ( size_t cut = len; cut-- > 1; ) {
+
+        if ( xpath[cut] != '/' || !__xml_cursor_local(&xpath[cut + 1]) ) {
+            continue;
+        }
+
+        char *leading = malloc(cut + 1);
+        memcpy(leading, xpath, cut);
+        leading[cut] = '\0';
+
+        cursor->path = xml_path_new(leading);
+
+        free(leading);
+
+        if ( cursor->path == NULL ) {
+            continue;
+        }
+
+        xmlXPathCompExprPtr comp = xmlXPathCompile((const xmlChar *)&xpath[cut + 1]);
+
+        if ( comp == NULL ) {
+            xml_path_free(&cursor->path);
+            return false;
+        }
+
+        xmlXPathFreeCompExpr(comp);
+
+        cursor->rest = malloc(len - cut);
+        memcpy(cursor->rest, &xpath[cut + 1], len - cut);
+
+        return true;
+    }
+
+    return false;
+}
+
+static bool __xml_cursor_init(XmlCursor *cursor, XmlCtx *ctx, const char *xpath, int flags) {
+
+    memset(cursor, 0, sizeof(XmlCursor));
+    cursor->ctx = ctx;
+    cursor->depth = -1;
+
+    if ( ctx == NULL || ctx->doc == NULL || xpath == NULL ) {
+        return false;
+    }
+
+    cursor->path = xml_path_new(xpath);
+
+    if ( cursor->path != NULL ) {
+        return true;
+    }
+
+    if ( ( flags & XML_CURSOR_UNORDERED ) && __xml_cursor_split(cursor, xpath) ) {
+        return true;
+    }
+
+    cursor->result = xml_ctx_xpath(ctx, xpath);
+
+    return ( cursor->result != NULL && cursor->result->type == XPATH_NODESET );
+}
+
+static void __xml_cursor_clear(XmlCursor *cursor) {
+
+    xml_path_free(&cursor->path);
+    free(cursor->rest);
+    free(cursor->states);
+    xmlXPathFreeObject(cursor->result);
+
+    memset(cursor, 0, sizeof(XmlCursor));
+}
+
+/* next element of the walk matched by path, NULL at end of document */
+static xmlNodePtr __xml_cursor_walk(XmlCursor *cursor) {
+
+    const XmlPath *path = cursor->path;
+
+    for ( ;; ) {
+
+        xmlNodePtr next = NULL;
+        int depth = cursor->depth;
+
+        if ( depth < 0 ) {
+            next = xmlDocGetRootElement(cursor->ctx->doc);
+            depth = 0;
+        } else if ( !xml_path_dead(path, cursor->states[depth]) && ( next = xmlFirstElementChild(cursor->node) ) != NULL ) {
+            ++depth;
+        } else {
+            for ( xmlNodePtr node = cursor->node; ( next = xmlNextElementSibling(node) ) == NULL && depth > 0; --depth ) {
+                node = node->parent;
+            }
+        }
+
+        if ( next == NULL ) {
+            return NULL;
+        }
+
+        if ( depth >= cursor->max_depth ) {
+            cursor->max_depth = ( cursor->max_depth == 0 ? 16 : cursor->max_depth * 2 );
+            cursor->states = realloc(cursor->states, cursor->max_depth * sizeof(XmlPathState));
+        }
+
+        const XmlPathState parent = ( depth > 0 ? cursor->states[depth - 1] : xml_path_start(path) );
+
+        cursor->states[depth] = xml_path_step_node(path, parent, next);
+        cursor->depth = depth;
+        cursor->node = next;
+
+        if ( xml_path_matched(path, cursor->states[depth]) ) {
+            return next;
+        }
+    }
+}
+
+static xmlNodePtr __xml_cursor_next(XmlCursor *cursor) {
+
+    if ( cursor->path != NULL && cursor->rest == NULL ) {
+        return __xml_cursor_walk(cursor);
+    }
+
+    for ( ;; ) {
+
+        xmlNodeSetPtr nodes = ( cursor->result != NULL ? cursor->result->nodesetval : NULL );
+
+        if ( nodes != NULL && cursor->index < nodes->nodeNr ) {
+            return nodes->nodeTab[cursor->index++];
+        }
+
+        if ( cursor->rest == NULL ) {
+            return NULL;
+        }
+
+        xmlXPathFreeObject(cursor->result);
+        cursor->result = NULL;
+        cursor->index = 0;
+
+        xmlNodePtr walked = __xml_cursor_walk(cursor);
+
+        if ( walked == NULL ) {
+            return NULL;
+        }
+
+        cursor->result = xml_ctx_xpath_node(cursor->ctx, walked, cursor->rest);
+
+        if ( cursor->result == NULL || cursor->result->type != XPATH_NODESET ) {
+            return NULL;
+        }
+    }
+}
+
+int xml_ctx_xpath_each(XmlCtx *ctx, const char *xpath, XmlCursorFunc func, void *data) {
+    return xml_ctx_xpath_each_opts(ctx, xpath, XML_CURSOR_ORDERED, func, data);
+}
+
+int xml_ctx_xpath_each_opts(XmlCtx *ctx, const char *xpath, int flags, XmlCursorFunc func, void *data) {
+
+    XmlCursor cursor;
+    int cnt = -1;
+
+    if ( __xml_cursor_init(&cursor, ctx, xpath, flags) ) {
+
+        cnt = 0;
+
+        for ( xmlNodePtr node = xml_cursor_next(&cursor); node != NULL; node = xml_cursor_next(&cursor) ) {
+
+            ++cnt;
+
+            if ( func != NULL && !func(node, data) ) {
+                break;
+            }
+        }
+    }
+
+    __xml_cursor_clear(&cursor);
+
+    return cnt;
+}
+
+XmlCursor* xml_ctx_cursor_new(XmlCtx *ctx, const char *xpath, int flags) {
+
+    XmlCursor *cursor = malloc(sizeof(XmlCursor));
+
+    if ( !__xml_cursor_init(cursor, ctx, xpath, flags) ) {
+        xml_cursor_free(&cursor);
+    }
+
+    return cursor;
+}
+
+xmlNodePtr xml_cursor_next(XmlCursor *cursor) {
+
+    if ( cursor == NULL || cursor->done ) {
+        return NULL;
+    }
+
+    xmlNodePtr node = __xml_cursor_next(cursor);
+
+    cursor->done = ( node == NULL );
+
+    return node;
+}
+
+int xml_cursor_fetch(XmlCursor *cursor, int offset, int limit, xmlNodePtr nodes[]) {
+
+    if ( cursor == NULL ) {
+        return 0;
+    }
+
+    /* evaluated node-sets are skipped without iteration */
+    if ( cursor->path == NULL && cursor->result != NULL && cursor->result->nodesetval != NULL ) {
+        const int left = cursor->result->nodesetval->nodeNr - cursor->index;
+        const int skip = ( offset < left ? offset : left );
+        cursor->index += skip;
+        offset -= skip;
+    }
+
+    for ( ; offset > 0 && xml_cursor_next(cursor) != NULL; --offset );
+
+    int cnt = 0;
+
+    for ( xmlNodePtr node = NULL; cnt < limit && ( node = xml_cursor_next(cursor) ) != NULL; ) {
+        nodes[cnt++] = node;
+    }
+
+    return cnt;
+}
+
+void xml_cursor_free(XmlCursor **cursor) {
+
+    if ( cursor != NULL && *cursor != NULL ) {
+        __xml_cursor_clear(*cursor);
+        free(*cursor);
+        *cursor = NULL;
+    }
+}
@@ -0,0 +1,154 @@
+#ifndef XML_CURSOR_H
+#define XML_CURSOR_H
+
+#if 0
+    Iteration of xpath results without a materialized node-set.
+
+    Restricted location paths (see xml_path.h) are matched while the document of the
+    context is walked, subtrees which can not contain a match are skipped and the walk
+    stops with the last requested node. The nodes are in document order.
+
+    Other expressions are evaluated by xml_ctx_xpath and the node-set is iterated. With
+    XML_CURSOR_UNORDERED a location path of a restricted path followed by child,
+    attribute or self steps is split instead, abbreviated like "@value" and "." or
+    with the axes child::, attribute:: and self:::
+
+        //talent[@type = 'base']/@value     walk of //talent[@type = 'base'], then
+                                            @value relative to each talent
+
+    Expressions which are no valid location path, like //talent/count(@value), fail
+    like with xml_ctx_xpath, even though their last part would compile alone.
+
+    The nodes are in document order per walked element, but the complete result is not
+    sorted. Nodes of nested walked elements can be out of document order.
+
+    The document must not be changed while a cursor is used.
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+
+#include "xml_utils.h"
+#include "xml_path.h"
+
+typedef enum {
+    XML_CURSOR_ORDERED = 0,     /* nodes in document order */
+    XML_CURSOR_UNORDERED = 1    /* no final sort of split expressions */
+} XmlCursorFlag;
+
+typedef struct {
+    XmlCtx              *ctx;       /* xml context */
+    XmlPath             *path;      /* walked restricted path or NULL */
+    char                *rest;      /* steps relative to walked elements or NULL */
+    XmlPathState        *states;    /* match state per depth of walk */
+    int                 depth;      /* depth of node, -1 before the walk */
+    int                 max_depth;  /* allocated states */
+    xmlNodePtr          node;       /* current element of walk */
+    xmlXPathObjectPtr   result;     /* nodes of rest or complete expression */
+    int                 index;      /* next node of result */
+    bool                done;       /* no more nodes */
+} XmlCursor;
+
+/*
+    Callback for xml_ctx_xpath_each. Returning false stops the iteration.
+*/
+typedef bool (*XmlCursorFunc)(xmlNodePtr node, void *data);
+
+/*
+
+    This Functions call func with every node of xpath.
+
+    xml_ctx_xpath_each          nodes in document order
+    xml_ctx_xpath_each_opts     like xml_ctx_xpath_each with XmlCursorFlag
+
+    Example:
+        static bool print_name(xmlNodePtr node, void *data) {
+            xmlChar *name = xmlGetProp(node, (const xmlChar *)"name");
+            printf("%s\n", name);
+            xmlFree(name);
+            return true;
+        }
+
+        int cnt = xml_ctx_xpath_each(ctx, "//talent[@type = 'base']", print_name, NULL);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context
+    xpath           xpath with node-set result
+    flags           combination of XmlCursorFlag
+    func            callback of nodes
+    data            user data passed to func
+
+    returns number of nodes passed to func, -1 if xpath is invalid or no node-set
+*/
+int xml_ctx_xpath_each(XmlCtx *ctx, const char *xpath, XmlCursorFunc func, void *data);
+int xml_ctx_xpath_each_opts(XmlCtx *ctx, const char *xpath, int flags, XmlCursorFunc func, void *data);
+
+/*
+
+    This Function creates a cursor of the xpath nodes.
+
+    Example:
+        XmlCursor *cursor = xml_ctx_cursor_new(ctx, "//talent", XML_CURSOR_ORDERED);
+        xmlNodePtr page[20];
+
+        int cnt = xml_cursor_fetch(cursor, 40, 20, page);   nodes 40 to 59
+        cnt = xml_cursor_fetch(cursor, 0, 20, page);        nodes 60 to 79
+        ...
+        xml_cursor_free(&cursor);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context
+    xpath           xpath with node-set result
+    flags           combination of XmlCursorFlag
+
+    returns new cursor or NULL if xpath is invalid or no node-set
+*/
+XmlCursor* xml_ctx_cursor_new(XmlCtx *ctx, const char *xpath, int flags);
+
+/*
+
+    This Functions read nodes of the cursor.
+
+    xml_cursor_next     returns the next node or NULL after the last node
+    xml_cursor_fetch    skips offset nodes and writes up to limit following nodes to
+                        nodes, returns the number of written nodes
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    cursor          cursor
+    offset          number of nodes to skip
+    limit           maximum number of nodes to fetch
+    nodes           target of limit nodes
+
+*/
+xmlNodePtr xml_cursor_next(XmlCursor *cursor);
+int xml_cursor_fetch(XmlCursor *cursor, int offset, int limit, xmlNodePtr nodes[]);
+
+/*
+
+    This Function frees the cursor. The pointer will be NULL.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    cursor          pointer to cursor pointer
+
+*/
+void xml_cursor_free(XmlCursor **cursor);
+
+#endif
@@ -0,0 +1,488 @@
+#include "xml_frozen.h"
+
+#define XML_FROZEN_MAGIC "XFRZ"
+
+typedef struct {
+    XmlFrozenNode       *nodes;     /* nodes in preorder */
+    uint32_t            node_cnt;   /* number of nodes */
+    uint32_t            node_max;   /* allocated nodes */
+    XmlFrozenAttr       *attrs;     /* attributes */
+    uint32_t            attr_cnt;   /* number of attributes */
+    uint32_t            attr_max;   /* allocated attributes */
+    xmlHashTablePtr     name_ids;   /* name => name id + 1 */
+    uint32_t            *names;     /* string offsets of names */
+    uint32_t            name_cnt;   /* number of names */
+    uint32_t            name_max;   /* allocated names */
+    xmlHashTablePtr     offsets;    /* string => string offset + 1 */
+    char                *strings;   /* string data */
+    uint32_t            string_size;/* used bytes of string data */
+    uint32_t            string_max; /* allocated bytes of string data */
+} XmlFrozenBuilder;
+
+typedef struct {
+    const XmlFrozen *frozen;    /* frozen document */
+    int32_t         node;       /* current node */
+} XmlFrozenElement;
+
+typedef struct {
+    const XmlFrozen *frozen;    /* frozen document */
+    const XmlPath   *path;      /* evaluated path */
+    XmlFrozenNodes  *result;    /* target of matched nodes or NULL if only counted */
+    int             cnt;        /* number of matched nodes */
+    int             limit;      /* stop after limit matched nodes, 0 for all */
+} XmlFrozenWalk;
+
+/* ---------------------------------------------------------------------------------------
+    freeze
+   --------------------------------------------------------------------------------------- */
+
+static uint32_t __xml_frozen_string(XmlFrozenBuilder *builder, const xmlChar *str) {
+
+    const uintptr_t found = (uintptr_t)xmlHashLookup(builder->offsets, str);
+
+    if ( found != 0 ) {
+        return (uint32_t)(found - 1);
+    }
+
+    const uint32_t len = (uint32_t)xmlStrlen(str) + 1;
+
+    if ( builder->string_size + len > builder->string_max ) {
+        builder->string_max = ( builder->string_max == 0 ? 4096 : builder->string_max );
+        while ( builder->string_size + len > builder->string_max ) builder->string_max *= 2;
+        builder->strings = realloc(builder->strings, builder->string_max);
+    }
+
+    const uint32_t offset = builder->string_size;
+
+    memcpy(&builder->strings[offset], str, len);
+    builder->string_size += len;
+
+    xmlHashAddEntry(builder->offsets, str, (void *)(uintptr_t)(offset + 1));
+
+    return offset;
+}
+
+static uint32_t __xml_frozen_name(XmlFrozenBuilder *builder, const xmlChar *name) {
+
+    const uintptr_t found = (uintptr_t)xmlHashLookup(builder->name_ids, name);
+
+    if ( found != 0 ) {
+        return (uint32_t)(found - 1);
+    }
+
+    if ( builder->name_cnt == builder->name_max ) {
+        builder->name_max = ( builder->name_max == 0 ? 64 : builder->name_max * 2 );
+        builder->names = realloc(builder->names, builder->name_max * sizeof(uint32_t));
+    }
+
+    builder->names[builder->name_cnt] = __xml_frozen_string(builder, name);
+
+    xmlHashAddEntry(builder->name_ids, name, (void *)(uintptr_t)(builder->name_cnt + 1));
+
+    return builder->name_cnt++;
+}
+
+/* adds element node and its subtree, returns index of node */
+static int32_t __xml_frozen_add(XmlFrozenBuilder *builder, xmlNodePtr node, int32_t parent) {
+
+    if ( builder->node_cnt == builder->node_max ) {
+        builder->node_max = ( builder->node_max == 0 ? 256 : builder->node_max * 2 );
+        builder->nodes = realloc(builder->nodes, builder->node_max * sizeof(XmlFrozenNode));
+    }
+
+    const int32_t index = (int32_t)builder->node_cnt++;
+    XmlFrozenNode frozen = { parent, -1, -1, __xml_frozen_name(builder, node->name), builder->attr_cnt, 0, XML_FROZEN_NONE };
+
+    for ( xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next ) {
+
+        if ( builder->attr_cnt == builder->attr_max ) {
+            builder->attr_max = ( builder->attr_max == 0 ? 256 : builder->attr_max * 2 );
+            builder->attrs = realloc(builder->attrs, builder->attr_max * sizeof(XmlFrozenAttr));
+        }
+
+        xmlChar *value = xmlNodeListGetString(node->doc, attr->children, 1);
+
+        builder->attrs[builder->attr_cnt].name = __xml_frozen_name(builder, attr->name);
+        builder->attrs[builder->attr_cnt].value = __xml_frozen_string(builder, ( value != NULL ? value : (const xmlChar *)"" ));
+        ++builder->attr_cnt;
+        ++frozen.attr_cnt;
+
+        xmlFree(value);
+    }
+
+    xmlChar *text = NULL;
+
+    for ( xmlNodePtr child = node->children; child != NULL; child = child->next ) {
+        if ( (child->type == XML_TEXT_NODE || child->type == XML_CDATA_SECTION_NODE) && !xmlIsBlankNode(child) ) {
+            text = xmlStrcat(text, child->content);
+        }
+    }
+
+    if ( text != NULL ) {
+        frozen.text = __xml_frozen_string(builder, text);
+        xmlFree(text);
+    }
+
+    builder->nodes[index] = frozen;
+
+    int32_t prev = -1;
+
+    for ( xmlNodePtr child = node->children; child != NULL; child = child->next ) {
+
+        if ( child->type != XML_ELEMENT_NODE ) {
+            continue;
+        }
+
+        const int32_t added = __xml_frozen_add(builder, child, index);
+
+        if ( prev == -1 ) {
+            builder->nodes[index].first_child = added;
+        } else {
+            builder->nodes[prev].next_sibling = added;
+        }
+
+        prev = added;
+    }
+
+    return index;
+}
+
+/* sets section pointers of block, returns false if the block is invalid */
+static bool __xml_frozen_init(XmlFrozen *frozen, const unsigned char *data, size_t size) {
+
+    const XmlFrozenHeader *header = (const XmlFrozenHeader *)data;
+
+    if ( data == NULL || ((uintptr_t)data % 4) != 0 || size < sizeof(XmlFrozenHeader) ||
+         memcmp(header->magic, XML_FROZEN_MAGIC, 4) != 0 || header->version != XML_FROZEN_VERSION ||
+         header->node_cnt == 0 || header->node_cnt > INT32_MAX || header->string_size == 0 ) {
+        return false;
+    }
+
+    const uint64_t expected = (uint64_t)sizeof(XmlFrozenHeader) +
+                              (uint64_t)header->node_cnt * sizeof(XmlFrozenNode) +
+                              (uint64_t)header->attr_cnt * sizeof(XmlFrozenAttr) +
+                              (uint64_t)header->name_cnt * sizeof(uint32_t) +
+                              (uint64_t)header->string_size;
+
+    if ( expected != size ) {
+        return false;
+    }
+
+    frozen->header = header;
+    frozen->nodes = (const XmlFrozenNode *)(data + sizeof(XmlFrozenHeader));
+    frozen->attrs = (const XmlFrozenAttr *)(frozen->nodes + header->node_cnt);
+    frozen->names = (const uint32_t *)(frozen->attrs + header->attr_cnt);
+    frozen->strings = (const char *)(frozen->names + header->name_cnt);
+    frozen->size = size;
+
+    if ( frozen->strings[header->string_size - 1] != '\0' ) {
+        return false;
+    }
+
+    for ( uint32_t curname = 0; curname < header->name_cnt; ++curname ) {
+        if ( frozen->names[curname] >= header->string_size ) return false;
+    }
+
+    for ( uint32_t curattr = 0; curattr < header->attr_cnt; ++curattr ) {
+        const XmlFrozenAttr *attr = &frozen->attrs[curattr];
+        if ( attr->name >= header->name_cnt || attr->value >= header->string_size ) return false;
+    }
+
+    /* links only point forward, so every walk ends */
+    const int32_t node_cnt = (int32_t)header->node_cnt;
+
+    for ( int32_t curnode = 0; curnode < node_cnt; ++curnode ) {
+
+        const XmlFrozenNode *node = &frozen->nodes[curnode];
+
+        if ( node->parent < -1 || node->parent >= curnode ||
+             (node->first_child != -1 && (node->first_child <= curnode || node->first_child >= node_cnt)) ||
+             (node->next_sibling != -1 && (node->next_sibling <= curnode || node->next_sibling >= node_cnt)) ||
+             node->name >= header->name_cnt ||
+             (uint64_t)node->attr_start + node->attr_cnt > header->attr_cnt ||
+             (node->text != XML_FROZEN_NONE && node->text >= header->string_size) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+XmlFrozen* xml_ctx_freeze(const XmlCtx *ctx) {
+
+    xmlNodePtr root = ( ctx != NULL && ctx->doc != NULL ? xmlDocGetRootElement(ctx->doc) : NULL );
+
+    if ( root == NULL ) {
+        return NULL;
+    }
+
+    XmlFrozenBuilder builder;
+    memset(&builder, 0, sizeof(XmlFrozenBuilder));
+    builder.name_ids = xmlHashCreate(64);
+    builder.offsets = xmlHashCreate(1024);
+
+    __xml_frozen_add(&builder, root, -1);
+
+    const XmlFrozenHeader header = { { 'X', 'F', 'R', 'Z' }, XML_FROZEN_VERSION, builder.node_cnt, builder.attr_cnt,
+                                     builder.name_cnt, builder.string_size };
+
+    const size_t size = sizeof(XmlFrozenHeader) + builder.node_cnt * sizeof(XmlFrozenNode) +
+                        builder.attr_cnt * sizeof(XmlFrozenAttr) + builder.name_cnt * sizeof(uint32_t) +
+                        builder.string_size;
+
+    unsigned char *data = malloc(size);
+    unsigned char *cur = data;
+
+    memcpy(cur, &header, sizeof(XmlFrozenHeader));
+    cur += sizeof(XmlFrozenHeader);
+    memcpy(cur, builder.nodes, builder.node_cnt * sizeof(XmlFrozenNode));
+    cur += builder.node_cnt * sizeof(XmlFrozenNode);
+    if ( builder.attr_cnt > 0 ) memcpy(cur, builder.attrs, builder.attr_cnt * sizeof(XmlFrozenAttr));
+    cur += builder.attr_cnt * sizeof(XmlFrozenAttr);
+    memcpy(cur, builder.names, builder.name_cnt * sizeof(uint32_t));
+    cur += builder.name_cnt * sizeof(uint32_t);
+    memcpy(cur, builder.strings, builder.string_size);
+
+    xmlHashFree(builder.name_ids, NULL);
+    xmlHashFree(builder.offsets, NULL);
+    free(builder.nodes);
+    free(builder.attrs);
+    free(builder.names);
+    free(builder.strings);
+
+    XmlFrozen *frozen = malloc(sizeof(XmlFrozen));
+    memset(frozen, 0, sizeof(XmlFrozen));
+
+    __xml_frozen_init(frozen, data, size);
+    frozen->owned = data;
+
+    return frozen;
+}
+
+/* ---------------------------------------------------------------------------------------
+    store and load
+   --------------------------------------------------------------------------------------- */
+
+int xml_frozen_save(const XmlFrozen *frozen, const char *filename) {
+
+    if ( frozen == NULL || filename == NULL ) {
+        return -1;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    int result = -1;
+
+    if ( file != NULL ) {
+        result = ( fwrite(frozen->header, 1, frozen->size, file) == frozen->size ? 0 : -1 );
+        result = ( fclose(file) == 0 ? result : -1 );
+    }
+
+    return result;
+}
+
+XmlFrozen* xml_frozen_from_memory(const unsigned char *data, size_t size) {
+
+    XmlFrozen *frozen = malloc(sizeof(XmlFrozen));
+    memset(frozen, 0, sizeof(XmlFrozen));
+
+    if ( !__xml_frozen_init(frozen, data, size) ) {
+        free(frozen);
+        frozen = NULL;
+    }
+
+    return frozen;
+}
+
+XmlFrozen* xml_frozen_map(const char *filename) {
+
+    XmlSource *mapped = xml_source_from_file_mapped(filename);
+
+    if ( mapped == NULL ) {
+        return NULL;
+    }
+
+    XmlFrozen *frozen = xml_frozen_from_memory(mapped->src_data, *mapped->src_size);
+
+    if ( frozen != NULL ) {
+        frozen->mapped = mapped;
+    } else {
+        xml_source_free(&mapped);
+    }
+
+    return frozen;
+}
+
+void xml_frozen_free(XmlFrozen **frozen) {
+
+    if ( frozen != NULL && *frozen != NULL ) {
+
+        XmlFrozen *to_delete = *frozen;
+
+        xml_source_free(&to_delete->mapped);
+        free(to_delete->owned);
+        free(to_delete);
+
+        *frozen = NULL;
+    }
+}
+
+/* ---------------------------------------------------------------------------------------
+    access
+   --------------------------------------------------------------------------------------- */
+
+static bool __xml_frozen_valid_node(const XmlFrozen *frozen, int32_t node) {
+    return frozen != NULL && node >= 0 && (uint32_t)node < frozen->header->node_cnt;
+}
+
+const char* xml_frozen_name(const XmlFrozen *frozen, int32_t node) {
+
+    if ( !__xml_frozen_valid_node(frozen, node) ) {
+        return NULL;
+    }
+
+    return &frozen->strings[frozen->names[frozen->nodes[node].name]];
+}
+
+const char* xml_frozen_attr(const XmlFrozen *frozen, int32_t node, const char *name) {
+
+    if ( !__xml_frozen_valid_node(frozen, node) || name == NULL ) {
+        return NULL;
+    }
+
+    const XmlFrozenNode *cur = &frozen->nodes[node];
+    const XmlFrozenAttr *attr = &frozen->attrs[cur->attr_start];
+
+    for ( uint32_t curattr = 0; curattr < cur->attr_cnt; ++curattr, ++attr ) {
+        if ( strcmp(&frozen->strings[frozen->names[attr->name]], name) == 0 ) {
+            return &frozen->strings[attr->value];
+        }
+    }
+
+    return NULL;
+}
+
+const char* xml_frozen_text(const XmlFrozen *frozen, int32_t node) {
+
+    if ( !__xml_frozen_valid_node(frozen, node) || frozen->nodes[node].text == XML_FROZEN_NONE ) {
+        return NULL;
+    }
+
+    return &frozen->strings[frozen->nodes[node].text];
+}
+
+/* ---------------------------------------------------------------------------------------
+    evaluation
+   --------------------------------------------------------------------------------------- */
+
+static const xmlChar * __xml_frozen_path_attr(void *element, const xmlChar *name) {
+
+    XmlFrozenElement *cur = element;
+
+    return (const xmlChar *)xml_frozen_attr(cur->frozen, cur->node, (const char *)name);
+}
+
+/* walks siblings starting with node and their subtrees, returns false if the limit was reached */
+static bool __xml_frozen_walk(XmlFrozenWalk *walk, XmlPathState parent, int32_t node) {
+
+    const XmlFrozen *frozen = walk->frozen;
+
+    for ( ; node != -1; node = frozen->nodes[node].next_sibling ) {
+
+        XmlFrozenElement element = { frozen, node };
+        const xmlChar *name = (const xmlChar *)&frozen->strings[frozen->names[frozen->nodes[node].name]];
+
+        const XmlPathState state = xml_path_step(walk->path, parent, name, __xml_frozen_path_attr, &element);
+
+        if ( xml_path_matched(walk->path, state) ) {
+
+            XmlFrozenNodes *result = walk->result;
+
+            if ( result != NULL ) {
+
+                if ( result->cnt == result->max ) {
+                    result->max = ( result->max == 0 ? 16 : result->max * 2 );
+                    result->nodes = realloc(result->nodes, result->max * sizeof(int32_t));
+                }
+
+                result->nodes[result->cnt++] = node;
+            }
+
+            if ( ++walk->cnt == walk->limit ) {
+                return false;
+            }
+        }
+
+        if ( !xml_path_dead(walk->path, state) && !__xml_frozen_walk(walk, state, frozen->nodes[node].first_child) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* evaluates expr with optional limit of matches, returns number of matches or -1 */
+static int __xml_frozen_eval(const XmlFrozen *frozen, const char *expr, XmlFrozenNodes *result, int limit) {
+
+    XmlPath *path = ( frozen != NULL ? xml_path_new(expr) : NULL );
+
+    if ( path == NULL ) {
+        return -1;
+    }
+
+    XmlFrozenWalk walk = { frozen, path, result, 0, limit };
+
+    __xml_frozen_walk(&walk, xml_path_start(path), 0);
+
+    xml_path_free(&path);
+
+    return walk.cnt;
+}
+
+int xml_frozen_select(const XmlFrozen *frozen, const char *expr, XmlFrozenNodes *result) {
+
+    if ( result == NULL ) {
+        return -1;
+    }
+
+    memset(result, 0, sizeof(XmlFrozenNodes));
+
+    return ( __xml_frozen_eval(frozen, expr, result, 0) < 0 ? -1 : 0 );
+}
+
+int xml_frozen_count(const XmlFrozen *frozen, const char *expr) {
+    return __xml_frozen_eval(frozen, expr, NULL, 0);
+}
+
+const char* xml_frozen_value(const XmlFrozen *frozen, const char *expr) {
+
+    const char *sep = ( expr != NULL ? strrchr(expr, '/') : NULL );
+
+    if ( sep == NULL || sep == expr || sep[-1] == '/' || ( sep[1] != '@' && strcmp(sep, "/text()") != 0 ) ||
+         strpbrk(sep, "[]'\"") != NULL ) {
+        return NULL;
+    }
+
+    char *element_expr = malloc(sep - expr + 1);
+    memcpy(element_expr, expr, sep - expr);
+    element_expr[sep - expr] = '\0';
+
+    XmlFrozenNodes first = { NULL, 0, 0 };
+    const char *result = NULL;
+
+    if ( __xml_frozen_eval(frozen, element_expr, &first, 1) > 0 ) {
+        result = ( sep[1] == '@' ? xml_frozen_attr(frozen, first.nodes[0], &sep[2]) : xml_frozen_text(frozen, first.nodes[0]) );
+    }
+
+    xml_frozen_nodes_free(&first);
+    free(element_expr);
+
+    return result;
+}
+
+void xml_frozen_nodes_free(XmlFrozenNodes *nodes) {
+
+    if ( nodes != NULL ) {
+        free(nodes->nodes);
+        memset(nodes, 0, sizeof(XmlFrozenNodes));
+    }
+}
@@ -0,0 +1,190 @@
+#ifndef XML_FROZEN_H
+#define XML_FROZEN_H
+
+#if 0
+    Frozen, read only documents.
+
+    Freezing converts the elements of a context document into one contiguous block:
+
+        header      "XFRZ", format version, section sizes
+        nodes       elements in document order (preorder), linked by indexes
+        attrs       attributes, the attributes of one element are one span
+        names       string offsets of element and attribute names, the name ids
+        strings     terminated names and values, each distinct string once
+
+    The block contains no pointers, so it can be written to a file once and mapped
+    read only by every process (xml_frozen_map). The numbers are in native byte order.
+
+    Lookups use restricted location paths (see xml_path.h), optionally followed by
+    /@name for attribute values or /text() for the text of elements:
+
+        /breeds/group/breed[@name = 'Die Tulamiden']
+        //talent[@name = 'Dolche']/@value
+
+    Comments, processing instructions and namespaces are dropped. The text of an
+    element is the concatenated text of its direct, not blank text children.
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <libxml/tree.h>
+#include <libxml/hash.h>
+
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_path.h"
+
+#define XML_FROZEN_VERSION 1        /* format version */
+#define XML_FROZEN_NONE UINT32_MAX  /* missing string or node */
+
+typedef struct {
+    char        magic[4];       /* "XFRZ" */
+    uint32_t    version;        /* XML_FROZEN_VERSION */
+    uint32_t    node_cnt;       /* number of nodes */
+    uint32_t    attr_cnt;       /* number of attributes */
+    uint32_t    name_cnt;       /* number of names */
+    uint32_t    string_size;    /* bytes of strings */
+} XmlFrozenHeader;
+
+typedef struct {
+    int32_t     parent;         /* index of parent element, -1 for the root element */
+    int32_t     first_child;    /* index of first child element or -1 */
+    int32_t     next_sibling;   /* index of next sibling element or -1 */
+    uint32_t    name;           /* name id */
+    uint32_t    attr_start;     /* index of first attribute */
+    uint32_t    attr_cnt;       /* number of attributes */
+    uint32_t    text;           /* string offset of text or XML_FROZEN_NONE */
+} XmlFrozenNode;
+
+typedef struct {
+    uint32_t    name;           /* name id */
+    uint32_t    value;          /* string offset of value */
+} XmlFrozenAttr;
+
+typedef struct {
+    const XmlFrozenHeader   *header;    /* start of block */
+    const XmlFrozenNode     *nodes;     /* nodes, root element at index 0 */
+    const XmlFrozenAttr     *attrs;     /* attributes */
+    const uint32_t          *names;     /* string offsets of names */
+    const char              *strings;   /* string data */
+    size_t                  size;       /* size of block */
+    unsigned char           *owned;     /* block allocated by xml_ctx_freeze or NULL */
+    XmlSource               *mapped;    /* mapped file of xml_frozen_map or NULL */
+} XmlFrozen;
+
+typedef struct {
+    int32_t     *nodes;         /* matched node indexes in document order */
+    int         cnt;            /* number of nodes */
+    int         max;            /* allocated slots */
+} XmlFrozenNodes;
+
+/*
+
+    This Function freezes the document of the context. The context is not changed and
+    not referenced by the result.
+
+    Example:
+        XmlFrozen *breeds = xml_ctx_freeze(ctx);
+        const char *value = xml_frozen_value(breeds, "//breed[@name = 'Die Tulamiden']/gp/@value");
+        ...
+        xml_frozen_free(&breeds);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context
+
+    returns new frozen document or NULL if ctx has no document
+*/
+XmlFrozen* xml_ctx_freeze(const XmlCtx *ctx);
+
+/*
+
+    This Functions store and load frozen documents.
+
+    xml_frozen_save         writes the block to filename
+    xml_frozen_map          maps the file read only, the block is shared with other
+                            processes mapping the same file
+    xml_frozen_from_memory  uses a block of memory, which has to be valid and 4 byte
+                            aligned until the frozen document was freed
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    frozen          frozen document
+    filename        name of file
+    data            block data
+    size            size of block
+
+    returns 0 on success or -1, new frozen document or NULL if the block is invalid
+*/
+int xml_frozen_save(const XmlFrozen *frozen, const char *filename);
+XmlFrozen* xml_frozen_map(const char *filename);
+XmlFrozen* xml_frozen_from_memory(const unsigned char *data, size_t size);
+
+/*
+
+    This Function frees the frozen document and unmaps its file. The pointer will be NULL.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    frozen          pointer to frozen document
+
+*/
+void xml_frozen_free(XmlFrozen **frozen);
+
+/*
+
+    This Functions access single nodes. The strings are part of the block.
+
+    xml_frozen_name     returns the name of node
+    xml_frozen_attr     returns the value of attribute name of node or NULL
+    xml_frozen_text     returns the text of node or NULL
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    frozen          frozen document
+    node            node index
+    name            attribute name
+
+*/
+const char* xml_frozen_name(const XmlFrozen *frozen, int32_t node);
+const char* xml_frozen_attr(const XmlFrozen *frozen, int32_t node, const char *name);
+const char* xml_frozen_text(const XmlFrozen *frozen, int32_t node);
+
+/*
+
+    This Functions evaluate location paths.
+
+    xml_frozen_select       collects all matched nodes, free result with xml_frozen_nodes_free
+    xml_frozen_count        returns the number of matched nodes or -1 on invalid path
+    xml_frozen_value        returns the attribute value or text of the first matched node
+                            or NULL, the path has to end with /@name or /text()
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    frozen          frozen document
+    expr            location path
+    result          target of matched nodes, initialized in every case
+    nodes           nodes to free
+
+    returns 0 on success or -1 on invalid path
+*/
+int xml_frozen_select(const XmlFrozen *frozen, const char *expr, XmlFrozenNodes *result);
+int xml_frozen_count(const XmlFrozen *frozen, const char *expr);
+const char* xml_frozen_value(const XmlFrozen *frozen, const char *expr);
+void xml_frozen_nodes_free(XmlFrozenNodes *nodes);
+
+#endif
@@ -0,0 +1,650 @@
+#include "xml_index.h"
+
+static void __xml_index_nodes_free(void *payload, const xmlChar *name) {
+    (void)(name);
+
+    XmlIndexNodes *bucket = payload;
+
+    free(bucket->nodes);
+    free(bucket);
+}
+
+static void __xml_index_add(XmlIndex *index, const xmlChar *value, xmlNodePtr node) {
+
+    XmlIndexNodes *bucket = xmlHashLookup(index->values, value);
+
+    if ( bucket == NULL ) {
+        bucket = malloc(sizeof(XmlIndexNodes));
+        bucket->nodes = NULL;
+        bucket->cnt = 0;
+        bucket->max = 0;
+        xmlHashAddEntry(index->values, value, bucket);
+    }
+
+    if ( bucket->cnt == bucket->max ) {
+        bucket->max = ( bucket->max == 0 ? 2 : bucket->max * 2 );
+        bucket->nodes = realloc(bucket->nodes, bucket->max * sizeof(xmlNodePtr));
+    }
+
+    bucket->nodes[bucket->cnt++] = node;
+}
+
+/* like xpath, a name matches elements without namespace only, "*" matches all elements */
+static bool __xml_index_element(const xmlChar *element, xmlNodePtr node) {
+    return ( xmlStrEqual(element, (const xmlChar *)"*") || ( node->ns == NULL && xmlStrEqual(node->name, element) ) );
+}
+
+/* attribute of node without namespace and without looking at DTD defaults */
+static xmlAttrPtr __xml_index_prop(xmlNodePtr node, const xmlChar *name) {
+
+    xmlAttrPtr attr = node->properties;
+
+    while ( attr != NULL && ( attr->ns != NULL || !xmlStrEqual(attr->name, name) ) ) {
+        attr = attr->next;
+    }
+
+    return attr;
+}
+
+static void __xml_index_add_attr(XmlIndex *index, xmlNodePtr node, xmlAttrPtr attr) {
+
+    xmlNodePtr text = attr->children;
+
+    if ( text == NULL ) {
+        __xml_index_add(index, (const xmlChar *)"", node);
+    } else if ( text->next == NULL && text->type == XML_TEXT_NODE ) {
+        __xml_index_add(index, text->content, node);
+    } else {
+        xmlChar *value = xmlNodeListGetString(node->doc, text, 1);
+        __xml_index_add(index, value, node);
+        xmlFree(value);
+    }
+}
+
+static void __xml_index_build(XmlIndex *index, XmlCtx *ctx) {
+
+    xmlHashFree(index->values, __xml_index_nodes_free);
+    index->values = xmlHashCreate(64);
+    index->version = ctx->version;
+
+    xmlNodePtr root = ( ctx->doc != NULL ? xmlDocGetRootElement(ctx->doc) : NULL );
+    xmlNodePtr cur = root;
+
+    while ( cur != NULL ) {
+
+        if ( cur->type == XML_ELEMENT_NODE ) {
+
+            if ( __xml_index_element(index->element, cur) ) {
+                xmlAttrPtr attr = __xml_index_prop(cur, index->attr);
+
+                if ( attr != NULL ) {
+                    __xml_index_add_attr(index, cur, attr);
+                }
+            }
+
+            if ( cur->children != NULL ) {
+                cur = cur->children;
+                continue;
+            }
+        }
+
+        while ( cur != root && cur->next == NULL ) {
+            cur = cur->parent;
+        }
+
+        cur = ( cur != root ? cur->next : NULL );
+    }
+}
+
+static void __xml_index_free(XmlIndex *index) {
+    xmlHashFree(index->values, __xml_index_nodes_free);
+    xmlFree(index->name);
+    xmlFree(index->element);
+    xmlFree(index->attr);
+    free(index);
+}
+
+static void __xml_numindex_free(XmlNumIndex *index) {
+    free(index->entries);
+    xmlFree(index->name);
+    xmlFree(index->element);
+    xmlFree(index->attr);
+    free(index);
+}
+
+/* index with given name, rebuild if the document has changed since last build */
+static XmlIndex * __xml_index_get(XmlCtx *ctx, const xmlChar *name) {
+
+    XmlIndex *index = ctx->indexes;
+
+    while ( index != NULL && !xmlStrEqual(index->name, name) ) {
+        index = index->next;
+    }
+
+    if ( index != NULL && index->version != ctx->version ) {
+        __xml_index_build(index, ctx);
+    }
+
+    return index;
+}
+
+int xml_ctx_index_create(XmlCtx *ctx, const char *name, const char *element, const char *attr) {
+
+    if ( ctx == NULL || name == NULL || element == NULL || attr == NULL ) {
+        return -1;
+    }
+
+    xml_ctx_index_free(ctx, name);
+
+    XmlIndex *index = malloc(sizeof(XmlIndex));
+    index->name = xmlStrdup((const xmlChar *)name);
+    index->element = xmlStrdup((const xmlChar *)element);
+    index->attr = xmlStrdup((const xmlChar *)attr);
+    index->values = NULL;
+    index->next = ctx->indexes;
+
+    __xml_index_build(index, ctx);
+
+    ctx->indexes = index;
+
+    return 0;
+}
+
+int xml_ctx_index_lookup(XmlCtx *ctx, const char *name, const char *value, xmlNodePtr **nodes) {
+
+    XmlIndexNodes *bucket = NULL;
+
+    if ( ctx != NULL && name != NULL && value != NULL ) {
+
+        XmlIndex *index = __xml_index_get(ctx, (const xmlChar *)name);
+
+        if ( index != NULL ) {
+            bucket = xmlHashLookup(index->values, (const xmlChar *)value);
+        }
+    }
+
+    if ( nodes != NULL ) {
+        *nodes = ( bucket != NULL ? bucket->nodes : NULL );
+    }
+
+    return ( bucket != NULL ? bucket->cnt : 0 );
+}
+
+void xml_ctx_index_free(XmlCtx *ctx, const char *name) {
+
+    if ( ctx != NULL && name != NULL ) {
+
+        XmlIndex **link = &ctx->indexes;
+
+        while ( *link != NULL ) {
+
+            XmlIndex *index = *link;
+
+            if ( xmlStrEqual(index->name, (const xmlChar *)name) ) {
+                *link = index->next;
+                __xml_index_free(index);
+                break;
+            }
+
+            link = &index->next;
+        }
+    }
+}
+
+void xml_ctx_index_free_all(XmlCtx *ctx) {
+
+    if ( ctx != NULL ) {
+
+        XmlIndex *index = ctx->indexes;
+
+        while ( index != NULL ) {
+            XmlIndex *next = index->next;
+            __xml_index_free(index);
+            index = next;
+        }
+
+        ctx->indexes = NULL;
+
+        XmlNumIndex *num_index = ctx->num_indexes;
+
+        while ( num_index != NULL ) {
+            XmlNumIndex *next = num_index->next;
+            __xml_numindex_free(num_index);
+            num_index = next;
+        }
+
+        ctx->num_indexes = NULL;
+    }
+}
+
+/* removes node of bucket with value, empty buckets are removed */
+static void __xml_index_remove(XmlIndex *index, const xmlChar *value, xmlNodePtr node) {
+
+    XmlIndexNodes *bucket = xmlHashLookup(index->values, value);
+
+    if ( bucket != NULL ) {
+
+        for ( int cur = 0; cur < bucket->cnt; ++cur ) {
+
+            if ( bucket->nodes[cur] == node ) {
+                memmove(&bucket->nodes[cur], &bucket->nodes[cur + 1], (bucket->cnt - cur - 1) * sizeof(xmlNodePtr));
+                --bucket->cnt;
+                break;
+            }
+        }
+
+        if ( bucket->cnt == 0 ) {
+            xmlHashRemoveEntry(index->values, value, __xml_index_nodes_free);
+        }
+    }
+}
+
+/* adds node to bucket with value at its document order position */
+static void __xml_index_insert(XmlIndex *index, const xmlChar *value, xmlNodePtr node) {
+
+    __xml_index_add(index, value, node);
+
+    XmlIndexNodes *bucket = xmlHashLookup(index->values, value);
+
+    int lo = 0, hi = bucket->cnt - 1;
+
+    /* first node behind node, xmlXPathCmpNodes is 1 if first argument is before second */
+    while ( lo < hi ) {
+        const int mid = lo + (hi - lo) / 2;
+
+        if ( xmlXPathCmpNodes(node, bucket->nodes[mid]) == 1 ) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    memmove(&bucket->nodes[lo + 1], &bucket->nodes[lo], (bucket->cnt - lo - 1) * sizeof(xmlNodePtr));
+    bucket->nodes[lo] = node;
+}
+
+/* ---------------------------------------------------------------------------------------
+    numeric index
+   --------------------------------------------------------------------------------------- */
+
+static int __xml_numindex_cmp(const void *a, const void *b) {
+    const double va = ((const XmlNumIndexEntry *)a)->value;
+    const double vb = ((const XmlNumIndexEntry *)b)->value;
+    return ( va < vb ? -1 : ( va > vb ? 1 : 0 ) );
+}
+
+/* first entry with value >= value */
+static int __xml_numindex_lower(XmlNumIndex *index, double value) {
+
+    int lo = 0, hi = index->cnt;
+
+    while ( lo < hi ) {
+        const int mid = lo + (hi - lo) / 2;
+
+        if ( index->entries[mid].value < value ) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/* first entry with value > value */
+static int __xml_numindex_upper(XmlNumIndex *index, double value) {
+
+    int lo = 0, hi = index->cnt;
+
+    while ( lo < hi ) {
+        const int mid = lo + (hi - lo) / 2;
+
+        if ( index->entries[mid].value <= value ) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static void __xml_numindex_append(XmlNumIndex *index, double value, xmlNodePtr node) {
+
+    if ( index->cnt == index->max ) {
+        index->max = ( index->max == 0 ? 16 : index->max * 2 );
+        index->entries = realloc(index->entries, index->max * sizeof(XmlNumIndexEntry));
+    }
+
+    index->entries[index->cnt].value = value;
+    index->entries[index->cnt].node = node;
+    ++index->cnt;
+}
+
+static void __xml_numindex_build(XmlNumIndex *index, XmlCtx *ctx) {
+
+    index->cnt = 0;
+    index->version = ctx->version;
+
+    xmlNodePtr root = ( ctx->doc != NULL ? xmlDocGetRootElement(ctx->doc) : NULL );
+    xmlNodePtr cur = root;
+
+    while ( cur != NULL ) {
+
+        if ( cur->type == XML_ELEMENT_NODE ) {
+
+            if ( __xml_index_element(index->element, cur) ) {
+                xmlAttrPtr attr = __xml_index_prop(cur, index->attr);
+
+                if ( attr != NULL ) {
+                    const double value = xpath_node_to_number((xmlNodePtr)attr);
+
+                    if ( !isnan(value) ) {
+                        __xml_numindex_append(index, value, cur);
+                    }
+                }
+            }
+
+            if ( cur->children != NULL ) {
+                cur = cur->children;
+                continue;
+            }
+        }
+
+        while ( cur != root && cur->next == NULL ) {
+            cur = cur->parent;
+        }
+
+        cur = ( cur != root ? cur->next : NULL );
+    }
+
+    qsort(index->entries, index->cnt, sizeof(XmlNumIndexEntry), __xml_numindex_cmp);
+}
+
+/* numeric index with given name, rebuild if the document has changed since last build */
+static XmlNumIndex * __xml_numindex_get(XmlCtx *ctx, const char *name) {
+
+    XmlNumIndex *index = ( ctx != NULL && name != NULL ? ctx->num_indexes : NULL );
+
+    while ( index != NULL && !xmlStrEqual(index->name, (const xmlChar *)name) ) {
+        index = index->next;
+    }
+
+    if ( index != NULL && index->version != ctx->version ) {
+        __xml_numindex_build(index, ctx);
+    }
+
+    return index;
+}
+
+static void __xml_numindex_remove(XmlNumIndex *index, double value, xmlNodePtr node) {
+
+    for ( int cur = __xml_numindex_lower(index, value); cur < index->cnt && index->entries[cur].value == value; ++cur ) {
+
+        if ( index->entries[cur].node == node ) {
+            memmove(&index->entries[cur], &index->entries[cur + 1], (index->cnt - cur - 1) * sizeof(XmlNumIndexEntry));
+            --index->cnt;
+            break;
+        }
+    }
+}
+
+static void __xml_numindex_insert(XmlNumIndex *index, double value, xmlNodePtr node) {
+
+    /* position in the sorted entries, before the array grows by the new entry */
+    const int pos = __xml_numindex_upper(index, value);
+
+    __xml_numindex_append(index, value, node);
+
+    if ( pos < index->cnt - 1 ) {
+        memmove(&index->entries[pos + 1], &index->entries[pos], (index->cnt - pos - 1) * sizeof(XmlNumIndexEntry));
+        index->entries[pos].value = value;
+        index->entries[pos].node = node;
+    }
+}
+
+int xml_ctx_numindex_create(XmlCtx *ctx, const char *name, const char *element, const char *attr) {
+
+    if ( ctx == NULL || name == NULL || element == NULL || attr == NULL ) {
+        return -1;
+    }
+
+    xml_ctx_numindex_free(ctx, name);
+
+    XmlNumIndex *index = malloc(sizeof(XmlNumIndex));
+    index->name = xmlStrdup((const xmlChar *)name);
+    index->element = xmlStrdup((const xmlChar *)element);
+    index->attr = xmlStrdup((const xmlChar *)attr);
+    index->entries = NULL;
+    index->cnt = 0;
+    index->max = 0;
+    index->next = ctx->num_indexes;
+
+    __xml_numindex_build(index, ctx);
+
+    ctx->num_indexes = index;
+
+    return 0;
+}
+
+int xml_ctx_numindex_range(XmlCtx *ctx, const char *name, double min, double max, const XmlNumIndexEntry **entries) {
+
+    XmlNumIndex *index = __xml_numindex_get(ctx, name);
+
+    int first = 0, cnt = 0;
+
+    if ( index != NULL && min <= max ) {
+        first = __xml_numindex_lower(index, min);
+        cnt = __xml_numindex_upper(index, max) - first;
+    }
+
+    if ( entries != NULL ) {
+        *entries = ( cnt > 0 ? &index->entries[first] : NULL );
+    }
+
+    return cnt;
+}
+
+int xml_ctx_numindex_top(XmlCtx *ctx, const char *name, int k, const XmlNumIndexEntry **entries) {
+
+    XmlNumIndex *index = __xml_numindex_get(ctx, name);
+
+    const int cnt = ( index != NULL && k > 0 ? ( k < index->cnt ? k : index->cnt ) : 0 );
+
+    if ( entries != NULL ) {
+        *entries = ( cnt > 0 ? &index->entries[index->cnt - cnt] : NULL );
+    }
+
+    return cnt;
+}
+
+int xml_ctx_numindex_bottom(XmlCtx *ctx, const char *name, int k, const XmlNumIndexEntry **entries) {
+
+    XmlNumIndex *index = __xml_numindex_get(ctx, name);
+
+    const int cnt = ( index != NULL && k > 0 ? ( k < index->cnt ? k : index->cnt ) : 0 );
+
+    if ( entries != NULL ) {
+        *entries = ( cnt > 0 ? index->entries : NULL );
+    }
+
+    return cnt;
+}
+
+bool xml_ctx_numindex_min(XmlCtx *ctx, const char *name, XmlNumIndexEntry *entry) {
+
+    const XmlNumIndexEntry *found;
+
+    if ( xml_ctx_numindex_bottom(ctx, name, 1, &found) == 0 ) {
+        return false;
+    }
+
+    if ( entry != NULL ) {
+        *entry = *found;
+    }
+
+    return true;
+}
+
+bool xml_ctx_numindex_max(XmlCtx *ctx, const char *name, XmlNumIndexEntry *entry) {
+
+    const XmlNumIndexEntry *found;
+
+    if ( xml_ctx_numindex_top(ctx, name, 1, &found) == 0 ) {
+        return false;
+    }
+
+    if ( entry != NULL ) {
+        *entry = *found;
+    }
+
+    return true;
+}
+
+void xml_ctx_numindex_free(XmlCtx *ctx, const char *name) {
+
+    if ( ctx != NULL && name != NULL ) {
+
+        XmlNumIndex **link = &ctx->num_indexes;
+
+        while ( *link != NULL ) {
+
+            XmlNumIndex *index = *link;
+
+            if ( xmlStrEqual(index->name, (const xmlChar *)name) ) {
+                *link = index->next;
+                __xml_numindex_free(index);
+                break;
+            }
+
+            link = &index->next;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------------------
+    index maintenance
+   --------------------------------------------------------------------------------------- */
+
+void xml_ctx_index_attr_changing(XmlCtx *ctx, xmlNodePtr element, const xmlChar *attr, const xmlChar *value) {
+
+    if ( ctx == NULL || element == NULL || element->type != XML_ELEMENT_NODE || attr == NULL ) {
+        return;
+    }
+
+    xmlAttrPtr old = __xml_index_prop(element, attr);
+    xmlChar *old_value = ( old != NULL ? xmlNodeListGetString(element->doc, old->children, 1) : NULL );
+
+    for ( XmlIndex *index = ctx->indexes; index != NULL; index = index->next ) {
+
+        if ( index->version != ctx->version || !xmlStrEqual(index->attr, attr) ) continue;
+
+        if ( !__xml_index_element(index->element, element) ) continue;
+
+        if ( old != NULL ) {
+            __xml_index_remove(index, ( old_value != NULL ? old_value : (const xmlChar *)"" ), element);
+        }
+
+        __xml_index_insert(index, ( value != NULL ? value : (const xmlChar *)"" ), element);
+    }
+
+    for ( XmlNumIndex *index = ctx->num_indexes; index != NULL; index = index->next ) {
+
+        if ( index->version != ctx->version || !xmlStrEqual(index->attr, attr) ) continue;
+
+        if ( !__xml_index_element(index->element, element) ) continue;
+
+        if ( old != NULL ) {
+            const double old_number = xpath_node_to_number((xmlNodePtr)old);
+
+            if ( !isnan(old_number) ) {
+                __xml_numindex_remove(index, old_number, element);
+            }
+        }
+
+        const double new_number = xpath_str_to_number(( value != NULL ? value : (const xmlChar *)"" ));
+
+        if ( !isnan(new_number) ) {
+            __xml_numindex_insert(index, new_number, element);
+        }
+    }
+
+    xmlFree(old_value);
+}
+
+void xml_ctx_index_keep(XmlCtx *ctx, unsigned long version) {
+
+    if ( ctx != NULL ) {
+
+        for ( XmlIndex *index = ctx->indexes; index != NULL; index = index->next ) {
+            if ( index->version == version ) index->version = ctx->version;
+        }
+
+        for ( XmlNumIndex *index = ctx->num_indexes; index != NULL; index = index->next ) {
+            if ( index->version == version ) index->version = ctx->version;
+        }
+    }
+}
+
+void key_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
+
+    if ( nargs != 2 ) {
+        xmlXPathSetArityError(ctxt);
+        return;
+    }
+
+    xmlXPathObjectPtr value = valuePop(ctxt);
+
+    xmlChar *name = xmlXPathPopString(ctxt);
+
+    if ( xmlXPathCheckError(ctxt) || value == NULL || name == NULL ) {
+        xmlXPathFreeObject(value);
+        xmlFree(name);
+        return;
+    }
+
+    XPathFuncCache *cache = ctxt->context->userData;
+    XmlCtx *ctx = ( cache != NULL ? cache->owner : NULL );
+
+    XmlIndex *index = ( ctx != NULL ? __xml_index_get(ctx, name) : NULL );
+
+    xmlNodeSetPtr result = xmlXPathNodeSetCreate(NULL);
+
+    if ( index != NULL ) {
+
+        if ( value->type == XPATH_NODESET || value->type == XPATH_XSLT_TREE ) {
+
+            const int cntNodes = ( value->nodesetval != NULL ? value->nodesetval->nodeNr : 0 );
+
+            for ( int curnode = 0; curnode < cntNodes; ++curnode ) {
+
+                xmlChar *key = xmlXPathCastNodeToString(value->nodesetval->nodeTab[curnode]);
+                XmlIndexNodes *bucket = xmlHashLookup(index->values, key);
+                xmlFree(key);
+
+                for ( int curfound = 0; bucket != NULL && curfound < bucket->cnt; ++curfound ) {
+                    xmlXPathNodeSetAdd(result, bucket->nodes[curfound]);
+                }
+            }
+
+            if ( cntNodes > 1 ) {
+                xmlXPathNodeSetSort(result);
+            }
+
+        } else {
+
+            xmlChar *key = xmlXPathCastToString(value);
+            XmlIndexNodes *bucket = xmlHashLookup(index->values, key);
+            xmlFree(key);
+
+            for ( int curfound = 0; bucket != NULL && curfound < bucket->cnt; ++curfound ) {
+                xmlXPathNodeSetAddUnique(result, bucket->nodes[curfound]);
+            }
+        }
+    }
+
+    xmlXPathFreeObject(value);
+    xmlFree(name);
+
+    xmlXPathReturnNodeSet(ctxt, result);
+}
@@ -0,0 +1,234 @@
+#ifndef XML_INDEX_H
+#define XML_INDEX_H
+
+#if 0
+    Indexes over attribute values of a xml context document.
+
+    Most lookups are like //talent[@name='Dolche'], which libxml answers by walking
+    the whole document every time. An index maps the values of one attribute of all
+    elements with one name to these elements once, so lookups are a hash access.
+
+    Numeric indexes keep the parsed values of one attribute sorted, for range, top-k
+    and min/max lookups by binary search instead of predicates over all elements.
+
+    Indexes belong to the context. They are rebuild lazy after the document was
+    changed by xml_ctx functions, see xml_ctx_doc_changed. Attribute changes by
+    xml_ctx_set_attr_str_xpath are applied to the indexes directly.
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <libxml/hash.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include <libxml/xpathInternals.h>
+
+#include "xml_utils.h"
+
+typedef struct {
+    xmlNodePtr  *nodes;     /* elements with same key value in document order */
+    int         cnt;        /* number of elements */
+    int         max;        /* allocated slots */
+} XmlIndexNodes;
+
+typedef struct _xml_index {
+    xmlChar             *name;      /* name of index, used by key() */
+    xmlChar             *element;   /* name of indexed elements, "*" for all elements */
+    xmlChar             *attr;      /* name of key attribute */
+    xmlHashTablePtr     values;     /* key value => XmlIndexNodes */
+    unsigned long       version;    /* context version the index was build for */
+    struct _xml_index   *next;      /* next index of same context */
+} XmlIndex;
+
+typedef struct {
+    double      value;      /* parsed attribute value */
+    xmlNodePtr  node;       /* element with this value */
+} XmlNumIndexEntry;
+
+typedef struct _xml_num_index {
+    xmlChar                 *name;      /* name of index */
+    xmlChar                 *element;   /* name of indexed elements, "*" for all elements */
+    xmlChar                 *attr;      /* name of value attribute */
+    XmlNumIndexEntry        *entries;   /* entries sorted ascending by value */
+    int                     cnt;        /* number of entries */
+    int                     max;        /* allocated entries */
+    unsigned long           version;    /* context version the index was build for */
+    struct _xml_num_index   *next;      /* next numeric index of same context */
+} XmlNumIndex;
+
+/*
+
+    This Function creates a index with given name over the attribute attr of all
+    elements with name element. An existing index with the same name is replaced.
+    Like in xpath, names match elements and attributes without namespace only.
+
+    Example:
+        xml_ctx_index_create(ctx, "talent", "talent", "name");
+
+        xmlNodePtr *nodes;
+        int cnt = xml_ctx_index_lookup(ctx, "talent", "Dolche", &nodes);
+
+        or inside of xpath expressions:
+
+        xml_ctx_xpath(ctx, "key('talent', 'Dolche')/@value");
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    name            name of index
+    element         name of indexed elements or "*" for all elements
+    attr            name of key attribute
+
+    returns 0 on success, otherwise -1
+*/
+int xml_ctx_index_create(XmlCtx *ctx, const char *name, const char *element, const char *attr);
+
+/*
+
+    This Function searches all elements of index with given key value. The result
+    array belongs to the index and is valid until the document or the index changes.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    name            name of index
+    value           key value to search for
+    nodes           target of found elements in document order, could be NULL
+
+    returns number of found elements, 0 if there is no such index
+*/
+int xml_ctx_index_lookup(XmlCtx *ctx, const char *name, const char *value, xmlNodePtr **nodes);
+
+/*
+
+    This Function removes the index with given name or all indexes, including
+    numeric indexes, of the context.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    name            name of index
+
+*/
+void xml_ctx_index_free(XmlCtx *ctx, const char *name);
+void xml_ctx_index_free_all(XmlCtx *ctx);
+
+/*
+
+    This Function creates a sorted numeric index with given name over the attribute
+    attr of all elements with name element. Values are converted like number() does,
+    elements with non numeric values are not part of the index. An existing numeric
+    index with the same name is replaced.
+
+    Example:
+        xml_ctx_numindex_create(ctx, "weight", "eq", "weight");
+
+        const XmlNumIndexEntry *entries;
+        int cnt = xml_ctx_numindex_range(ctx, "weight", 1., 5., &entries);
+
+        for (int cur = 0; cur < cnt; ++cur) {
+            ... entries[cur].node, entries[cur].value
+        }
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    name            name of index
+    element         name of indexed elements or "*" for all elements
+    attr            name of value attribute
+
+    returns 0 on success, otherwise -1
+*/
+int xml_ctx_numindex_create(XmlCtx *ctx, const char *name, const char *element, const char *attr);
+
+/*
+
+    This Functions search at numeric index. All results are slices of the index
+    sorted ascending by value, entries with equal values are in no particular order.
+    The slices belong to the index and are valid until the document or the index
+    changes.
+
+    xml_ctx_numindex_range      entries with min <= value <= max
+    xml_ctx_numindex_top        entries of the k highest values, highest is the last
+    xml_ctx_numindex_bottom     entries of the k lowest values, lowest is the first
+    xml_ctx_numindex_min/max    entry with lowest/highest value
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    name            name of index
+    min             lowest value of range
+    max             highest value of range
+    k               maximum number of entries
+    entries         target of the first entry of result slice
+    entry           target of min or max entry
+
+    returns number of entries, 0 if there is no such index. min and max return
+    false if there is no entry.
+*/
+int xml_ctx_numindex_range(XmlCtx *ctx, const char *name, double min, double max, const XmlNumIndexEntry **entries);
+int xml_ctx_numindex_top(XmlCtx *ctx, const char *name, int k, const XmlNumIndexEntry **entries);
+int xml_ctx_numindex_bottom(XmlCtx *ctx, const char *name, int k, const XmlNumIndexEntry **entries);
+bool xml_ctx_numindex_min(XmlCtx *ctx, const char *name, XmlNumIndexEntry *entry);
+bool xml_ctx_numindex_max(XmlCtx *ctx, const char *name, XmlNumIndexEntry *entry);
+
+/*
+
+    This Function removes the numeric index with given name. All numeric indexes
+    are removed by xml_ctx_index_free_all.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    name            name of index
+
+*/
+void xml_ctx_numindex_free(XmlCtx *ctx, const char *name);
+
+/*
+
+    Index maintenance for attribute changes, used by xml_ctx_set_attr_str_xpath.
+
+    xml_ctx_index_attr_changing has to be called before attribute attr of element
+    gets the new value. It updates all indexes which are up to date.
+    xml_ctx_index_keep marks all indexes which was up to date at given version as
+    up to date at the current version of the context.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    element         element of the attribute
+    attr            name of the attribute
+    value           new value of attribute
+    version         context version before the change
+
+*/
+void xml_ctx_index_attr_changing(XmlCtx *ctx, xmlNodePtr element, const xmlChar *attr, const xmlChar *value);
+void xml_ctx_index_keep(XmlCtx *ctx, unsigned long version);
+
+/*
+    xpath function "key(name, value)" of xml context evaluation contexts. It returns
+    the elements of index name with key value. If value is a node set the elements of
+    the string values of all nodes are returned. Unknown index names result in an empty
+    node set.
+*/
+void key_xpath_func(xmlXPathParserContextPtr ctxt, int nargs);
+
+#endif
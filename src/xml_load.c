@@ -0,0 +1,213 @@
+#if !defined(OS_WINDOWS) && !defined(_POSIX_C_SOURCE)
+    /* pthread and sysconf with -std=c11 */
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "xml_load.h"
+
+#include <pthread.h>
+
+#if defined(OS_WINDOWS)
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+typedef struct {
+    XmlSource       **sources;  /* source of each document, set up to ready */
+    XmlCtx          **ctxs;     /* target contexts */
+    int             cnt;        /* number of documents */
+    int             options;    /* XmlCtxOption of parsing */
+    int             ready;      /* number of sources handed to workers */
+    int             next;       /* next document to parse */
+    pthread_mutex_t lock;       /* protects ready and next */
+    pthread_cond_t  available;  /* signaled by new sources */
+} XmlLoadJobs;
+
+typedef struct {
+    XmlLoadJobs     *jobs;      /* shared jobs */
+    pthread_t       *workers;   /* started worker threads */
+    int             started;    /* number of started worker threads */
+} XmlLoadPool;
+
+static int __xml_load_processors() {
+
+#if defined(OS_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const long cnt = (long)info.dwNumberOfProcessors;
+#else
+    const long cnt = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return ( cnt > 0 ? (int)cnt : 1 );
+}
+
+static void* __xml_load_worker(void *arg) {
+
+    XmlLoadJobs *jobs = arg;
+
+    for ( ;; ) {
+
+        pthread_mutex_lock(&jobs->lock);
+
+        while ( jobs->next < jobs->cnt && jobs->next >= jobs->ready ) {
+            pthread_cond_wait(&jobs->available, &jobs->lock);
+        }
+
+        const int job = ( jobs->next < jobs->cnt ? jobs->next++ : -1 );
+
+        pthread_mutex_unlock(&jobs->lock);
+
+        if ( job < 0 ) {
+            break;
+        }
+
+        jobs->ctxs[job] = xml_ctx_new_opts(jobs->sources[job], jobs->options);
+    }
+
+    return NULL;
+}
+
+static void __xml_load_start(XmlLoadPool *pool, XmlLoadJobs *jobs, int threads) {
+
+    xmlInitParser();
+
+    pthread_mutex_init(&jobs->lock, NULL);
+    pthread_cond_init(&jobs->available, NULL);
+
+    threads = ( threads <= 0 ? __xml_load_processors() : threads );
+    threads = ( threads > jobs->cnt ? jobs->cnt : threads );
+
+    pool->jobs = jobs;
+    pool->workers = malloc(( threads > 0 ? threads : 1 ) * sizeof(pthread_t));
+    pool->started = 0;
+
+    /* a single worker would only wait for the caller */
+    for ( int curthread = 0; threads > 1 && curthread < threads; ++curthread ) {
+        if ( pthread_create(&pool->workers[pool->started], NULL, __xml_load_worker, jobs) == 0 ) {
+            ++pool->started;
+        }
+    }
+}
+
+static void __xml_load_publish(XmlLoadPool *pool, int job, XmlSource *source) {
+
+    XmlLoadJobs *jobs = pool->jobs;
+
+    pthread_mutex_lock(&jobs->lock);
+    jobs->sources[job] = source;
+    jobs->ready = job + 1;
+    pthread_cond_broadcast(&jobs->available);
+    pthread_mutex_unlock(&jobs->lock);
+}
+
+static int __xml_load_finish(XmlLoadPool *pool) {
+
+    XmlLoadJobs *jobs = pool->jobs;
+
+    /* without workers or after all sources were published the caller parses too */
+    __xml_load_worker(jobs);
+
+    for ( int curthread = 0; curthread < pool->started; ++curthread ) {
+        pthread_join(pool->workers[curthread], NULL);
+    }
+
+    free(pool->workers);
+    pthread_cond_destroy(&jobs->available);
+    pthread_mutex_destroy(&jobs->lock);
+
+    int success = 0;
+
+    for ( int curctx = 0; curctx < jobs->cnt; ++curctx ) {
+        if ( jobs->ctxs[curctx]->state.state_no == XML_CTX_SUCCESS ) {
+            ++success;
+        }
+    }
+
+    return success;
+}
+
+int xml_ctx_new_many(ArchiveResource *ar, const char * const names[], int cnt, int options, int threads, XmlCtx *ctxs[]) {
+
+    if ( names == NULL || ctxs == NULL || cnt <= 0 ) {
+        return 0;
+    }
+
+    XmlLoadJobs jobs = { .sources = malloc(cnt * sizeof(XmlSource *)), .ctxs = ctxs, .cnt = cnt, .options = options };
+    XmlLoadPool pool;
+
+    __xml_load_start(&pool, &jobs, threads);
+
+    /* the archive is read here only, workers parse the published sources meanwhile */
+    for ( int curname = 0; curname < cnt; ++curname ) {
+        __xml_load_publish(&pool, curname, xml_source_from_resname(ar, names[curname]));
+    }
+
+    const int success = __xml_load_finish(&pool);
+
+    free(jobs.sources);
+
+    return success;
+}
+
+int xml_ctx_new_matching(ArchiveResource *ar, const char *regex, int options, int threads, XmlCtxList *list) {
+
+    if ( list == NULL ) {
+        return 0;
+    }
+
+    memset(list, 0, sizeof(XmlCtxList));
+
+    if ( ar == NULL || regex == NULL ) {
+        return 0;
+    }
+
+    ResourceSearchResult *found = archive_resource_search(ar, (const unsigned char *)regex);
+
+    if ( found == NULL ) {
+        return 0;
+    }
+
+    const int cnt = (int)found->cnt;
+
+    int success = 0;
+
+    if ( cnt > 0 ) {
+
+        list->ctxs = malloc(cnt * sizeof(XmlCtx *));
+        list->cnt = cnt;
+
+        XmlLoadJobs jobs = { .sources = malloc(cnt * sizeof(XmlSource *)), .ctxs = list->ctxs, .cnt = cnt, .options = options };
+        XmlLoadPool pool;
+
+        for ( int curfile = 0; curfile < cnt; ++curfile ) {
+            jobs.sources[curfile] = xml_source_from_resfile(found->files[curfile]);
+        }
+
+        __xml_load_start(&pool, &jobs, threads);
+        __xml_load_publish(&pool, cnt - 1, jobs.sources[cnt - 1]);
+
+        success = __xml_load_finish(&pool);
+
+        free(jobs.sources);
+    }
+
+    resource_search_result_free(&found);
+
+    return success;
+}
+
+void xml_ctx_list_free(XmlCtxList *list) {
+
+    if ( list != NULL ) {
+
+        for ( int curctx = 0; curctx < list->cnt; ++curctx ) {
+            free_xml_ctx_src(&list->ctxs[curctx]);
+        }
+
+        free(list->ctxs);
+
+        memset(list, 0, sizeof(XmlCtxList));
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef XML_LOAD_H
+#define XML_LOAD_H
+
+#if 0
+    Parallel loading of many archive documents.
+
+    The archive is read by the calling thread only, because an archive handle is not
+    thread safe. Decompressed resources are handed to a pool of worker threads, which
+    parse them while the next resources are decompressed. With an archive index (see
+    xml_source_archive_index) nothing is decompressed and all documents are parsed
+    concurrently from the start.
+
+    Every document gets its own dictionary, libxml dictionaries are not locked for
+    lookups, so XML_CTX_OPT_INTERN_VALUES works per document only.
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <libxml/parser.h>
+
+#include "resource.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+
+typedef struct {
+    XmlCtx  **ctxs;     /* parsed contexts, each owns its resource file source */
+    int     cnt;        /* number of contexts */
+} XmlCtxList;
+
+/*
+
+    This Function parses the archive resources names concurrently.
+
+    Example:
+        const char *names[] = { "breeds", "cultures", "professions", "talents" };
+        XmlCtx *ctxs[4];
+
+        if ( xml_ctx_new_many(ar, names, 4, XML_CTX_OPT_COMPACT_READONLY, 0, ctxs) != 4 ) {
+            ... check ctxs[i]->state
+        }
+        ...
+        free_xml_ctx_src(&ctxs[0]); ...
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ar              archive resource
+    names           names of resources like xml_source_from_resname
+    cnt             number of names
+    options         combination of XmlCtxOption
+    threads         number of worker threads, 0 for one per processor
+    ctxs            target of cnt contexts, ctxs[i] for names[i]. Every entry is a
+                    context with state, free them with free_xml_ctx_src.
+
+    returns number of successfully parsed documents
+*/
+int xml_ctx_new_many(ArchiveResource *ar, const char * const names[], int cnt, int options, int threads, XmlCtx *ctxs[]);
+
+/*
+
+    This Function parses all archive resources with complete names matching regex
+    concurrently. The archive is decompressed once for all matching resources.
+
+    Example:
+        XmlCtxList all;
+        xml_ctx_new_matching(ar, "^xml/.*\\.xml$", XML_CTX_OPT_NONE, 0, &all);
+
+        for ( int cur = 0; cur < all.cnt; ++cur ) {
+            ... all.ctxs[cur]->src->data.resfile->name
+        }
+
+        xml_ctx_list_free(&all);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ar              archive resource
+    regex           pattern of complete resource names, like archive_resource_search
+    options         combination of XmlCtxOption
+    threads         number of worker threads, 0 for one per processor
+    list            target of contexts, initialized in every case
+
+    returns number of successfully parsed documents
+*/
+int xml_ctx_new_matching(ArchiveResource *ar, const char *regex, int options, int threads, XmlCtxList *list);
+
+/*
+
+    This Function frees all contexts of the list and their sources. The list is empty afterwards.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    list            list to free
+
+*/
+void xml_ctx_list_free(XmlCtxList *list);
+
+#endif
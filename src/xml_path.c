@@ -0,0 +1,312 @@
+#include "xml_path.h"
+
+static const char * __xml_path_skip_ws(const char *cur) {
+    while ( *cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r' ) {
+        ++cur;
+    }
+    return cur;
+}
+
+static bool __xml_path_name_char(unsigned char c, bool first) {
+    return ( ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c == '_' || c >= 0x80 ||
+             ( !first && ( ( c >= '0' && c <= '9' ) || c == '-' || c == '.' || c == ':' ) ) );
+}
+
+/* element or attribute name, returns NULL if there is none, like for .., text() or axis:: */
+static xmlChar * __xml_path_name(const char **expr) {
+
+    const char *start = *expr;
+    const char *cur = start;
+
+    while ( __xml_path_name_char((unsigned char)*cur, cur == start) ) {
+        ++cur;
+    }
+
+    const char *axis = strstr(start, "::");
+
+    if ( cur == start || cur[-1] == ':' || ( axis != NULL && axis < cur ) ) {
+        return NULL;
+    }
+
+    *expr = cur;
+
+    return xmlStrndup((const xmlChar *)start, (int)(cur - start));
+}
+
+static void __xml_path_add_pred(XmlPathStep *step, xmlChar *name, xmlChar *value) {
+    step->preds = realloc(step->preds, (step->pred_cnt + 1) * sizeof(XmlPathPred));
+    step->preds[step->pred_cnt].name = name;
+    step->preds[step->pred_cnt].value = value;
+    ++step->pred_cnt;
+}
+
+/* predicate list "[@a = 'v' and @b]" of step, returns false on syntax errors */
+static bool __xml_path_parse_preds(const char **expr, XmlPathStep *step) {
+
+    const char *cur = *expr;
+
+    while ( *cur == '[' ) {
+
+        cur = __xml_path_skip_ws(cur + 1);
+
+        for (;;) {
+
+            if ( *cur != '@' ) return false;
+
+            ++cur;
+
+            xmlChar *name = __xml_path_name(&cur);
+            xmlChar *value = NULL;
+
+            if ( name == NULL ) return false;
+
+            cur = __xml_path_skip_ws(cur);
+
+            if ( *cur == '=' ) {
+
+                cur = __xml_path_skip_ws(cur + 1);
+
+                const char quote = *cur;
+                const char *end = ( quote == '\'' || quote == '"' ? strchr(cur + 1, quote) : NULL );
+
+                if ( end == NULL ) {
+                    xmlFree(name);
+                    return false;
+                }
+
+                value = xmlStrndup((const xmlChar *)(cur + 1), (int)(end - cur - 1));
+                cur = __xml_path_skip_ws(end + 1);
+            }
+
+            __xml_path_add_pred(step, name, value);
+
+            if ( strncmp(cur, "and", 3) == 0 && strchr(" \t\n\r@", cur[3]) != NULL ) {
+                cur = __xml_path_skip_ws(cur + 3);
+                continue;
+            }
+
+            break;
+        }
+
+        if ( *cur != ']' ) return false;
+
+        ++cur;
+    }
+
+    *expr = cur;
+
+    return true;
+}
+
+XmlPath* xml_path_new(const char *expr) {
+
+    if ( expr == NULL ) {
+        return NULL;
+    }
+
+    XmlPath *path = malloc(sizeof(XmlPath));
+    path->steps = NULL;
+    path->step_cnt = 0;
+
+    const char *cur = __xml_path_skip_ws(expr);
+    bool valid = ( *cur == '/' );
+
+    while ( valid && *cur == '/' ) {
+
+        if ( path->step_cnt == XML_PATH_MAX_STEPS ) {
+            valid = false;
+            break;
+        }
+
+        path->steps = realloc(path->steps, (path->step_cnt + 1) * sizeof(XmlPathStep));
+
+        XmlPathStep *step = &path->steps[path->step_cnt++];
+        step->descendant = ( cur[1] == '/' );
+        step->name = NULL;
+        step->preds = NULL;
+        step->pred_cnt = 0;
+
+        cur += ( step->descendant ? 2 : 1 );
+
+        if ( *cur == '*' ) {
+            ++cur;
+        } else {
+            step->name = __xml_path_name(&cur);
+            valid = ( step->name != NULL );
+        }
+
+        valid = valid && __xml_path_parse_preds(&cur, step);
+    }
+
+    if ( !valid || *__xml_path_skip_ws(cur) != '\0' ) {
+        xml_path_free(&path);
+    }
+
+    return path;
+}
+
+void xml_path_free(XmlPath **path) {
+
+    if ( path != NULL && *path != NULL ) {
+
+        XmlPath *to_delete = *path;
+
+        for ( int curstep = 0; curstep < to_delete->step_cnt; ++curstep ) {
+
+            XmlPathStep *step = &to_delete->steps[curstep];
+
+            for ( int curpred = 0; curpred < step->pred_cnt; ++curpred ) {
+                xmlFree(step->preds[curpred].name);
+                xmlFree(step->preds[curpred].value);
+            }
+
+            xmlFree(step->name);
+            free(step->preds);
+        }
+
+        free(to_delete->steps);
+        free(to_delete);
+
+        *path = NULL;
+    }
+}
+
+XmlPathState xml_path_start(const XmlPath *path) {
+    (void)(path);
+    return 1;
+}
+
+static bool __xml_path_step_match(const XmlPathStep *step, const xmlChar *name, XmlPathAttrFunc attr, void *element) {
+
+    if ( step->name != NULL && !xmlStrEqual(step->name, name) ) {
+        return false;
+    }
+
+    for ( int curpred = 0; curpred < step->pred_cnt; ++curpred ) {
+
+        const xmlChar *value = attr(element, step->preds[curpred].name);
+
+        if ( value == NULL ) {
+            return false;
+        }
+
+        if ( step->preds[curpred].value != NULL && !xmlStrEqual(step->preds[curpred].value, value) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+XmlPathState xml_path_step(const XmlPath *path, XmlPathState parent, const xmlChar *name, XmlPathAttrFunc attr, void *element) {
+
+    XmlPathState state = 0;
+
+    for ( int curstep = 0; curstep < path->step_cnt; ++curstep ) {
+
+        if ( (parent & ((XmlPathState)1 << curstep)) == 0 ) continue;
+
+        const XmlPathStep *step = &path->steps[curstep];
+
+        if ( step->descendant ) {
+            state |= ((XmlPathState)1 << curstep);
+        }
+
+        if ( __xml_path_step_match(step, name, attr, element) ) {
+            state |= ((XmlPathState)1 << (curstep + 1));
+        }
+    }
+
+    return state;
+}
+
+typedef struct {
+    xmlNodePtr  node;   /* element */
+    xmlChar     *tmp;   /* last value which had to be copied */
+} XmlPathNodeAttr;
+
+static const xmlChar * __xml_path_node_attr(void *element, const xmlChar *name) {
+
+    XmlPathNodeAttr *node_attr = element;
+
+    xmlFree(node_attr->tmp);
+    node_attr->tmp = NULL;
+
+    xmlAttrPtr attr = node_attr->node->properties;
+
+    /* like xpath names do not match attributes of a namespace */
+    while ( attr != NULL && ( attr->ns != NULL || !xmlStrEqual(attr->name, name) ) ) {
+        attr = attr->next;
+    }
+
+    if ( attr == NULL ) {
+        return NULL;
+    }
+
+    xmlNodePtr text = attr->children;
+
+    if ( text == NULL ) {
+        return (const xmlChar *)"";
+    }
+
+    if ( text->next == NULL && text->type == XML_TEXT_NODE ) {
+        return text->content;
+    }
+
+    node_attr->tmp = xmlNodeListGetString(node_attr->node->doc, text, 1);
+
+    return node_attr->tmp;
+}
+
+XmlPathState xml_path_step_node(const XmlPath *path, XmlPathState parent, xmlNodePtr node) {
+
+    if ( node == NULL || node->type != XML_ELEMENT_NODE ) {
+        return 0;
+    }
+
+    XmlPathNodeAttr node_attr = { node, NULL };
+
+    /* like xpath names do not match elements of a namespace, only * does */
+    XmlPathState state = xml_path_step(path, parent, ( node->ns == NULL ? node->name : NULL ), __xml_path_node_attr, &node_attr);
+
+    xmlFree(node_attr.tmp);
+
+    return state;
+}
+
+bool xml_path_matched(const XmlPath *path, XmlPathState state) {
+    return ( state & ((XmlPathState)1 << path->step_cnt) ) != 0;
+}
+
+bool xml_path_dead(const XmlPath *path, XmlPathState state) {
+    return ( state & (((XmlPathState)1 << path->step_cnt) - 1) ) == 0;
+}
+
+/* preorder walk of node and its following siblings */
+static xmlNodePtr __xml_path_first(const XmlPath *path, XmlPathState parent, xmlNodePtr node) {
+
+    for ( ; node != NULL; node = node->next ) {
+
+        if ( node->type != XML_ELEMENT_NODE ) {
+            continue;
+        }
+
+        const XmlPathState state = xml_path_step_node(path, parent, node);
+
+        if ( xml_path_matched(path, state) ) {
+            return node;
+        }
+
+        xmlNodePtr found = ( xml_path_dead(path, state) ? NULL : __xml_path_first(path, state, node->children) );
+
+        if ( found != NULL ) {
+            return found;
+        }
+    }
+
+    return NULL;
+}
+
+xmlNodePtr xml_path_first(const XmlPath *path, xmlDocPtr doc) {
+    return ( path != NULL && doc != NULL ? __xml_path_first(path, xml_path_start(path), doc->children) : NULL );
+}
@@ -0,0 +1,135 @@
+#ifndef XML_PATH_H
+#define XML_PATH_H
+
+#if 0
+    Restricted xpath location paths, which can be matched element by element without
+    a complete document, like from xmlTextReader streams.
+
+    Supported are absolute paths of child (/) and descendant (//) steps with element
+    names or *, each step with optional attribute predicates:
+
+        /talents/talent
+        //eq[@name = 'Schultergurt']
+        /hero//talent[@type][@value = "5" and @inc = 'B']
+
+    The match state of an element is a bit set of the steps which could be matched
+    next by its children. It is calculated from the state of the parent element only,
+    so a walker keeps one state per depth.
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libxml/tree.h>
+#include <libxml/xmlstring.h>
+
+#define XML_PATH_MAX_STEPS 63   /* maximum number of steps, limited by XmlPathState bits */
+
+typedef uint64_t XmlPathState;
+
+typedef struct {
+    xmlChar     *name;      /* attribute name */
+    xmlChar     *value;     /* expected value, NULL if attribute has only to exist */
+} XmlPathPred;
+
+typedef struct {
+    bool        descendant; /* step axis is descendant (//) instead of child (/) */
+    xmlChar     *name;      /* element name, NULL for * */
+    XmlPathPred *preds;     /* attribute predicates, all have to match */
+    int         pred_cnt;   /* number of predicates */
+} XmlPathStep;
+
+typedef struct {
+    XmlPathStep *steps;     /* location steps */
+    int         step_cnt;   /* number of location steps */
+} XmlPath;
+
+/*
+    Attribute access for xml_path_step. Returns the value of attribute name or NULL if
+    the attribute not exists. The value have to be valid until the next call.
+*/
+typedef const xmlChar * (*XmlPathAttrFunc)(void *element, const xmlChar *name);
+
+/*
+
+    This Function parses a restricted location path.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    expr            location path
+
+    returns new path or NULL if expr is not a supported path
+*/
+XmlPath* xml_path_new(const char *expr);
+
+/*
+
+    This Function frees the path. The pointer will be NULL.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    path            pointer to path pointer
+
+*/
+void xml_path_free(XmlPath **path);
+
+/*
+
+    This Functions calculate match states.
+
+    xml_path_start      state of the document node, parent state of the root element
+    xml_path_step       state of an element with given name and parent state, attr
+                        and element are used for predicates
+    xml_path_step_node  xml_path_step for a dom element, like xpath elements of a
+                        namespace are only matched by *
+    xml_path_matched    true if the element with state is matched by the path
+    xml_path_dead       true if no descendant of element with state could match, so
+                        the subtree can be skipped
+
+    Example:
+        XmlPathState root = xml_path_step_node(path, xml_path_start(path), xmlDocGetRootElement(doc));
+
+        if ( xml_path_matched(path, root) ) ...
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    path            path to match
+    parent          state of parent element
+    name            name of element
+    attr            attribute access of element
+    element         element passed to attr
+    node            dom element
+
+*/
+XmlPathState xml_path_start(const XmlPath *path);
+XmlPathState xml_path_step(const XmlPath *path, XmlPathState parent, const xmlChar *name, XmlPathAttrFunc attr, void *element);
+XmlPathState xml_path_step_node(const XmlPath *path, XmlPathState parent, xmlNodePtr node);
+bool xml_path_matched(const XmlPath *path, XmlPathState state);
+bool xml_path_dead(const XmlPath *path, XmlPathState state);
+
+/*
+
+    This Function returns the first element of the document matched by path in document
+    order. The walk stops there and skips subtrees which can not contain a match. Like
+    in xpath, element names do not match elements with a namespace.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    path            path to match
+    doc             dom document
+
+    returns first matched element or NULL
+*/
+xmlNodePtr xml_path_first(const XmlPath *path, xmlDocPtr doc);
+
+#endif
@@ -0,0 +1,309 @@
+#include "xml_record.h"
+
+#define XML_RECORD_CHUNK_SIZE 4096
+
+typedef struct {
+    const XmlRecordDesc *desc;      /* record descriptor */
+    XmlPath             *path;      /* parsed path of descriptor */
+    XmlRecords          *records;   /* target records */
+    XmlPathState        *states;    /* states[depth] is the state of the parent of elements at depth */
+} XmlRecordRun;
+
+typedef struct {
+    XmlRecordRun    *runs;          /* one run per descriptor */
+    int             run_cnt;        /* number of runs */
+    int             depth;          /* depth of next element */
+    int             max_depth;      /* allocated states of each run */
+    const xmlChar   **attributes;   /* sax2 attributes of current element */
+    int             nb_attributes;  /* number of sax2 attributes of current element */
+    xmlChar         *value;         /* terminated copy of last attribute value */
+    int             value_size;     /* allocated bytes of value */
+} XmlRecordParser;
+
+static char * __xml_record_string(XmlRecords *records, const xmlChar *value, size_t len) {
+
+    XmlRecordChunk *chunk = records->strings;
+
+    if ( chunk == NULL || chunk->size - chunk->used < len + 1 ) {
+        const size_t size = ( len + 1 > XML_RECORD_CHUNK_SIZE ? len + 1 : XML_RECORD_CHUNK_SIZE );
+        chunk = malloc(sizeof(XmlRecordChunk) + size);
+        chunk->next = records->strings;
+        chunk->size = size;
+        chunk->used = 0;
+        records->strings = chunk;
+    }
+
+    char *result = &chunk->data[chunk->used];
+
+    memcpy(result, value, len);
+    result[len] = '\0';
+
+    chunk->used += len + 1;
+
+    return result;
+}
+
+static void __xml_record_set(XmlRecords *records, const XmlRecordField *field, void *record, const xmlChar *value, size_t len) {
+
+    char *target = (char *)record + field->offset;
+
+    switch ( field->type ) {
+
+        case XML_RECORD_STRING: {
+            char *str = __xml_record_string(records, value, len);
+            memcpy(target, &str, sizeof(char *));
+            break;
+        }
+
+        case XML_RECORD_CHARS: {
+            size_t cnt = ( len < field->size ? len : field->size - 1 );
+
+            /* do not cut utf-8 sequences */
+            while ( cnt < len && cnt > 0 && (value[cnt] & 0xC0) == 0x80 ) {
+                --cnt;
+            }
+
+            memcpy(target, value, cnt);
+            target[cnt] = '\0';
+            break;
+        }
+
+        case XML_RECORD_INT: {
+            char *end;
+            errno = 0;
+            const long number = strtol((const char *)value, &end, 10);
+            const int result = (int)number;
+
+            if ( end == (const char *)value || *end != '\0' || errno == ERANGE || number != result ) {
+                ++records->errors;
+            } else {
+                memcpy(target, &result, sizeof(int));
+            }
+            break;
+        }
+
+        case XML_RECORD_DOUBLE: {
+            const double result = xpath_str_to_number(value);
+
+            if ( isnan(result) ) {
+                ++records->errors;
+            }
+
+            memcpy(target, &result, sizeof(double));
+            break;
+        }
+
+        case XML_RECORD_BOOL: {
+            bool result = false;
+
+            if ( xmlStrEqual(value, (const xmlChar *)"true") || xmlStrEqual(value, (const xmlChar *)"1") ) {
+                result = true;
+            } else if ( !xmlStrEqual(value, (const xmlChar *)"false") && !xmlStrEqual(value, (const xmlChar *)"0") ) {
+                ++records->errors;
+            }
+
+            memcpy(target, &result, sizeof(bool));
+            break;
+        }
+    }
+}
+
+/* terminated copy of sax2 attribute value at index */
+static const xmlChar * __xml_record_value(XmlRecordParser *parser, int index, size_t *len) {
+
+    const xmlChar *start = parser->attributes[index * 5 + 3];
+    const xmlChar *end = parser->attributes[index * 5 + 4];
+
+    *len = (size_t)(end - start);
+
+    if ( (int)*len + 1 > parser->value_size ) {
+        parser->value_size = (int)*len + 64;
+        parser->value = realloc(parser->value, parser->value_size);
+    }
+
+    memcpy(parser->value, start, *len);
+    parser->value[*len] = '\0';
+
+    return parser->value;
+}
+
+static const xmlChar * __xml_record_attr(void *element, const xmlChar *name) {
+
+    XmlRecordParser *parser = element;
+
+    for ( int curattr = 0; curattr < parser->nb_attributes; ++curattr ) {
+
+        if ( xmlStrEqual(parser->attributes[curattr * 5], name) ) {
+            size_t len;
+            return __xml_record_value(parser, curattr, &len);
+        }
+    }
+
+    return NULL;
+}
+
+static void __xml_record_add(XmlRecordParser *parser, XmlRecordRun *run) {
+
+    XmlRecords *records = run->records;
+    const XmlRecordDesc *desc = run->desc;
+
+    if ( records->cnt == records->max ) {
+        records->max = ( records->max == 0 ? 64 : records->max * 2 );
+        records->records = realloc(records->records, records->max * desc->record_size);
+    }
+
+    void *record = (char *)records->records + records->cnt * desc->record_size;
+    memset(record, 0, desc->record_size);
+    ++records->cnt;
+
+    for ( int curattr = 0; curattr < parser->nb_attributes; ++curattr ) {
+
+        const xmlChar *name = parser->attributes[curattr * 5];
+
+        for ( int curfield = 0; curfield < desc->field_cnt; ++curfield ) {
+
+            const XmlRecordField *field = &desc->fields[curfield];
+
+            if ( xmlStrEqual((const xmlChar *)field->attr, name) ) {
+                size_t len;
+                const xmlChar *value = __xml_record_value(parser, curattr, &len);
+                __xml_record_set(records, field, record, value, len);
+            }
+        }
+    }
+}
+
+static void __xml_record_start(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI,
+                               int nb_namespaces, const xmlChar **namespaces,
+                               int nb_attributes, int nb_defaulted, const xmlChar **attributes) {
+    (void)(prefix);
+    (void)(URI);
+    (void)(nb_namespaces);
+    (void)(namespaces);
+    (void)(nb_defaulted);
+
+    XmlRecordParser *parser = ctx;
+
+    if ( parser->depth + 1 >= parser->max_depth ) {
+        parser->max_depth *= 2;
+        for ( int currun = 0; currun < parser->run_cnt; ++currun ) {
+            parser->runs[currun].states = realloc(parser->runs[currun].states, parser->max_depth * sizeof(XmlPathState));
+        }
+    }
+
+    parser->attributes = attributes;
+    parser->nb_attributes = nb_attributes;
+
+    for ( int currun = 0; currun < parser->run_cnt; ++currun ) {
+
+        XmlRecordRun *run = &parser->runs[currun];
+        const XmlPathState parent = run->states[parser->depth];
+
+        XmlPathState state = 0;
+
+        if ( parent != 0 ) {
+            state = xml_path_step(run->path, parent, localname, __xml_record_attr, parser);
+
+            if ( xml_path_matched(run->path, state) ) {
+                __xml_record_add(parser, run);
+            }
+        }
+
+        run->states[parser->depth + 1] = state;
+    }
+
+    ++parser->depth;
+}
+
+static void __xml_record_end(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI) {
+    (void)(localname);
+    (void)(prefix);
+    (void)(URI);
+
+    XmlRecordParser *parser = ctx;
+
+    --parser->depth;
+}
+
+int xml_record_extract(const XmlSource *src, const XmlRecordDesc *descs, int desc_cnt, XmlRecords *results) {
+
+    if ( results == NULL || desc_cnt < 0 ) {
+        return -1;
+    }
+
+    memset(results, 0, desc_cnt * sizeof(XmlRecords));
+
+    if ( src == NULL || src->src_data == NULL || src->src_size == NULL || *src->src_size == 0 || descs == NULL ) {
+        return -1;
+    }
+
+    XmlRecordParser parser = { malloc(desc_cnt * sizeof(XmlRecordRun)), desc_cnt, 0, 32, NULL, 0, NULL, 0 };
+
+    bool valid = true;
+
+    for ( int currun = 0; currun < desc_cnt; ++currun ) {
+
+        XmlRecordRun *run = &parser.runs[currun];
+        run->desc = &descs[currun];
+        run->path = xml_path_new(descs[currun].path);
+        run->records = &results[currun];
+        run->states = malloc(parser.max_depth * sizeof(XmlPathState));
+        run->states[0] = ( run->path != NULL ? xml_path_start(run->path) : 0 );
+
+        valid = valid && run->path != NULL;
+    }
+
+    if ( valid ) {
+
+        xmlParserCtxtPtr ctxt = xmlCreateMemoryParserCtxt((const char *)src->src_data, (int)*src->src_size);
+
+        if ( ctxt != NULL ) {
+
+            /* only element callbacks, so no document is build */
+            memset(ctxt->sax, 0, sizeof(xmlSAXHandler));
+            ctxt->sax->initialized = XML_SAX2_MAGIC;
+            ctxt->sax->startElementNs = __xml_record_start;
+            ctxt->sax->endElementNs = __xml_record_end;
+            ctxt->userData = &parser;
+
+            /* predefined entities and character references are replaced in attribute values */
+            xmlCtxtUseOptions(ctxt, XML_PARSE_NOENT);
+
+            xmlParseDocument(ctxt);
+
+            valid = ctxt->wellFormed;
+
+            xmlFreeParserCtxt(ctxt);
+        } else {
+            valid = false;
+        }
+    }
+
+    for ( int currun = 0; currun < desc_cnt; ++currun ) {
+        xml_path_free(&parser.runs[currun].path);
+        free(parser.runs[currun].states);
+    }
+
+    free(parser.runs);
+    free(parser.value);
+
+    return ( valid ? 0 : -1 );
+}
+
+void xml_records_free(XmlRecords *records) {
+
+    if ( records != NULL ) {
+
+        XmlRecordChunk *chunk = records->strings;
+
+        while ( chunk != NULL ) {
+            XmlRecordChunk *next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+
+        free(records->records);
+
+        memset(records, 0, sizeof(XmlRecords));
+    }
+}
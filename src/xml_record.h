@@ -0,0 +1,125 @@
+#ifndef XML_RECORD_H
+#define XML_RECORD_H
+
+#if 0
+    Record extraction of xml elements into caller structs.
+
+    A record descriptor maps the attributes of all elements matched by a restricted
+    path (see xml_path.h) to fields of a struct. The xml source is read once by a
+    SAX2 parser, no document is build and one array of structs per descriptor is
+    filled. Strings are copied into a string pool of the record array, so there is
+    no allocation per record.
+#endif
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>
+
+#include "xml_source.h"
+#include "xml_path.h"
+#include "xpath_utils.h"
+
+typedef enum {
+    XML_RECORD_STRING,      /* char *, copy inside the string pool of the records */
+    XML_RECORD_CHARS,       /* char[size], truncated copy, always terminated */
+    XML_RECORD_INT,         /* int, decimal integer */
+    XML_RECORD_DOUBLE,      /* double, converted like number(), NaN on error */
+    XML_RECORD_BOOL         /* bool, "true" or "1" */
+} XmlRecordFieldType;
+
+typedef struct {
+    const char          *attr;      /* attribute name */
+    XmlRecordFieldType  type;       /* field type */
+    size_t              offset;     /* offset of field inside of record */
+    size_t              size;       /* size of field, used for XML_RECORD_CHARS */
+} XmlRecordField;
+
+/* field of struct member, like XML_RECORD_FIELD(Talent, name, "name", XML_RECORD_CHARS) */
+#define XML_RECORD_FIELD(record_type, member, attr, type) \
+    { (attr), (type), offsetof(record_type, member), sizeof(((record_type *)0)->member) }
+
+typedef struct {
+    const char              *path;          /* restricted path of record elements */
+    size_t                  record_size;    /* size of record struct */
+    const XmlRecordField    *fields;        /* mapped fields */
+    int                     field_cnt;      /* number of mapped fields */
+} XmlRecordDesc;
+
+typedef struct _xml_record_chunk {
+    struct _xml_record_chunk    *next;  /* next older chunk */
+    size_t                      size;   /* usable bytes of data */
+    size_t                      used;   /* used bytes of data */
+    char                        data[]; /* string data */
+} XmlRecordChunk;
+
+typedef struct {
+    void            *records;   /* array of records, record_size each, missing attributes are 0 */
+    int             cnt;        /* number of records */
+    int             max;        /* allocated records */
+    int             errors;     /* number of attribute values which could not be converted */
+    XmlRecordChunk  *strings;   /* string pool of XML_RECORD_STRING fields */
+} XmlRecords;
+
+/*
+
+    This Function extracts records of all descriptors in one pass over the source.
+
+    Example:
+        typedef struct {
+            char    name[64];
+            char    *unit;
+            int     price;
+            double  weight;
+        } Eq;
+
+        static const XmlRecordField eq_fields[] = {
+            XML_RECORD_FIELD(Eq, name, "name", XML_RECORD_CHARS),
+            XML_RECORD_FIELD(Eq, unit, "price_unit", XML_RECORD_STRING),
+            XML_RECORD_FIELD(Eq, price, "price", XML_RECORD_INT),
+            XML_RECORD_FIELD(Eq, weight, "weight", XML_RECORD_DOUBLE)
+        };
+
+        XmlRecordDesc desc = { "//eq", sizeof(Eq), eq_fields, 4 };
+        XmlRecords records;
+
+        if ( xml_record_extract(src, &desc, 1, &records) == 0 ) {
+            Eq *eqs = records.records;
+            ... eqs[0] - eqs[records.cnt - 1]
+        }
+
+        xml_records_free(&records);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    src             xml source
+    descs           record descriptors
+    desc_cnt        number of record descriptors
+    results         desc_cnt record arrays, results[i] for descs[i]
+
+    returns 0 on success, -1 on invalid path or not well formed xml. The results are
+    initialized in every case and have to be freed by xml_records_free.
+*/
+int xml_record_extract(const XmlSource *src, const XmlRecordDesc *descs, int desc_cnt, XmlRecords *results);
+
+/*
+
+    This Function frees records and their strings. The records are empty afterwards.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    records         records to free
+
+*/
+void xml_records_free(XmlRecords *records);
+
+#endif
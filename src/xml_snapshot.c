@@ -0,0 +1,481 @@
+#include "xml_snapshot.h"
+
+#define XML_SNAPSHOT_MAGIC "XSNP"
+#define XML_SNAPSHOT_HEADER_SIZE 36
+#define XML_SNAPSHOT_NONE UINT32_MAX   /* string index of missing strings */
+
+/* node record types, the libxml node types of these nodes */
+#define XML_SNAPSHOT_END 0
+
+typedef struct {
+    unsigned char   *data;  /* written bytes */
+    size_t          len;    /* number of written bytes */
+    size_t          max;    /* allocated bytes */
+} XmlSnapshotBuffer;
+
+typedef struct {
+    xmlHashTablePtr     index;      /* string => index + 1 */
+    XmlSnapshotBuffer   strings;    /* string table */
+    uint32_t            cnt;        /* number of strings */
+    XmlSnapshotBuffer   nodes;      /* node records */
+    bool                valid;      /* document contains only supported nodes */
+} XmlSnapshotWriter;
+
+typedef struct {
+    const unsigned char *cur;       /* read position */
+    const unsigned char *end;       /* end of node records */
+    const xmlChar       **strings;  /* dictionary strings of string table */
+    uint32_t            cnt;        /* number of strings */
+    xmlDocPtr           doc;        /* document to build */
+} XmlSnapshotReader;
+
+static uint64_t __xml_snapshot_hash_add(uint64_t hash, const unsigned char *data, size_t size) {
+
+    for ( size_t cur = 0; cur < size; ++cur ) {
+        hash ^= data[cur];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+uint64_t xml_snapshot_hash(const unsigned char *data, size_t size) {
+    return __xml_snapshot_hash_add(14695981039346656037ULL, data, size);
+}
+
+/* ---------------------------------------------------------------------------------------
+    writer
+   --------------------------------------------------------------------------------------- */
+
+static void __xml_snapshot_put(XmlSnapshotBuffer *buffer, const void *data, size_t len) {
+
+    if ( buffer->len + len > buffer->max ) {
+        buffer->max = ( buffer->max == 0 ? 4096 : buffer->max );
+        while ( buffer->len + len > buffer->max ) buffer->max *= 2;
+        buffer->data = realloc(buffer->data, buffer->max);
+    }
+
+    memcpy(&buffer->data[buffer->len], data, len);
+    buffer->len += len;
+}
+
+static void __xml_snapshot_put_u8(XmlSnapshotBuffer *buffer, uint8_t value) {
+    __xml_snapshot_put(buffer, &value, 1);
+}
+
+static void __xml_snapshot_put_u32(XmlSnapshotBuffer *buffer, uint32_t value) {
+    const unsigned char bytes[4] = { value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, (value >> 24) & 0xFF };
+    __xml_snapshot_put(buffer, bytes, 4);
+}
+
+static void __xml_snapshot_put_u64(XmlSnapshotBuffer *buffer, uint64_t value) {
+    __xml_snapshot_put_u32(buffer, (uint32_t)(value & 0xFFFFFFFFU));
+    __xml_snapshot_put_u32(buffer, (uint32_t)(value >> 32));
+}
+
+/* index of string inside of string table, added on first use */
+static uint32_t __xml_snapshot_string(XmlSnapshotWriter *writer, const xmlChar *str) {
+
+    if ( str == NULL ) {
+        return XML_SNAPSHOT_NONE;
+    }
+
+    const uintptr_t found = (uintptr_t)xmlHashLookup(writer->index, str);
+
+    if ( found != 0 ) {
+        return (uint32_t)(found - 1);
+    }
+
+    const uint32_t len = (uint32_t)xmlStrlen(str);
+
+    __xml_snapshot_put_u32(&writer->strings, len);
+    __xml_snapshot_put(&writer->strings, str, len);
+
+    xmlHashAddEntry(writer->index, str, (void *)(uintptr_t)(writer->cnt + 1));
+
+    return writer->cnt++;
+}
+
+static void __xml_snapshot_put_string(XmlSnapshotWriter *writer, const xmlChar *str) {
+    __xml_snapshot_put_u32(&writer->nodes, __xml_snapshot_string(writer, str));
+}
+
+static void __xml_snapshot_write_node(XmlSnapshotWriter *writer, xmlNodePtr node) {
+
+    for ( ; node != NULL && writer->valid; node = node->next ) {
+
+        switch ( node->type ) {
+
+            case XML_ELEMENT_NODE: {
+
+                if ( node->ns != NULL || node->nsDef != NULL ) {
+                    writer->valid = false;
+                    return;
+                }
+
+                uint32_t cntAttr = 0;
+
+                for ( xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next ) {
+                    ++cntAttr;
+                }
+
+                __xml_snapshot_put_u8(&writer->nodes, XML_ELEMENT_NODE);
+                __xml_snapshot_put_string(writer, node->name);
+                __xml_snapshot_put_u32(&writer->nodes, cntAttr);
+
+                for ( xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next ) {
+
+                    if ( attr->ns != NULL ) {
+                        writer->valid = false;
+                        return;
+                    }
+
+                    xmlChar *value = xmlNodeListGetString(node->doc, attr->children, 1);
+
+                    __xml_snapshot_put_string(writer, attr->name);
+                    __xml_snapshot_put_string(writer, ( value != NULL ? value : (const xmlChar *)"" ));
+
+                    xmlFree(value);
+                }
+
+                __xml_snapshot_write_node(writer, node->children);
+                __xml_snapshot_put_u8(&writer->nodes, XML_SNAPSHOT_END);
+                break;
+            }
+
+            case XML_TEXT_NODE:
+            case XML_CDATA_SECTION_NODE:
+            case XML_COMMENT_NODE:
+                __xml_snapshot_put_u8(&writer->nodes, (uint8_t)node->type);
+                __xml_snapshot_put_string(writer, node->content);
+                break;
+
+            case XML_PI_NODE:
+                __xml_snapshot_put_u8(&writer->nodes, XML_PI_NODE);
+                __xml_snapshot_put_string(writer, node->name);
+                __xml_snapshot_put_string(writer, node->content);
+                break;
+
+            case XML_DTD_NODE:
+            case XML_XINCLUDE_START:
+            case XML_XINCLUDE_END:
+                break;
+
+            default:
+                writer->valid = false;
+                break;
+        }
+    }
+}
+
+unsigned char* xml_snapshot_write(const XmlCtx *ctx, size_t *size) {
+
+    if ( ctx == NULL || ctx->doc == NULL || size == NULL ) {
+        return NULL;
+    }
+
+    XmlSnapshotWriter writer = { xmlHashCreate(1024), { NULL, 0, 0 }, 0, { NULL, 0, 0 }, true };
+
+    const uint32_t encoding = __xml_snapshot_string(&writer, ctx->doc->encoding);
+
+    __xml_snapshot_write_node(&writer, ctx->doc->children);
+    __xml_snapshot_put_u8(&writer.nodes, XML_SNAPSHOT_END);
+
+    unsigned char *result = NULL;
+
+    if ( writer.valid ) {
+
+        XmlSnapshotBuffer out = { NULL, 0, 0 };
+
+        const uint64_t src_hash = ( ctx->src != NULL ? xml_snapshot_hash(ctx->src->src_data, *ctx->src->src_size) : 0 );
+
+        const uint64_t payload_hash = __xml_snapshot_hash_add(xml_snapshot_hash(writer.strings.data, writer.strings.len),
+                                                             writer.nodes.data, writer.nodes.len);
+
+        __xml_snapshot_put(&out, XML_SNAPSHOT_MAGIC, 4);
+        __xml_snapshot_put_u32(&out, XML_SNAPSHOT_VERSION);
+        __xml_snapshot_put_u64(&out, src_hash);
+        __xml_snapshot_put_u32(&out, writer.cnt);
+        __xml_snapshot_put_u32(&out, encoding);
+        __xml_snapshot_put_u32(&out, (uint32_t)writer.nodes.len);
+        __xml_snapshot_put_u64(&out, payload_hash);
+
+        __xml_snapshot_put(&out, writer.strings.data, writer.strings.len);
+        __xml_snapshot_put(&out, writer.nodes.data, writer.nodes.len);
+
+        result = out.data;
+        *size = out.len;
+    }
+
+    xmlHashFree(writer.index, NULL);
+    free(writer.strings.data);
+    free(writer.nodes.data);
+
+    return result;
+}
+
+int xml_snapshot_save(const XmlCtx *ctx, const char *filename) {
+
+    size_t size = 0;
+    unsigned char *data = ( filename != NULL ? xml_snapshot_write(ctx, &size) : NULL );
+
+    if ( data == NULL ) {
+        return -1;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    int result = -1;
+
+    if ( file != NULL ) {
+        result = ( fwrite(data, 1, size, file) == size ? 0 : -1 );
+        result = ( fclose(file) == 0 ? result : -1 );
+    }
+
+    free(data);
+
+    return result;
+}
+
+/* ---------------------------------------------------------------------------------------
+    reader
+   --------------------------------------------------------------------------------------- */
+
+static uint32_t __xml_snapshot_u32(const unsigned char *data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint64_t __xml_snapshot_u64(const unsigned char *data) {
+    return (uint64_t)__xml_snapshot_u32(data) | ((uint64_t)__xml_snapshot_u32(data + 4) << 32);
+}
+
+/* checks header and payload, returns start of string table or NULL */
+static const unsigned char * __xml_snapshot_check(const unsigned char *data, size_t size) {
+
+    if ( data == NULL || size < XML_SNAPSHOT_HEADER_SIZE || memcmp(data, XML_SNAPSHOT_MAGIC, 4) != 0 ||
+         __xml_snapshot_u32(data + 4) != XML_SNAPSHOT_VERSION ) {
+        return NULL;
+    }
+
+    const unsigned char *payload = data + XML_SNAPSHOT_HEADER_SIZE;
+
+    if ( xml_snapshot_hash(payload, size - XML_SNAPSHOT_HEADER_SIZE) != __xml_snapshot_u64(data + 28) ) {
+        return NULL;
+    }
+
+    return payload;
+}
+
+static bool __xml_snapshot_read_u32(XmlSnapshotReader *reader, uint32_t *value) {
+
+    if ( reader->end - reader->cur < 4 ) {
+        return false;
+    }
+
+    *value = __xml_snapshot_u32(reader->cur);
+    reader->cur += 4;
+
+    return true;
+}
+
+static bool __xml_snapshot_read_string(XmlSnapshotReader *reader, const xmlChar **str) {
+
+    uint32_t index;
+
+    if ( !__xml_snapshot_read_u32(reader, &index) || index >= reader->cnt ) {
+        return false;
+    }
+
+    *str = reader->strings[index];
+
+    return true;
+}
+
+static void __xml_snapshot_link(xmlNodePtr parent, xmlNodePtr child) {
+
+    child->parent = parent;
+    child->doc = parent->doc;
+    child->prev = parent->last;
+
+    if ( parent->last != NULL ) {
+        parent->last->next = child;
+    } else {
+        parent->children = child;
+    }
+
+    parent->last = child;
+}
+
+/* builds all nodes in one pass, the strings of nodes are dictionary strings of the document */
+static bool __xml_snapshot_read_nodes(XmlSnapshotReader *reader) {
+
+    xmlNodePtr parent = (xmlNodePtr)reader->doc;
+
+    while ( reader->cur < reader->end ) {
+
+        const uint8_t type = *reader->cur++;
+        const xmlChar *name = NULL, *content = NULL;
+        xmlNodePtr node = NULL;
+
+        switch ( type ) {
+
+            case XML_SNAPSHOT_END:
+                if ( parent == (xmlNodePtr)reader->doc ) {
+                    return reader->cur == reader->end;
+                }
+                parent = parent->parent;
+                continue;
+
+            case XML_ELEMENT_NODE: {
+
+                uint32_t cntAttr;
+
+                if ( !__xml_snapshot_read_string(reader, &name) || !__xml_snapshot_read_u32(reader, &cntAttr) ) {
+                    return false;
+                }
+
+                node = xmlNewDocNodeEatName(reader->doc, NULL, (xmlChar *)name, NULL);
+                __xml_snapshot_link(parent, node);
+
+                xmlAttrPtr last = NULL;
+
+                for ( uint32_t curattr = 0; curattr < cntAttr; ++curattr ) {
+
+                    if ( !__xml_snapshot_read_string(reader, &name) || !__xml_snapshot_read_string(reader, &content) ) {
+                        return false;
+                    }
+
+                    xmlAttrPtr attr = xmlNewDocProp(reader->doc, name, NULL);
+                    xmlNodePtr text = xmlNewDocText(reader->doc, NULL);
+
+                    text->content = (xmlChar *)content;
+                    text->parent = (xmlNodePtr)attr;
+                    attr->children = attr->last = text;
+                    attr->parent = node;
+                    attr->prev = last;
+
+                    if ( last != NULL ) {
+                        last->next = attr;
+                    } else {
+                        node->properties = attr;
+                    }
+
+                    last = attr;
+                }
+
+                parent = node;
+                continue;
+            }
+
+            case XML_TEXT_NODE:
+                if ( !__xml_snapshot_read_string(reader, &content) ) return false;
+                node = xmlNewDocText(reader->doc, NULL);
+                break;
+
+            case XML_CDATA_SECTION_NODE:
+                if ( !__xml_snapshot_read_string(reader, &content) ) return false;
+                node = xmlNewCDataBlock(reader->doc, NULL, 0);
+                break;
+
+            case XML_COMMENT_NODE:
+                if ( !__xml_snapshot_read_string(reader, &content) ) return false;
+                node = xmlNewDocComment(reader->doc, NULL);
+                break;
+
+            case XML_PI_NODE:
+                if ( !__xml_snapshot_read_string(reader, &name) || !__xml_snapshot_read_string(reader, &content) ) return false;
+                node = xmlNewDocPI(reader->doc, name, NULL);
+                break;
+
+            default:
+                return false;
+        }
+
+        node->content = (xmlChar *)content;
+        __xml_snapshot_link(parent, node);
+    }
+
+    return false;
+}
+
+static xmlDocPtr __xml_snapshot_read(const unsigned char *data, size_t size) {
+
+    const unsigned char *payload = __xml_snapshot_check(data, size);
+
+    if ( payload == NULL ) {
+        return NULL;
+    }
+
+    const unsigned char *end = data + size;
+    const uint32_t cnt = __xml_snapshot_u32(data + 16);
+    const uint32_t encoding = __xml_snapshot_u32(data + 20);
+    const uint32_t nodes_len = __xml_snapshot_u32(data + 24);
+
+    xmlDocPtr doc = xmlNewDoc((const xmlChar *)"1.0");
+    doc->dict = xmlDictCreate();
+
+    XmlSnapshotReader reader = { payload, end, malloc((cnt > 0 ? cnt : 1) * sizeof(xmlChar *)), cnt, doc };
+
+    bool valid = true;
+
+    for ( uint32_t curstr = 0; curstr < cnt && valid; ++curstr ) {
+
+        uint32_t len;
+
+        valid = __xml_snapshot_read_u32(&reader, &len) && (size_t)(reader.end - reader.cur) >= len;
+
+        if ( valid ) {
+            reader.strings[curstr] = xmlDictLookup(doc->dict, reader.cur, (int)len);
+            reader.cur += len;
+        }
+    }
+
+    valid = valid && (size_t)(reader.end - reader.cur) == nodes_len && __xml_snapshot_read_nodes(&reader);
+
+    if ( valid && encoding != XML_SNAPSHOT_NONE && encoding < cnt ) {
+        doc->encoding = xmlStrdup(reader.strings[encoding]);
+    }
+
+    free(reader.strings);
+
+    if ( !valid ) {
+        xmlFreeDoc(doc);
+        doc = NULL;
+    }
+
+    return doc;
+}
+
+XmlCtx* xml_snapshot_load(const unsigned char *data, size_t size) {
+
+    XmlCtx *ctx = xml_ctx_new_empty();
+
+    xmlFreeDoc(ctx->doc);
+    ctx->doc = __xml_snapshot_read(data, size);
+
+    if ( ctx->doc == NULL ) {
+        ctx->state.state_no = XML_CTX_ERROR;
+        ctx->state.reason = XML_CTX_READ_AND_PARSE;
+    }
+
+    return ctx;
+}
+
+XmlCtx* xml_snapshot_load_file(const char *filename) {
+
+    XmlSource *snapshot = xml_source_from_file_mapped(filename);
+
+    XmlCtx *ctx = xml_snapshot_load(( snapshot != NULL ? snapshot->src_data : NULL ), ( snapshot != NULL ? *snapshot->src_size : 0 ));
+
+    xml_source_free(&snapshot);
+
+    return ctx;
+}
+
+bool xml_snapshot_current(const unsigned char *data, size_t size, const XmlSource *src) {
+
+    if ( src == NULL || src->src_data == NULL || src->src_size == NULL || __xml_snapshot_check(data, size) == NULL ) {
+        return false;
+    }
+
+    return __xml_snapshot_u64(data + 8) == xml_snapshot_hash(src->src_data, *src->src_size);
+}
@@ -0,0 +1,113 @@
+#ifndef XML_SNAPSHOT_H
+#define XML_SNAPSHOT_H
+
+#if 0
+    Binary snapshots of parsed documents.
+
+    A snapshot is written once at build time (see Makefile target mksnapshot) and
+    loaded at startup instead of parsing xml. Loading is one linear pass over the
+    snapshot: all strings are added to the document dictionary once and the nodes
+    are linked in document order, nothing is tokenized.
+
+    Layout, all numbers little endian:
+
+        header      "XSNP", format version, hash of xml source, string count,
+                    string index of encoding, node bytes, hash of strings and nodes
+        strings     string count times: length, bytes without terminator
+        nodes       preorder node records: type byte, string indexes, attributes,
+                    children of elements are closed by an end byte
+
+    The source hash of the header detects snapshots of changed xml files, the payload
+    hash detects damaged snapshots. Namespaces, DTDs and entity references are not
+    supported by snapshots.
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <libxml/tree.h>
+#include <libxml/hash.h>
+
+#include "xml_source.h"
+#include "xml_utils.h"
+
+#define XML_SNAPSHOT_VERSION 2  /* format version, snapshots of other versions are stale */
+
+/*
+
+    This Function returns the hash of xml source data, like stored in snapshots.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    data            xml data
+    size            size of xml data
+
+    returns 64 bit FNV-1a hash
+*/
+uint64_t xml_snapshot_hash(const unsigned char *data, size_t size);
+
+/*
+
+    This Functions write a snapshot of the context document.
+
+    xml_snapshot_write      returns the snapshot in a new buffer, free it with free
+    xml_snapshot_save       writes the snapshot to filename
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context, the hash of its source is stored
+    size            target of snapshot size
+    filename        name of snapshot file
+
+    returns snapshot or NULL, 0 on success or -1 if the document could not be written
+*/
+unsigned char* xml_snapshot_write(const XmlCtx *ctx, size_t *size);
+int xml_snapshot_save(const XmlCtx *ctx, const char *filename);
+
+/*
+
+    This Functions create a context from a snapshot. The context has no source, like
+    contexts of xml_ctx_new_file. Invalid or damaged snapshots result in a context
+    with error state and without document.
+
+    xml_snapshot_load       loads snapshot data
+    xml_snapshot_load_file  loads the snapshot file filename
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    data            snapshot data
+    size            size of snapshot data
+    filename        name of snapshot file
+
+    returns new xml context in every case with given state
+*/
+XmlCtx* xml_snapshot_load(const unsigned char *data, size_t size);
+XmlCtx* xml_snapshot_load_file(const char *filename);
+
+/*
+
+    This Function checks whether a snapshot is valid and was written from the given
+    xml source data.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    data            snapshot data
+    size            size of snapshot data
+    src             xml source of the snapshot
+
+    returns true if the snapshot could be used for src, false if it is stale
+*/
+bool xml_snapshot_current(const unsigned char *data, size_t size, const XmlSource *src);
+
+#endif
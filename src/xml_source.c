@@ -1,5 +1,21 @@
+#if !defined(OS_WINDOWS) && !defined(_POSIX_C_SOURCE)
+    /* mmap and friends with -std=c11 */
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "xml_source.h"
 
+#include <pthread.h>
+
+#if defined(OS_WINDOWS)
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
 static XmlSource* xml_source_new(XmlSourceType type, ResourceFile *res_file) {
     
     XmlSource* newxml_source = NULL;
@@ -13,10 +29,120 @@ static XmlSource* xml_source_new(XmlSourceType type, ResourceFile *res_file) {
     return newxml_source;
 }
 
+typedef struct _xml_source_archive_index {
+    const ArchiveResource               *ar;    /* indexed archive */
+    ResourceSearchResult                *files; /* all decompressed files of archive */
+    xmlHashTablePtr                     names;  /* complete name => ResourceFile */
+    struct _xml_source_archive_index    *next;
+} XmlSourceArchiveIndex;
+
+static XmlSourceArchiveIndex *__xml_source_archive_indexes = NULL;
+
+/* protects the list of indexes, index and free run exclusive with lookups */
+static pthread_mutex_t __xml_source_archive_indexes_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static XmlSourceArchiveIndex* _xml_source_archive_index_get(const ArchiveResource *ar) {
+
+    XmlSourceArchiveIndex *index = __xml_source_archive_indexes;
+
+    while ( index != NULL && index->ar != ar ) {
+        index = index->next;
+    }
+
+    return index;
+}
+
+int xml_source_archive_index(ArchiveResource* ar) {
+
+    if ( ar == NULL ) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&__xml_source_archive_indexes_lock);
+
+    XmlSourceArchiveIndex *index = _xml_source_archive_index_get(ar);
+
+    if ( index == NULL ) {
+
+        ResourceSearchResult *files = archive_resource_search(ar, (const unsigned char *)".*");
+
+        if ( files == NULL ) {
+            pthread_mutex_unlock(&__xml_source_archive_indexes_lock);
+            return -1;
+        }
+
+        index = malloc(sizeof(XmlSourceArchiveIndex));
+        index->ar = ar;
+        index->files = files;
+        index->names = xmlHashCreate((int)index->files->cnt + 1);
+        index->next = __xml_source_archive_indexes;
+        __xml_source_archive_indexes = index;
+
+        for ( size_t curfile = 0; curfile < index->files->cnt; ++curfile ) {
+            ResourceFile *file = index->files->files[curfile];
+            xmlHashAddEntry(index->names, (const xmlChar *)file->complete, file);
+        }
+    }
+
+    const int cnt = xmlHashSize(index->names);
+
+    pthread_mutex_unlock(&__xml_source_archive_indexes_lock);
+
+    return cnt;
+}
+
+void xml_source_archive_index_free(const ArchiveResource* ar) {
+
+    pthread_mutex_lock(&__xml_source_archive_indexes_lock);
+
+    XmlSourceArchiveIndex **link = &__xml_source_archive_indexes;
+
+    while ( *link != NULL ) {
+
+        XmlSourceArchiveIndex *index = *link;
+
+        if ( index->ar == ar ) {
+            *link = index->next;
+
+            for ( size_t curfile = 0; curfile < index->files->cnt; ++curfile ) {
+                resource_file_free(&index->files->files[curfile]);
+            }
+
+            resource_search_result_free(&index->files);
+            xmlHashFree(index->names, NULL);
+            free(index);
+            break;
+        }
+
+        link = &index->next;
+    }
+
+    pthread_mutex_unlock(&__xml_source_archive_indexes_lock);
+}
+
 static XmlSource* _xml_source_from_res_search(ArchiveResource* ar, const char *searchname) {
     
     XmlSource *result = NULL;
 
+    pthread_mutex_lock(&__xml_source_archive_indexes_lock);
+
+    XmlSourceArchiveIndex *index = _xml_source_archive_index_get(ar);
+
+    if ( index != NULL ) {
+
+        ResourceFile *file = xmlHashLookup(index->names, (const xmlChar *)searchname);
+
+        if ( file != NULL ) {
+            result = xml_source_new(RESOURCE_FILE_INDEXED, file);
+        }
+    }
+
+    pthread_mutex_unlock(&__xml_source_archive_indexes_lock);
+
+    if ( index != NULL ) {
+        return result;
+    }
+
     ResourceSearchResult* searchresult = archive_resource_search_by_name(ar, (const unsigned char *)searchname);
 
     if ( searchresult->cnt == 1 ) {
@@ -28,14 +154,35 @@ static XmlSource* _xml_source_from_res_search(ArchiveResource* ar, const char *s
     return result;
 }
 
+/* searchname formatted into buffer, longer names are allocated */
+static XmlSource* _xml_source_from_res_format(ArchiveResource* ar, const char *path, const char *name, const char *suffix) {
+
+    XmlSource *result = NULL;
+    char buffer[256];
+
+    const int len = snprintf(buffer, sizeof(buffer), "%s%s.%s", path, name, suffix);
+
+    if ( len >= 0 && (size_t)len < sizeof(buffer) ) {
+        result = _xml_source_from_res_search(ar, buffer);
+    } else if ( len >= 0 ) {
+        char *searchname = format_string_new("%s%s.%s", path, name, suffix);
+        result = _xml_source_from_res_search(ar, searchname);
+        free(searchname);
+    }
+
+    #if debug != 0
+        printf("search resource: %s%s.%s => %s\n", path, name, suffix, ( result != NULL ? "found" : "not found" ));
+    #endif
+
+    return result;
+}
+
 XmlSource* xml_source_from_resname(ArchiveResource* ar, const char *name) {
     
     XmlSource *result = NULL;
 
     if (ar != NULL && name != NULL) {
-        char * searchname = format_string_new("xml/%s.xml", name);
-        result = _xml_source_from_res_search(ar, searchname);
-        free(searchname);
+        result = _xml_source_from_res_format(ar, "xml/", name, "xml");
     }
 
     return result;
@@ -45,13 +192,120 @@ XmlSource* xml_source_from_resname_full(ArchiveResource* ar, const char *path, c
     XmlSource *result = NULL;
 
     if (ar != NULL && name != NULL && path != NULL && suffix != NULL) {
-        char * searchname = format_string_new("%s%s.%s", path, name, suffix);
+        result = _xml_source_from_res_format(ar, path, name, suffix);
+    }
 
-        printf("search xsl: %s\n", searchname);
+    return result;
+}
 
-        result = _xml_source_from_res_search(ar, searchname);
-        
-        free(searchname);
+static XmlMappedFile* _xml_source_map_file(const char *filename) {
+
+    void *addr = NULL;
+    size_t size = 0;
+
+#if defined(OS_WINDOWS)
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if ( file == INVALID_HANDLE_VALUE ) {
+        return NULL;
+    }
+
+    LARGE_INTEGER file_size;
+
+    if ( GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 ) {
+
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+        if ( mapping != NULL ) {
+            addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            size = (size_t)file_size.QuadPart;
+            /* the view keeps the mapping alive */
+            CloseHandle(mapping);
+        }
+    }
+
+    CloseHandle(file);
+#else
+    int fd = open(filename, O_RDONLY);
+
+    if ( fd == -1 ) {
+        return NULL;
+    }
+
+    struct stat file_stat;
+
+    if ( fstat(fd, &file_stat) == 0 && file_stat.st_size > 0 ) {
+
+        size = (size_t)file_stat.st_size;
+        addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+
+        if ( addr == MAP_FAILED ) {
+            addr = NULL;
+        } else {
+            posix_madvise(addr, size, POSIX_MADV_SEQUENTIAL);
+        }
+    }
+
+    /* the mapping keeps the file open */
+    close(fd);
+#endif
+
+    if ( addr == NULL ) {
+        return NULL;
+    }
+
+    XmlMappedFile *mapped = malloc(sizeof(XmlMappedFile));
+    mapped->addr = addr;
+    mapped->size = size;
+
+    return mapped;
+}
+
+static void _xml_source_unmap_file(XmlMappedFile *mapped) {
+
+#if defined(OS_WINDOWS)
+    UnmapViewOfFile(mapped->addr);
+#else
+    munmap(mapped->addr, mapped->size);
+#endif
+
+    free(mapped);
+}
+
+XmlSource* xml_source_from_file_mapped(const char *filename) {
+
+    XmlSource *result = NULL;
+
+    XmlMappedFile *mapped = ( filename != NULL ? _xml_source_map_file(filename) : NULL );
+
+    if ( mapped != NULL ) {
+
+        XmlSource _tmp_newxml_source = { MAPPED_FILE, &mapped->size, mapped->addr, { .mapped = mapped } };
+
+        result = malloc(sizeof(XmlSource));
+
+        memcpy(result, &_tmp_newxml_source, sizeof(XmlSource));
+    }
+
+    return result;
+}
+
+XmlSource* xml_source_from_memory(const unsigned char *data, size_t size, XmlSourceOwnership ownership) {
+
+    XmlSource *result = NULL;
+
+    if ( data != NULL && size > 0 ) {
+
+        XmlMemory *memory = malloc(sizeof(XmlMemory));
+        memory->data = data;
+        memory->size = size;
+        memory->ownership = ownership;
+
+        XmlSource _tmp_newxml_source = { MEMORY, &memory->size, data, { .memory = memory } };
+
+        result = malloc(sizeof(XmlSource));
+
+        memcpy(result, &_tmp_newxml_source, sizeof(XmlSource));
     }
 
     return result;
@@ -78,6 +332,15 @@ void xml_source_free(XmlSource **source) {
         switch(_delete_source->type) {
             case RESOURCE_FILE: resource_file_free((ResourceFile**)&_delete_source->data.resfile);
                                 break;
+            case RESOURCE_FILE_INDEXED:
+                                break;
+            case MAPPED_FILE:   _xml_source_unmap_file((XmlMappedFile*)_delete_source->data.mapped);
+                                break;
+            case MEMORY:        if ( _delete_source->data.memory->ownership == XML_SOURCE_OWNED ) {
+                                    free((void*)_delete_source->data.memory->data);
+                                }
+                                free((void*)_delete_source->data.memory);
+                                break;
         }
     
         free(_delete_source);
@@ -7,18 +7,45 @@
           in this case from resource too.        
 #endif
 
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <libxml/hash.h>
+
 #include "resource.h"
 
 typedef enum {
-    RESOURCE_FILE
+    RESOURCE_FILE,
+    RESOURCE_FILE_INDEXED,  /* resource file of an archive index, not freed by xml_source_free */
+    MAPPED_FILE,
+    MEMORY
 } XmlSourceType;
 
+typedef enum {
+    XML_SOURCE_BORROWED,    /* data belongs to caller and has to live as long as the source */
+    XML_SOURCE_OWNED        /* data was allocated by malloc and is freed by xml_source_free */
+} XmlSourceOwnership;
+
+typedef struct {
+    void        *addr;  /* start of read only mapping */
+    size_t      size;   /* mapped bytes, size of file */
+} XmlMappedFile;
+
+typedef struct {
+    const unsigned char     *data;      /* xml data */
+    size_t                  size;       /* size of xml data in byte */
+    XmlSourceOwnership      ownership;  /* who frees data */
+} XmlMemory;
+
 typedef struct {
     const XmlSourceType     type;
     const size_t			  * const src_size; /* size of xml source in byte */
 	const unsigned char 	  * const src_data; /* data of xml source as byte array */
     union {
         const ResourceFile * const resfile;
+        const XmlMappedFile * const mapped;
+        const XmlMemory * const memory;
     } data;
 } XmlSource;
 
@@ -47,6 +74,42 @@ typedef struct {
 XmlSource* xml_source_from_resname(ArchiveResource* ar, const char *name);
 XmlSource* xml_source_from_resname_full(ArchiveResource* ar, const char *path, const char *name, const char *suffix);
 
+/*
+	This functions build and free the name index of an archive. All files of the
+	archive are decompressed once and kept until the index is freed. Afterwards
+	xml_source_from_resname and xml_source_from_resname_full are hash lookups
+	without searching or decompressing the archive again, the sources share the
+	decompressed files of the index.
+
+	Free the index before the archive and after all sources of the index.
+
+	The indexes are kept in a global list keyed by the address of the archive, which
+	is locked, so index, lookups and free of different archives can run in parallel.
+	xml_source_archive_index_free has to be called before the archive is freed, an
+	index which was not freed is found again by a new archive at the same address,
+	with the stale files of the freed one.
+
+    Example:
+        ArchiveResource *ar = archive_resource_memory(...);
+        xml_source_archive_index(ar);
+
+        XmlSource *talents = xml_source_from_resname(ar, "talents");
+        ...
+        xml_source_free(&talents);
+
+        xml_source_archive_index_free(ar);
+        archive_resource_free(&ar);
+
+	Parameter			Decription
+	---------			-----------------------------------------
+	ar		            resource archive to index
+	
+	returns: number of indexed files, -1 if ar is NULL or could not be searched
+	
+*/
+int xml_source_archive_index(ArchiveResource* ar);
+void xml_source_archive_index_free(const ArchiveResource* ar);
+
 /*
 	This function reads an xml source from resource_file object.
 
@@ -59,6 +122,45 @@ XmlSource* xml_source_from_resname_full(ArchiveResource* ar, const char *path, c
 */
 XmlSource* xml_source_from_resfile(ResourceFile *resfile);
 
+/*
+	This function maps the file filename read only into memory. The source data are
+	the mapped pages, so there is no read into user space buffers, like xmlReadFile
+	does, and all processes mapping the same file share the physical pages. The
+	mapping is removed by xml_source_free.
+
+	Parsing still copies the data once into the input buffer of the parser. libxml2
+	parses memory in place only if it is terminated by a zero byte, which a mapped
+	file is not.
+
+	Parameter			Decription
+	---------			-----------------------------------------
+	filename	        name of xml file
+	
+	returns: new xml source object or NULL if the file could not be mapped or is empty
+	
+*/
+XmlSource* xml_source_from_file_mapped(const char *filename);
+
+/*
+	This function creates a source of xml data in memory, like a received request
+	payload. The data are not copied by the source, parsing copies them once into
+	the input buffer of the parser, like for mapped files.
+
+    Example:
+        XmlSource *borrowed = xml_source_from_memory(buffer, len, XML_SOURCE_BORROWED);
+        XmlSource *owned = xml_source_from_memory(strdup(payload), len, XML_SOURCE_OWNED);
+
+	Parameter			Decription
+	---------			-----------------------------------------
+	data		        xml data
+	size		        size of xml data in byte
+	ownership	        XML_SOURCE_OWNED if xml_source_free has to free data
+	
+	returns: new xml source object or NULL if data is NULL or size is 0
+	
+*/
+XmlSource* xml_source_from_memory(const unsigned char *data, size_t size, XmlSourceOwnership ownership);
+
 /*
 	The function "xml_source_free" frees the memory of xml source complete.
 	
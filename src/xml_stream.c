@@ -0,0 +1,158 @@
+#include "xml_stream.h"
+
+static const xmlChar * __xml_stream_attr(void *element, const xmlChar *name) {
+
+    xmlTextReaderPtr reader = element;
+
+    const xmlChar *value = NULL;
+
+    if ( xmlTextReaderMoveToAttribute(reader, name) == 1 ) {
+
+        /* like xpath, namespace declarations are no attributes */
+        if ( xmlTextReaderIsNamespaceDecl(reader) != 1 ) {
+            value = xmlTextReaderConstValue(reader);
+        }
+
+        xmlTextReaderMoveToElement(reader);
+    }
+
+    return value;
+}
+
+int xml_stream_reader(xmlTextReaderPtr reader, const XmlPath *path, XmlStreamFunc func, void *data) {
+
+    if ( reader == NULL || path == NULL || func == NULL ) {
+        return -1;
+    }
+
+    /* states[depth] is the state of the parent of elements at depth */
+    int max_depth = 32;
+    XmlPathState *states = malloc(max_depth * sizeof(XmlPathState));
+    states[0] = xml_path_start(path);
+
+    int cnt = 0;
+    int ret = xmlTextReaderRead(reader);
+
+    while ( ret == 1 ) {
+
+        if ( xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT ) {
+
+            const int depth = xmlTextReaderDepth(reader);
+
+            if ( depth + 1 >= max_depth ) {
+                max_depth *= 2;
+                states = realloc(states, max_depth * sizeof(XmlPathState));
+            }
+
+            /* like xpath names do not match elements of a namespace, only * does */
+            const xmlChar *name = ( xmlTextReaderConstNamespaceUri(reader) == NULL ? xmlTextReaderConstLocalName(reader) : NULL );
+
+            const XmlPathState state = xml_path_step(path, states[depth], name, __xml_stream_attr, reader);
+
+            if ( xml_path_matched(path, state) ) {
+
+                xmlNodePtr node = xmlTextReaderExpand(reader);
+
+                if ( node == NULL ) {
+                    ret = -1;
+                    break;
+                }
+
+                ++cnt;
+
+                if ( !func(node, data) ) {
+                    break;
+                }
+
+                ret = xmlTextReaderNext(reader);
+                continue;
+            }
+
+            if ( xml_path_dead(path, state) ) {
+                ret = xmlTextReaderNext(reader);
+                continue;
+            }
+
+            states[depth + 1] = state;
+        }
+
+        ret = xmlTextReaderRead(reader);
+    }
+
+    free(states);
+
+    return ( ret == -1 ? -1 : cnt );
+}
+
+/* keeps the first error, or the last warning if there was no error */
+static void __xml_stream_error(void *data, xmlErrorPtr error) {
+
+    xmlErrorPtr captured = data;
+
+    if ( captured->code == XML_ERR_OK || captured->level < XML_ERR_ERROR ) {
+        xmlResetError(captured);
+        xmlCopyError(error, captured);
+    }
+}
+
+static int __xml_stream_run(xmlTextReaderPtr reader, const char *path, XmlStreamFunc func, void *data, xmlErrorPtr error) {
+
+    xmlError captured;
+    memset(&captured, 0, sizeof(xmlError));
+
+    /* errors are captured instead of printed */
+    xmlTextReaderSetStructuredErrorHandler(reader, __xml_stream_error, &captured);
+
+    XmlPath *xml_path = xml_path_new(path);
+
+    int result = xml_stream_reader(reader, xml_path, func, data);
+
+    xml_path_free(&xml_path);
+    xmlFreeTextReader(reader);
+
+    if ( error != NULL ) {
+        *error = captured;
+    } else {
+        xmlResetError(&captured);
+    }
+
+    return result;
+}
+
+int xml_stream_source(const XmlSource *src, const char *path, XmlStreamFunc func, void *data) {
+    return xml_stream_source_error(src, path, func, data, NULL);
+}
+
+int xml_stream_source_error(const XmlSource *src, const char *path, XmlStreamFunc func, void *data, xmlErrorPtr error) {
+
+    if ( error != NULL ) {
+        memset(error, 0, sizeof(xmlError));
+    }
+
+    if ( src == NULL || src->src_data == NULL || src->src_size == NULL || *src->src_size == 0 ) {
+        return -1;
+    }
+
+    xmlTextReaderPtr reader = xmlReaderForMemory((const char *)src->src_data, *src->src_size, "noname.xml", NULL, 0);
+
+    return ( reader != NULL ? __xml_stream_run(reader, path, func, data, error) : -1 );
+}
+
+int xml_stream_file(const char *filename, const char *path, XmlStreamFunc func, void *data) {
+    return xml_stream_file_error(filename, path, func, data, NULL);
+}
+
+int xml_stream_file_error(const char *filename, const char *path, XmlStreamFunc func, void *data, xmlErrorPtr error) {
+
+    if ( error != NULL ) {
+        memset(error, 0, sizeof(xmlError));
+    }
+
+    if ( filename == NULL ) {
+        return -1;
+    }
+
+    xmlTextReaderPtr reader = xmlReaderForFile(filename, "UTF-8", 0);
+
+    return ( reader != NULL ? __xml_stream_run(reader, path, func, data, error) : -1 );
+}
@@ -0,0 +1,78 @@
+#ifndef XML_STREAM_H
+#define XML_STREAM_H
+
+#if 0
+    Streaming queries without building a document.
+
+    The xml input is read by xmlTextReader. Each element is matched against a
+    restricted path (see xml_path.h) while it is read, subtrees which can not contain
+    a match are skipped. Matching elements are expanded and passed to a callback,
+    so only the current subtree is held in memory.
+
+    Elements inside of a matching subtree are not reported again. Like xpath, names
+    of the path do not match elements of a namespace, only * does.
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <libxml/tree.h>
+#include <libxml/xmlreader.h>
+
+#include "xml_source.h"
+#include "xml_path.h"
+
+/*
+    Callback for matching elements. The subtree of node is only valid while the callback
+    runs, it has to be copied to keep it (xmlDocCopyNode). Returning false stops the
+    stream.
+*/
+typedef bool (*XmlStreamFunc)(xmlNodePtr node, void *data);
+
+/*
+
+    This Functions stream the xml input and call func with every element matched by path.
+
+    xml_stream_source   reads xml source data
+    xml_stream_file     reads the file filename
+    xml_stream_reader   reads the given reader, it is not freed and keeps its error
+                        handlers
+
+    Errors of the input are not printed. The _error variants return the first error,
+    or the last warning if there was no error, which has to be released by
+    xmlResetError. The code is XML_ERR_OK without.
+
+    Example:
+        static bool print_eq(xmlNodePtr node, void *data) {
+            xmlChar *name = xmlGetProp(node, (const xmlChar *)"name");
+            printf("%s\n", name);
+            xmlFree(name);
+            return true;
+        }
+
+        int cnt = xml_stream_file("equipments.xml", "//eq[@price_unit = 'S']", print_eq, NULL);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    src             xml source
+    filename        name of xml file
+    reader          xml text reader
+    path            restricted location path, see xml_path.h
+    func            callback of matching elements
+    data            user data passed to func
+    error           target of captured error or NULL
+
+    returns number of matching elements passed to func, -1 if path is not supported or
+    the input is not well formed. Elements found until an error was detected are passed
+    to func.
+*/
+int xml_stream_source(const XmlSource *src, const char *path, XmlStreamFunc func, void *data);
+int xml_stream_source_error(const XmlSource *src, const char *path, XmlStreamFunc func, void *data, xmlErrorPtr error);
+int xml_stream_file(const char *filename, const char *path, XmlStreamFunc func, void *data);
+int xml_stream_file_error(const char *filename, const char *path, XmlStreamFunc func, void *data, xmlErrorPtr error);
+int xml_stream_reader(xmlTextReaderPtr reader, const XmlPath *path, XmlStreamFunc func, void *data);
+
+#endif
@@ -1,12 +1,95 @@
 #include "xml_utils.h"
+#include "xml_index.h"
+#include "xml_path.h"
+#include "xml_column.h"
+
+#include <pthread.h>
 
 static XmlCtx* __xml_ctx_create(const XmlSource *xml_src, xmlDocPtr doc) {
-    XmlCtx temp = {xml_src, doc, {XML_CTX_SUCCESS, XML_CTX_NO_REASON}};
+    XmlCtx temp = {xml_src, doc, {XML_CTX_SUCCESS, XML_CTX_NO_REASON}, NULL, NULL, 0, NULL, NULL, NULL, NULL, 0, { 0 }};
     XmlCtx * new_ctx = malloc(sizeof(XmlCtx));
     memcpy(new_ctx, &temp, sizeof(XmlCtx));
     return new_ctx;
 }
 
+static void __xml_ctx_free_members(XmlCtx * ctx) {
+    
+    if (ctx->doc) {
+        xmlFreeDoc(ctx->doc);
+    }
+
+    xpath_comp_cache_free(&ctx->xpath_cache);
+
+    xml_ctx_index_free_all(ctx);
+
+    xml_ctx_column_cache_free(ctx);
+
+    if (ctx->views) {
+        xmlDictFree(ctx->views);
+        ctx->views = NULL;
+    }
+
+    xmlResetError(&ctx->error);
+
+    if (ctx->xpath_ctx) {
+        XPathFuncCache *func_cache = ctx->xpath_ctx->userData;
+        xpath_func_cache_free(&func_cache);
+
+        xmlXPathFreeContext(ctx->xpath_ctx);
+        ctx->xpath_ctx = NULL;
+    }
+}
+
+static xmlXPathContextPtr __xml_ctx_xpath_ctx(XmlCtx * ctx) {
+
+    xmlXPathContextPtr xpathCtx = ctx->xpath_ctx;
+
+    if ( xpathCtx == NULL ) {
+
+        xpathCtx = xmlXPathNewContext(ctx->doc);
+
+        if ( xpathCtx == NULL ) {
+            return NULL;
+        }
+
+        xmlXPathRegisterAllFunctions(xpathCtx);
+        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "regexmatch", regexmatch_xpath_func);
+        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "max", max_xpath_func);
+        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "min", min_xpath_func);
+        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "avg", avg_xpath_func);
+        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "total", sum_xpath_func);
+        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "in_range", str_in_range_xpath_func); 
+        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "key", key_xpath_func);
+
+        /* reuse of xpath objects between executions */
+        xmlXPathContextSetCache(xpathCtx, 1, -1, 0);
+
+        /* compiled regex patterns and other per call work of the extension functions */
+        XPathFuncCache *func_cache = xpath_func_cache_new();
+        func_cache->owner = ctx;
+        xpathCtx->userData = func_cache;
+
+        ctx->xpath_ctx = xpathCtx;
+    }
+
+    /* the evaluation leaves no state behind, except the document may be exchanged */
+    xpathCtx->doc = ctx->doc;
+    xpathCtx->node = NULL;
+    xpathCtx->contextSize = -1;
+    xpathCtx->proximityPosition = -1;
+
+    return xpathCtx;
+}
+
+static xmlXPathCompExprPtr __xml_ctx_xpath_compile(XmlCtx * ctx, const char *xpath) {
+
+    if ( ctx->xpath_cache == NULL ) {
+        ctx->xpath_cache = xpath_comp_cache_new(XML_CTX_XPATH_CACHE_SIZE);
+    }
+
+    return xpath_comp_cache_get(ctx->xpath_cache, (const xmlChar *)xpath);
+}
+
 static void __xml_ctx_set_state(XmlCtx * ctx,  XmlCtxStateNo state_no, XmlCtxStateReason  reason ) {
     ctx->state.state_no = state_no;
     ctx->state.reason   = reason;
@@ -47,10 +130,12 @@ static bool __xml_ctx_xpath_valid( XmlCtx *ctx, const char *xpath) {
     return isvalid;
 }
 
-static void __xml_ctx_attr_str_xpptr(xmlXPathObjectPtr node, const unsigned char *value) {
+static void __xml_ctx_attr_str_xpptr(XmlCtx *ctx, xmlXPathObjectPtr node, const unsigned char *value) {
 
     if ( xml_xpath_has_result(node) ) {
 
+        const unsigned long version = ctx->version;
+
         const int maxNodes = node->nodesetval->nodeNr;
 
         xmlNodePtr *nodes = node->nodesetval->nodeTab;
@@ -61,17 +146,26 @@ static void __xml_ctx_attr_str_xpptr(xmlXPathObjectPtr node, const unsigned char
             
             if (node->type == XML_ATTRIBUTE_NODE) {
 
+                xml_ctx_index_attr_changing(ctx, node->parent, node->name, (const xmlChar*)value);
+
                 xmlSetProp(node->parent, node->name, (xmlChar*)value);
             
             }
         
         }
+
+        xml_ctx_doc_changed(ctx);
+
+        /* indexes are updated above, they are not outdated by this change */
+        xml_ctx_index_keep(ctx, version);
     }
 }
 
-static void __xml_ctx_content_xpptr(xmlXPathObjectPtr node, const unsigned char *value) {
+static void __xml_ctx_content_xpptr(XmlCtx *ctx, xmlXPathObjectPtr node, const unsigned char *value) {
 
     if ( xml_xpath_has_result(node) ) {
+
+        xml_ctx_doc_changed(ctx);
         
         const int maxNodes = node->nodesetval->nodeNr;
 
@@ -97,6 +191,95 @@ static void __xml_ctx_content_xpptr(xmlXPathObjectPtr node, const unsigned char
 
 }
 
+static void __xml_ctx_rem_nodes(XmlCtx *ctx, xmlXPathObjectPtr found) {
+
+    if ( xml_xpath_has_result(found) ) {
+        xml_ctx_doc_changed(ctx);
+    }
+
+    xml_ctx_rem_nodes_xpres(found);
+}
+
+static void __xml_ctx_add_node(XmlCtx *dst, xmlNodePtr src_node, xmlXPathObjectPtr target_node_result) {
+
+    if ( xml_xpath_has_result(target_node_result) ) {
+        xml_ctx_doc_changed(dst);
+    }
+
+    xml_ctx_nodes_add_note_xpres(src_node, target_node_result);
+}
+
+static xmlChar * __xml_ctx_xpres_attr(xmlXPathObjectPtr found, const unsigned char *attr_name) {
+
+    xmlChar *value = NULL;
+
+    if (xml_xpath_has_result(found)) {
+        value = xmlGetProp(found->nodesetval->nodeTab[0], (const xmlChar*)attr_name);
+    }
+
+    return value;
+}
+
+#define XML_CTX_ATTR_NAME_CHARS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-."
+
+/* restricted paths (see xml_path.h), optionally followed by /@name, are walked up to the first match */
+static bool __xml_ctx_first_path(const XmlCtx *ctx, const char *xpath, xmlNodePtr *first) {
+
+    XmlPath *path = xml_path_new(xpath);
+    const char *attr = NULL;
+
+    if ( path == NULL ) {
+
+        const char *last = strrchr(xpath, '/');
+
+        if ( last == NULL || last[1] != '@' || last[2] == '\0' || last[strspn(last + 2, XML_CTX_ATTR_NAME_CHARS) + 2] != '\0' ) {
+            return false;
+        }
+
+        /* /path/@name selects the attribute of the first /path[@name] */
+        const size_t leadingLen = (size_t)(last - xpath);
+        const size_t nameLen = strlen(last + 2);
+        char *leading = malloc(leadingLen + nameLen + 4);
+
+        memcpy(leading, xpath, leadingLen);
+        memcpy(leading + leadingLen, "[@", 2);
+        memcpy(leading + leadingLen + 2, last + 2, nameLen);
+        memcpy(leading + leadingLen + 2 + nameLen, "]", 2);
+
+        path = xml_path_new(leading);
+
+        free(leading);
+
+        if ( path == NULL ) {
+            return false;
+        }
+
+        attr = last + 2;
+    }
+
+    xmlNodePtr element = xml_path_first(path, ctx->doc);
+
+    /* the attribute without namespace, which was matched by the predicate */
+    *first = ( element != NULL && attr != NULL ? (xmlNodePtr)xmlHasNsProp(element, (const xmlChar *)attr, NULL) : element );
+
+    xml_path_free(&path);
+
+    return true;
+}
+
+static int __xml_ctx_xpres_tod(xmlXPathObjectPtr found, double *result) {
+
+    int errNo = 1;
+
+    if ( found && ( xml_xpath_has_result(found) || found->type == XPATH_NUMBER))
+    {
+        *result = xmlXPathCastToNumber(found);
+        errNo = ( isnan(*result) ? 1 : 0);
+    }
+
+    return errNo;
+}
+
 #if 0
 //
 // EOF private section
@@ -126,33 +309,225 @@ XmlCtx* xml_ctx_new_empty_root_name(const char* rootname) {
 }
 
 
+/* libxml parser options of XmlCtxOption combination */
+static int __xml_ctx_parse_options(int options) {
+
+    /* errors are kept by the context, see xml_ctx_error */
+    int parse_options = XML_PARSE_NOERROR | XML_PARSE_NOWARNING;
+
+    if ( options & XML_CTX_OPT_NOBLANKS ) parse_options |= XML_PARSE_NOBLANKS;
+    if ( options & XML_CTX_OPT_COMPACT )  parse_options |= XML_PARSE_COMPACT;
+    if ( options & XML_CTX_OPT_HUGE )     parse_options |= XML_PARSE_HUGE;
+    if ( options & XML_CTX_OPT_NODICT )   parse_options |= XML_PARSE_NODICT;
+
+    return parse_options;
+}
+
+/* replaces single text attribute values by their dictionary string */
+static void __xml_ctx_intern_values(xmlDocPtr doc) {
+
+    xmlDictPtr dict = doc->dict;
+    xmlNodePtr root = xmlDocGetRootElement(doc);
+    xmlNodePtr cur = root;
+
+    while ( cur != NULL ) {
+
+        if ( cur->type == XML_ELEMENT_NODE ) {
+
+            for ( xmlAttrPtr attr = cur->properties; attr != NULL; attr = attr->next ) {
+
+                xmlNodePtr text = attr->children;
+
+                if ( text != NULL && text->next == NULL && text->type == XML_TEXT_NODE && text->content != NULL &&
+                     text->content != (xmlChar *)&text->properties && !xmlDictOwns(dict, text->content) ) {
+
+                    const xmlChar *interned = xmlDictLookup(dict, text->content, -1);
+
+                    if ( interned != NULL ) {
+                        xmlFree(text->content);
+                        text->content = (xmlChar *)interned;
+                    }
+                }
+            }
+
+            if ( cur->children != NULL ) {
+                cur = cur->children;
+                continue;
+            }
+        }
+
+        while ( cur != root && cur->next == NULL ) {
+            cur = cur->parent;
+        }
+
+        cur = ( cur != root ? cur->next : NULL );
+    }
+}
+
+/* keeps the first error, warnings only until an error occurs */
+static void __xml_ctx_read_error(void *data, xmlErrorPtr error) {
+
+    xmlParserCtxtPtr ctxt = data;
+    xmlErrorPtr captured = ctxt->_private;
+
+    if ( captured->code == XML_ERR_OK || captured->level < XML_ERR_ERROR ) {
+        xmlResetError(captured);
+        xmlCopyError(error, captured);
+    }
+}
+
+/*
+    parses the source or, without source, the file with an own parser context. The error
+    is captured by the parser context, so neither errors of former parses nor parses
+    of other threads are mixed in.
+*/
+static xmlDocPtr __xml_ctx_read(const XmlSource *xml_src, const char *filename, xmlDictPtr dict, int options, xmlErrorPtr error) {
+
+    xmlDocPtr doc = NULL;
+    xmlParserCtxtPtr ctxt = xmlNewParserCtxt();
+
+    if ( ctxt == NULL ) {
+        return NULL;
+    }
+
+    if ( dict != NULL ) {
+        /* xmlCtxtReadMemory resets the context, which looks up its names in the new dictionary */
+        xmlDictFree(ctxt->dict);
+        xmlDictReference(dict);
+        ctxt->dict = dict;
+        options &= ~XML_CTX_OPT_NODICT;
+    }
+
+    /* the parser passes itself as user data of the handler */
+    ctxt->_private = error;
+    ctxt->sax->serror = __xml_ctx_read_error;
+
+    if ( xml_src != NULL ) {
+        doc = xmlCtxtReadMemory(ctxt, (const char *)xml_src->src_data, *xml_src->src_size, "noname.xml", NULL, 
+                                __xml_ctx_parse_options(options));
+    } else {
+        doc = xmlCtxtReadFile(ctxt, filename, "UTF-8", __xml_ctx_parse_options(options));
+    }
+
+    /* like xmlReadMemory, only documents which are not well formed fail, errors like
+       undefined namespace prefixes are kept with the document */
+    if ( !ctxt->wellFormed ) {
+        xmlFreeDoc(doc);
+        doc = NULL;
+    }
+
+    xmlFreeParserCtxt(ctxt);
+
+    if ( doc != NULL && doc->dict != NULL && (options & XML_CTX_OPT_INTERN_VALUES) ) {
+        __xml_ctx_intern_values(doc);
+    }
+
+    return doc;
+}
+
 XmlCtx* xml_ctx_new(const XmlSource *xml_src) {
+    return xml_ctx_new_dict(xml_src, NULL, XML_CTX_OPT_NONE);
+}
+
+XmlCtx* xml_ctx_new_opts(const XmlSource *xml_src, int options) {
+    return xml_ctx_new_dict(xml_src, NULL, options);
+}
+
+XmlCtx* xml_ctx_new_dict(const XmlSource *xml_src, xmlDictPtr dict, int options) {
 
     xmlDocPtr doc = NULL;
 
     XmlCtxStateNo state_no = XML_CTX_SUCCESS; 
     XmlCtxStateReason reason = XML_CTX_READ_AND_PARSE;
 
-    if ( xml_src != NULL && xml_src->src_data != NULL && *xml_src->src_size > 0 ) {
+    xmlError error;
+    memset(&error, 0, sizeof(xmlError));
 
-        doc = xmlReadMemory((const char *)xml_src->src_data, *xml_src->src_size, "noname.xml", NULL, 0);
-        
-    } else {
-        state_no = XML_CTX_ERROR; 
+    if ( xml_src != NULL && xml_src->src_data != NULL && *xml_src->src_size > 0 ) {
+        doc = __xml_ctx_read(xml_src, NULL, dict, options, &error);
     }
     
-    if ( xmlGetLastError() != NULL ) {
+    if ( doc == NULL ) {
         state_no = XML_CTX_ERROR; 
-        xmlFreeDoc(doc);
-        doc = NULL;
     }
 
     XmlCtx *new_ctx = __xml_ctx_create(xml_src, doc);
+    new_ctx->error = error;
     __xml_ctx_set_state_ptr(new_ctx, &state_no, &reason);
 
     return new_ctx;
 }
 
+typedef struct _xml_ctx_archive_dict {
+    const ArchiveResource           *ar;    /* archive of shared dictionary */
+    xmlDictPtr                      dict;   /* dictionary reference of registry */
+    struct _xml_ctx_archive_dict    *next;
+} XmlCtxArchiveDict;
+
+static XmlCtxArchiveDict *__xml_ctx_archive_dicts = NULL;
+
+/* protects the registry, not the dictionaries */
+static pthread_mutex_t __xml_ctx_archive_dicts_lock = PTHREAD_MUTEX_INITIALIZER;
+
+xmlDictPtr xml_ctx_archive_dict(const ArchiveResource *ar) {
+
+    if ( ar == NULL ) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&__xml_ctx_archive_dicts_lock);
+
+    XmlCtxArchiveDict *entry = __xml_ctx_archive_dicts;
+
+    while ( entry != NULL && entry->ar != ar ) {
+        entry = entry->next;
+    }
+
+    if ( entry == NULL ) {
+        entry = malloc(sizeof(XmlCtxArchiveDict));
+        entry->ar = ar;
+        entry->dict = xmlDictCreate();
+        entry->next = __xml_ctx_archive_dicts;
+        __xml_ctx_archive_dicts = entry;
+    }
+
+    xmlDictPtr dict = entry->dict;
+
+    pthread_mutex_unlock(&__xml_ctx_archive_dicts_lock);
+
+    return dict;
+}
+
+void xml_ctx_archive_dict_free(const ArchiveResource *ar) {
+
+    pthread_mutex_lock(&__xml_ctx_archive_dicts_lock);
+
+    XmlCtxArchiveDict **link = &__xml_ctx_archive_dicts;
+
+    while ( *link != NULL ) {
+
+        XmlCtxArchiveDict *entry = *link;
+
+        if ( entry->ar == ar ) {
+            *link = entry->next;
+            xmlDictFree(entry->dict);
+            free(entry);
+            break;
+        }
+
+        link = &entry->next;
+    }
+
+    pthread_mutex_unlock(&__xml_ctx_archive_dicts_lock);
+}
+
+XmlCtx* xml_ctx_new_archive(ArchiveResource *ar, const char *name, int options) {
+
+    XmlSource *xml_src = xml_source_from_resname(ar, name);
+
+    return xml_ctx_new_dict(xml_src, xml_ctx_archive_dict(ar), options);
+}
+
 XmlCtx* xml_ctx_new_node(const xmlNodePtr rootnode) {
     XmlCtx *new_ctx = xml_ctx_new_empty();
     xmlNodePtr copyroot = xmlCopyNode(rootnode, 1);
@@ -161,15 +536,25 @@ XmlCtx* xml_ctx_new_node(const xmlNodePtr rootnode) {
 }
 
 XmlCtx* xml_ctx_new_file(const char *filename) 
+{
+    return xml_ctx_new_file_opts(filename, XML_CTX_OPT_NONE);
+}
+
+XmlCtx* xml_ctx_new_file_opts(const char *filename, int options) 
 {
     XmlCtx *new_ctx = xml_ctx_new_empty();
     
     XmlCtxStateNo state_no = XML_CTX_SUCCESS; 
     XmlCtxStateReason reason = XML_CTX_READ_AND_PARSE;
 
-    if (u_file_exists(filename) && (xmlGetLastError() == NULL))
+    if (u_file_exists(filename))
     {
-        new_ctx->doc = xmlReadFile(filename, "UTF-8", 0);
+        xmlFreeDoc(new_ctx->doc);
+        new_ctx->doc = __xml_ctx_read(NULL, filename, NULL, options, &new_ctx->error);
+
+        if ( new_ctx->doc == NULL ) {
+            state_no = XML_CTX_ERROR;
+        }
     }
     else 
     {
@@ -212,10 +597,7 @@ void free_xml_ctx(XmlCtx **ctx) {
     if ( ctx != NULL && *ctx != NULL ) {
         XmlCtx *todelete_ctx = *ctx;
         
-        if (todelete_ctx->doc) {
-            xmlDocGetRootElement(todelete_ctx->doc);
-            xmlFreeDoc(todelete_ctx->doc);
-        }
+        __xml_ctx_free_members(todelete_ctx);
 
         free(todelete_ctx);
         *ctx = NULL;
@@ -225,10 +607,7 @@ void free_xml_ctx_ptr(XmlCtx *ctx) {
     if ( ctx != NULL ) {
         XmlCtx *todelete_ctx = ctx;
         
-        if (todelete_ctx->doc) {
-            xmlDocGetRootElement(todelete_ctx->doc);
-            xmlFreeDoc(todelete_ctx->doc);
-        }
+        __xml_ctx_free_members(todelete_ctx);
 
         free(todelete_ctx);
     }
@@ -248,30 +627,163 @@ void free_xml_ctx_src(XmlCtx **ctx) {
     }
 }
 
+const xmlError* xml_ctx_error(const XmlCtx *ctx) {
+    return ( ctx != NULL && ctx->error.code != XML_ERR_OK ? &ctx->error : NULL );
+}
+
+void xml_ctx_doc_changed(XmlCtx *ctx) {
+    if ( ctx != NULL ) {
+        ++ctx->version;
+    }
+}
+
 xmlXPathObjectPtr xml_ctx_xpath( const XmlCtx *ctx, const char *xpath) {
+    return xml_ctx_xpath_node(ctx, NULL, xpath);
+}
+
+xmlXPathObjectPtr xml_ctx_xpath_node(const XmlCtx *ctx, xmlNodePtr node, const char *xpath) {
 
     xmlXPathObjectPtr result = NULL;
 
     if(ctx->doc && xpath) {
         
-        xmlXPathContextPtr xpathCtx = xmlXPathNewContext(ctx->doc);
-        xmlXPathRegisterAllFunctions(xpathCtx);
-        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "regexmatch", regexmatch_xpath_func);
-        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "max", max_xpath_func);
-        xmlXPathRegisterFunc(xpathCtx,(const xmlChar *) "in_range", str_in_range_xpath_func); 
+        xmlXPathCompExprPtr comp = __xml_ctx_xpath_compile((XmlCtx *)ctx, xpath);
+
+        if ( comp == NULL ) {
+            return result;
+        }
+
+        xmlXPathContextPtr xpathCtx = __xml_ctx_xpath_ctx((XmlCtx *)ctx);
 
         if ( xpathCtx != NULL ) {
+
+            xpathCtx->node = node;
             
-            result = xmlXPathEvalExpression((const xmlChar*)xpath, xpathCtx);
+            result = xmlXPathCompiledEval(comp, xpathCtx);
                             
         }
-        
-        xmlXPathFreeContext(xpathCtx);
     }
 
     return result;
 }
 
+xmlXPathObjectPtr xml_ctx_query(const XmlCtx *ctx, XPathQuery *query) {
+
+    xmlXPathObjectPtr result = NULL;
+
+    if ( ctx != NULL && ctx->doc && query != NULL ) {
+
+        xmlXPathContextPtr xpathCtx = __xml_ctx_xpath_ctx((XmlCtx *)ctx);
+
+        if ( xpathCtx != NULL ) {
+
+            xmlXPathRegisterVariableLookup(xpathCtx, xpath_query_var_lookup, query);
+
+            result = xmlXPathCompiledEval(xpath_query_comp(query, xpathCtx->userData), xpathCtx);
+
+            xmlXPathRegisterVariableLookup(xpathCtx, NULL, NULL);
+        }
+    }
+
+    return result;
+}
+
+bool xml_ctx_query_exist(XmlCtx *ctx, XPathQuery *query) {
+
+    xmlXPathObjectPtr found = xml_ctx_query(ctx, query);
+
+    bool exist = xml_xpath_has_result(found);
+
+    xmlXPathFreeObject(found);
+
+    return exist;
+}
+
+xmlChar * xml_ctx_query_get_attr(XmlCtx *ctx, const unsigned char *attr_name, XPathQuery *query) {
+
+    xmlXPathObjectPtr found = xml_ctx_query(ctx, query);
+
+    xmlChar *value = __xml_ctx_xpres_attr(found, attr_name);
+
+    xmlXPathFreeObject(found);
+
+    return value;
+}
+
+int xml_ctx_query_tod(XmlCtx *ctx, double *result, XPathQuery *query) {
+
+    xmlXPathObjectPtr found = xml_ctx_query(ctx, query);
+
+    int errNo = __xml_ctx_xpres_tod(found, result);
+
+    xmlXPathFreeObject(found);
+
+    return errNo;
+}
+
+void xml_ctx_query_remove(XmlCtx *ctx, XPathQuery *query) {
+
+    xmlXPathObjectPtr found = xml_ctx_query(ctx, query);
+
+    __xml_ctx_rem_nodes(ctx, found);
+
+    xmlXPathFreeObject(found);
+}
+
+int xml_ctx_xpath_register_func(XmlCtx *ctx, const char *name, xmlXPathFunction func) {
+    return xml_ctx_xpath_register_func_ns(ctx, name, NULL, func);
+}
+
+int xml_ctx_xpath_register_func_ns(XmlCtx *ctx, const char *name, const char *ns_uri, xmlXPathFunction func) {
+
+    int result = -1;
+
+    if ( ctx != NULL && name != NULL ) {
+
+        xmlXPathContextPtr xpathCtx = __xml_ctx_xpath_ctx(ctx);
+
+        if ( xpathCtx != NULL ) {
+            /* libxml does not replace existing entries, so drop the old one first */
+            xmlXPathRegisterFuncNS(xpathCtx, (const xmlChar *)name, (const xmlChar *)ns_uri, NULL);
+
+            /* compiled expressions keep the resolved function */
+            xpath_comp_cache_clear(ctx->xpath_cache);
+            xpath_func_cache_funcs_changed(xpathCtx->userData);
+
+            result = ( func == NULL ? 0 : xmlXPathRegisterFuncNS(xpathCtx, (const xmlChar *)name, (const xmlChar *)ns_uri, func) );
+        }
+    }
+
+    return result;
+}
+
+void xml_ctx_xpath_cache_stats(const XmlCtx *ctx, XPathCompCacheStats *stats) {
+
+    if ( ctx != NULL && stats != NULL ) {
+
+        if ( ctx->xpath_cache != NULL ) {
+            memcpy(stats, &ctx->xpath_cache->stats, sizeof(XPathCompCacheStats));
+        } else {
+            memset(stats, 0, sizeof(XPathCompCacheStats));
+            stats->capacity = XML_CTX_XPATH_CACHE_SIZE;
+        }
+
+    }
+}
+
+void xml_ctx_xpath_cache_resize(XmlCtx *ctx, size_t capacity) {
+
+    if ( ctx != NULL ) {
+
+        if ( ctx->xpath_cache == NULL ) {
+            ctx->xpath_cache = xpath_comp_cache_new(capacity);
+        } else {
+            xpath_comp_cache_resize(ctx->xpath_cache, capacity);
+        }
+
+    }
+}
+
 
 xmlXPathObjectPtr xml_ctx_xpath_format( const XmlCtx *ctx, const char *xpath_format, ...) {
     
@@ -323,6 +835,8 @@ void xml_ctx_nodes_add_xpath(XmlCtx *src, const char *src_xpath, XmlCtx *dst, co
 
         if ( xml_xpath_has_result(dstxpres) ) {
 
+            xml_ctx_doc_changed(dst);
+
             for(int cursrcnum = 0; cursrcnum < numsrcs; ++cursrcnum) {
                 
                 #if debug > 1
@@ -351,7 +865,8 @@ void xml_ctx_nodes_add_xpath(XmlCtx *src, const char *src_xpath, XmlCtx *dst, co
                             printf("target is node!!! \n");
                         #endif
 
-                        copy = xmlCopyNode(cursrc, 1);
+                        /* copies look up their names in the dictionary of the target document */
+                        copy = xmlDocCopyNode(cursrc, curtarget->doc, 1);
                         result = xmlAddChild(curtarget, copy);
                     } else {
 
@@ -359,7 +874,7 @@ void xml_ctx_nodes_add_xpath(XmlCtx *src, const char *src_xpath, XmlCtx *dst, co
                             printf("target is list!!! \n");
                         #endif
 
-                        copy = xmlCopyNodeList(cursrc);
+                        copy = xmlDocCopyNodeList(curtarget->doc, cursrc);
                         result = xmlAddChildList(curtarget, copy);
                     }
                     
@@ -389,7 +904,7 @@ void xml_ctx_nodes_add_note_xpres(xmlNodePtr src_node, xmlXPathObjectPtr dst_res
 
             xmlNodePtr target_node = nodes[curNode];
             
-            xmlNodePtr copy = xmlCopyNode(src_node, 1);
+            xmlNodePtr copy = xmlDocCopyNode(src_node, target_node->doc, 1);
             
             xmlAddChild(target_node, copy);
         }
@@ -402,7 +917,7 @@ void xml_ctx_nodes_add_node_xpath(xmlNodePtr src_node, XmlCtx *dst, const char *
 
     xmlXPathObjectPtr target_node_result = xml_ctx_xpath(dst, dst_xpath);
 
-    xml_ctx_nodes_add_note_xpres(src_node, target_node_result);
+    __xml_ctx_add_node(dst, src_node, target_node_result);
 
     xmlXPathFreeObject(target_node_result);
 }
@@ -414,7 +929,7 @@ void xml_ctx_nodes_add_node_xpath_format(xmlNodePtr src_node, XmlCtx *dst, const
     xmlXPathObjectPtr target_node_result = xml_ctx_xpath_format_va(dst, dst_xpath, args);
     va_end(args);
 
-    xml_ctx_nodes_add_note_xpres(src_node, target_node_result);
+    __xml_ctx_add_node(dst, src_node, target_node_result);
 
     xmlXPathFreeObject(target_node_result);
 }
@@ -435,9 +950,9 @@ void xml_ctx_rem_nodes_xpres(xmlXPathObjectPtr xpres) {
 
 void xml_ctx_remove(XmlCtx *ctx, const char *xpath) {
 
-    xmlXPathObjectPtr found = xml_ctx_xpath_format(ctx, xpath);
+    xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
 
-    xml_ctx_rem_nodes_xpres(found);
+    __xml_ctx_rem_nodes(ctx, found);
 
     xmlXPathFreeObject(found);
 }
@@ -449,12 +964,19 @@ void xml_ctx_remove_format(XmlCtx *ctx, const char *xpath_format, ...) {
     xmlXPathObjectPtr found = xml_ctx_xpath_format_va(ctx, xpath_format, args);
     va_end(args);
 
-    xml_ctx_rem_nodes_xpres(found);
+    __xml_ctx_rem_nodes(ctx, found);
 
     xmlXPathFreeObject(found);
 }
 
 bool xml_ctx_exist(XmlCtx *ctx, const char *xpath) {
+
+    xmlNodePtr first = NULL;
+
+    if ( ctx != NULL && ctx->doc != NULL && xpath != NULL && __xml_ctx_first_path(ctx, xpath, &first) ) {
+        return ( first != NULL );
+    }
+
     xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
 
     bool exist = xml_xpath_has_result(found);
@@ -468,17 +990,37 @@ bool xml_ctx_exist_format(XmlCtx *ctx, const char *xpath_format, ...) {
 
     va_list args;
     va_start(args, xpath_format);
-    xmlXPathObjectPtr found = xml_ctx_xpath_format_va(ctx, xpath_format, args);
+    char *gen_xpath = format_string_va_new(xpath_format, args);
     va_end(args);
 
-    bool exist = xml_xpath_has_result(found);
+    bool exist = xml_ctx_exist(ctx, gen_xpath);
 
-    xmlXPathFreeObject(found);
+    free(gen_xpath);
 
     return exist;
     
 }
 
+xmlNodePtr xml_ctx_first(const XmlCtx *ctx, const char *xpath) {
+
+    xmlNodePtr first = NULL;
+
+    if ( ctx == NULL || ctx->doc == NULL || xpath == NULL || __xml_ctx_first_path(ctx, xpath, &first) ) {
+        return first;
+    }
+
+    xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
+
+    /* namespace nodes of results are copies freed with the result */
+    if ( xml_xpath_has_result(found) && found->nodesetval->nodeTab[0]->type != XML_NAMESPACE_DECL ) {
+        first = found->nodesetval->nodeTab[0];
+    }
+
+    xmlXPathFreeObject(found);
+
+    return first;
+}
+
 bool xml_xpath_has_result(xmlXPathObjectPtr xpathobj) {
     return ( xpathobj != NULL && xpathobj->type == XPATH_NODESET && xpathobj->nodesetval && (xpathobj->nodesetval->nodeNr > 0 ));
 }
@@ -487,7 +1029,7 @@ void xml_ctx_set_attr_str_xpath(XmlCtx *ctx, const unsigned char *value, const c
     
     xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
 
-    __xml_ctx_attr_str_xpptr(found, value);
+    __xml_ctx_attr_str_xpptr(ctx, found, value);
 
     xmlXPathFreeObject(found);
 
@@ -500,7 +1042,7 @@ void xml_ctx_set_attr_str_xpath_format(XmlCtx *ctx, const unsigned char *value,
 
     xmlXPathObjectPtr found = xml_ctx_xpath_format_va(ctx, xpath_format, args);
 
-    __xml_ctx_attr_str_xpptr(found, value);
+    __xml_ctx_attr_str_xpptr(ctx, found, value);
 
     va_end(args);
 
@@ -510,7 +1052,7 @@ void xml_ctx_set_attr_str_xpath_format(XmlCtx *ctx, const unsigned char *value,
 void xml_ctx_set_content_xpath(XmlCtx *ctx, const unsigned char *value, const char *xpath) {
     xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
 
-    __xml_ctx_content_xpptr(found, value);
+    __xml_ctx_content_xpptr(ctx, found, value);
 
     xmlXPathFreeObject(found);
 }
@@ -521,7 +1063,7 @@ void xml_ctx_set_content_xpath_format(XmlCtx *ctx, const unsigned char *value, c
 
     xmlXPathObjectPtr found = xml_ctx_xpath_format_va(ctx, xpath_format, args);
 
-    __xml_ctx_content_xpptr(found, value);
+    __xml_ctx_content_xpptr(ctx, found, value);
 
     va_end(args);
 
@@ -534,14 +1076,12 @@ xmlChar * xml_ctx_get_attr(XmlCtx *ctx, const unsigned char *attr_name, const ch
     
     if (ctx != NULL) {
 
-        xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
+        xmlNodePtr first = xml_ctx_first(ctx, xpath);
 
-        if (xml_xpath_has_result(found)) {
-            value = xmlGetProp(found->nodesetval->nodeTab[0], (const xmlChar*)attr_name);
+        if ( first != NULL ) {
+            value = xmlGetProp(first, (const xmlChar*)attr_name);
         }
 
-        xmlXPathFreeObject(found);
-
     }
 
     return value;
@@ -557,15 +1097,13 @@ xmlChar * xml_ctx_get_attr_format(XmlCtx *ctx, const unsigned char *attr_name, c
         va_list args;
         va_start(args, xpath_format);
 
-        xmlXPathObjectPtr found = xml_ctx_xpath_format_va(ctx, xpath_format, args);
+        char *gen_xpath = format_string_va_new(xpath_format, args);
 
         va_end(args);
 
-        if (xml_xpath_has_result(found)) {
-            value = xmlGetProp(found->nodesetval->nodeTab[0], (const xmlChar*)attr_name);
-        }
+        value = xml_ctx_get_attr(ctx, attr_name, gen_xpath);
 
-        xmlXPathFreeObject(found);
+        free(gen_xpath);
     
     }
 
@@ -611,11 +1149,7 @@ int xml_ctx_xpath_tod(XmlCtx *ctx, double *result, const char *xpath)
     {
         xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
 
-        if ( found && ( xml_xpath_has_result(found) || found->type == XPATH_NUMBER))
-        {
-            *result = xmlXPathCastToNumber(found);
-            errNo = ( isnan(*result) ? 1 : 0);
-        }
+        errNo = __xml_ctx_xpres_tod(found, result);
 
         xmlXPathFreeObject(found);
     } 
@@ -630,11 +1164,7 @@ int xml_ctx_xpath_tod_format_va(XmlCtx *ctx, double *result, const char *xpath_f
     {
         xmlXPathObjectPtr found = xml_ctx_xpath_format_va(ctx, xpath_format, args);
 
-        if ( found && ( xml_xpath_has_result(found) || found->type == XPATH_NUMBER))
-        {
-            *result = xmlXPathCastToNumber(found);
-            errNo = ( isnan(*result) ? 1 : 0);
-        }
+        errNo = __xml_ctx_xpres_tod(found, result);
 
         xmlXPathFreeObject(found);
     } 
@@ -681,7 +1211,7 @@ int xml_ctx_xpath_tof(XmlCtx *ctx, float *result, const char *xpath)
 
     if ( errNo == 0 )
     {
-        *result = (long)dResult;
+        *result = (float)dResult;
     }
 
     return errNo;
@@ -700,7 +1230,7 @@ int xml_ctx_xpath_tof_format(XmlCtx *ctx, float *result, const char *xpath_forma
     
     if ( errNo == 0 )
     {
-        *result = (long)dResult;
+        *result = (float)dResult;
     }
 
     return errNo;
@@ -16,6 +16,65 @@
                 - Breed, Culture, Profession....etc.
             - a context service may use other context services as well. 
         
+    Thread safety:
+
+        Every context parses with its own libxml parser context and keeps its parse
+        error in XmlCtx.error, there is no global error state. Different contexts can
+        be used by different threads at the same time, one context by one thread at
+        a time only, because even queries change its xpath cache and state.
+
+        function                                    concurrent use
+        -----------------------------------------------------------------------------
+        xml_ctx_new, xml_ctx_new_opts,              yes, sources can be shared by
+        xml_ctx_new_file, xml_ctx_new_file_opts,    threads, they are read only
+        xml_ctx_new_empty, xml_ctx_new_empty_root_name
+        xml_ctx_new_dict                            yes with own dictionaries, a
+                                                    shared dictionary needs one
+                                                    thread at a time for all of its
+                                                    documents (unlocked lookups)
+        xml_ctx_archive_dict, xml_ctx_archive_dict_free
+                                                    yes, the global registry is
+                                                    locked
+        xml_ctx_new_archive                         no, shared dictionary
+        xml_ctx_new_node, xml_ctx_nodes_add_*       yes, if no other thread uses the
+                                                    context of the copied nodes
+        xml_ctx_error                               same context as the context
+        free_xml_ctx, free_xml_ctx_ptr,             yes for different contexts
+        free_xml_ctx_src
+        xml_ctx_xpath*, xml_ctx_query*, xml_ctx_exist*, xml_ctx_get_attr*,
+        xml_ctx_first,
+        xml_ctx_xpath_to*, xml_ctx_xpath_cache_*,
+        xml_ctx_xpath_register_func*                yes for different contexts, also
+                                                    for "const XmlCtx *" parameters
+        xml_ctx_set_*, xml_ctx_remove*,
+        xml_ctx_doc_changed, xml_ctx_save_file      yes for different contexts, the
+                                                    changes outdate the indexes of
+                                                    the context, which are rebuilt by
+                                                    their next lookup
+        xml_ctx_index_*, xml_ctx_numindex_*         yes for different contexts, also
+                                                    lookups, indexes are kept and
+                                                    rebuilt by the context
+        xml_ctx_freeze                              yes, if no other thread changes
+                                                    the context, it is only read
+        xml_ctx_new_many, xml_ctx_new_matching      yes for different archives, the
+                                                    archive is read by the calling
+                                                    thread, parsed by own workers
+        xml_ctx_list_free                           yes for different lists
+        xml_ctx_batch                               yes for different contexts and
+                                                    queries
+        xml_ctx_xpath_each*, xml_ctx_cursor_new     yes for different contexts, the
+                                                    cursor uses its context until it
+                                                    is freed, one thread at a time
+        xml_ctx_column_*                            yes for different contexts, the
+                                                    column cache is kept by the
+                                                    context
+        xml_node_*_view, xml_ctx_get_*_view*,
+        xml_ctx_get_attrs*                          yes for different contexts, values
+                                                    of several nodes are kept by the
+                                                    context
+        xml_ctx_rem_nodes_xpres, xml_ctx_nodes_add_note_xpres,
+        xml_xpath_has_result, xml_ctx_strtof,
+        xml_ctx_strtol                              yes for different nodes and results
 #endif
 
 #include <stdlib.h>
@@ -49,10 +108,37 @@ typedef struct {
     XmlCtxStateReason  reason;
 } XmlCtxState;
 
+typedef enum _xml_ctx_option {
+    XML_CTX_OPT_NONE        = 0,        /* parse like xml_ctx_new */
+    XML_CTX_OPT_NOBLANKS    = 1 << 0,   /* drop whitespace only text nodes of indention */
+    XML_CTX_OPT_COMPACT     = 1 << 1,   /* store short text inside of the text node, read only use */
+    XML_CTX_OPT_HUGE        = 1 << 2,   /* disable parser limits for very large documents */
+    XML_CTX_OPT_NODICT      = 1 << 3,   /* own strings per node instead of a dictionary */
+    XML_CTX_OPT_INTERN_VALUES = 1 << 4  /* attribute values are dictionary strings too */
+} XmlCtxOption;
+
+/*
+    Preset for documents which are only queried. For the tab indented data files it
+    removes more than half of all nodes, breeds.xml goes down from 6155 to 2774 nodes
+    for 2753 elements.
+*/
+#define XML_CTX_OPT_COMPACT_READONLY (XML_CTX_OPT_NOBLANKS | XML_CTX_OPT_COMPACT)
+
+#define XML_CTX_XPATH_CACHE_SIZE 64   /* default number of compiled xpath expressions per context */
+
 typedef struct {
     const XmlSource * const src; /* used xml source */
     xmlDocPtr  doc;                 /* parsed xml doc from given source */
     XmlCtxState state;          /* state of the last operation */
+    XPathCompCache *xpath_cache;    /* compiled xpath expressions, lazy created */
+    xmlXPathContextPtr xpath_ctx;   /* reused xpath evaluation context, lazy created */
+    unsigned long version;          /* incremented by every change of doc through xml_ctx functions */
+    struct _xml_index *indexes;     /* attribute value indexes, see xml_index.h */
+    struct _xml_num_index *num_indexes; /* sorted numeric attribute indexes, see xml_index.h */
+    struct _xml_column *columns;    /* cached numeric columns, see xml_column.h */
+    xmlDictPtr views;               /* values of views stored in several nodes, see xml_view.h */
+    unsigned long views_version;    /* context version the views dictionary was created for */
+    xmlError error;                 /* last error or warning of parsing, code XML_ERR_OK without */
 } XmlCtx;
 
 /*
@@ -72,6 +158,75 @@ typedef struct {
 */
 XmlCtx* xml_ctx_new(const XmlSource *xml_src);
 
+/*
+
+    This Function creates a new xml context with given xml_source like xml_ctx_new,
+    but parses with given options.
+
+    Example:
+        XmlCtx *ctx = xml_ctx_new_opts(src, XML_CTX_OPT_COMPACT_READONLY);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    xml_src         xml source
+    options         combination of XmlCtxOption
+
+    returns new xml context in every case with given state
+
+*/
+XmlCtx* xml_ctx_new_opts(const XmlSource *xml_src, int options);
+
+/*
+
+    This Functions create xml contexts which share one string dictionary.
+
+    Element and attribute names, and with XML_CTX_OPT_INTERN_VALUES attribute values
+    like type="LeP", are stored once for all documents of the dictionary. Equal names
+    of these documents are equal pointers and copying nodes between them needs no new
+    strings. The dictionary is reference counted, every document keeps its own
+    reference.
+
+    xml_ctx_new_dict            parses with given dictionary, NULL for an own one
+    xml_ctx_archive_dict        dictionary shared by all contexts of an archive,
+                                created on first use. The registry is locked, the
+                                dictionary is not.
+    xml_ctx_archive_dict_free   releases the registry reference of archive dictionary,
+                                documents using it stay valid. It has to be called
+                                before the archive is freed, the registry is keyed
+                                by address and a new archive at the same address
+                                would get the dictionary of the freed one.
+    xml_ctx_new_archive         context of archive resource name with archive
+                                dictionary, free it with free_xml_ctx_src
+
+    Example:
+        XmlCtx *breeds = xml_ctx_new_archive(ar, "breeds", XML_CTX_OPT_INTERN_VALUES);
+        XmlCtx *talents = xml_ctx_new_archive(ar, "talents", XML_CTX_OPT_INTERN_VALUES);
+        ...
+        free_xml_ctx_src(&breeds);
+        free_xml_ctx_src(&talents);
+        xml_ctx_archive_dict_free(ar);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    xml_src         xml source
+    dict            shared dictionary or NULL
+    options         combination of XmlCtxOption, XML_CTX_OPT_NODICT is ignored with dict
+    ar              archive resource
+    name            name of resource like xml_source_from_resname
+
+    returns new xml context in every case with given state, the dictionary of the
+    archive or NULL if ar is NULL
+
+*/
+XmlCtx* xml_ctx_new_dict(const XmlSource *xml_src, xmlDictPtr dict, int options);
+xmlDictPtr xml_ctx_archive_dict(const ArchiveResource *ar);
+void xml_ctx_archive_dict_free(const ArchiveResource *ar);
+XmlCtx* xml_ctx_new_archive(ArchiveResource *ar, const char *name, int options);
+
 /*
 
     This Function creates a new xml context without xml source.
@@ -132,6 +287,23 @@ XmlCtx* xml_ctx_new_node(const xmlNodePtr rootnode);
 */
 XmlCtx* xml_ctx_new_file(const char *filename);
 
+/*
+
+    This Function creates a new xml context from file like xml_ctx_new_file, but
+    parses with given options.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    filename        name of xml File
+    options         combination of XmlCtxOption
+
+    returns new xml context in every case with given state
+
+*/
+XmlCtx* xml_ctx_new_file_opts(const char *filename, int options);
+
 /*
 
     This Function will save current context doc to file as utf-8.
@@ -184,10 +356,54 @@ void free_xml_ctx_ptr(XmlCtx *ctx);
 */
 void free_xml_ctx_src(XmlCtx **ctx);
 
+/*
+
+    This Function returns the error of parsing the document of the context.
+
+    Example:
+        XmlCtx *ctx = xml_ctx_new(src);
+        const xmlError *error = xml_ctx_error(ctx);
+
+        if ( error != NULL ) {
+            printf("line %i: %s", error->line, error->message);
+        }
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context
+
+    returns the first error of parsing or the last warning if there was no error,
+    NULL if there was none. Documents with errors, which are still well formed,
+    like undefined namespace prefixes, are parsed with their error.
+*/
+const xmlError* xml_ctx_error(const XmlCtx *ctx);
+
+/*
+
+    This Function marks the document of the context as changed. All xml_ctx functions
+    which are changing the document are doing this by itself. It is needed after
+    changing the document direct by libxml or by functions without context parameter,
+    like xml_ctx_rem_nodes_xpres, so derived data like indexes will be rebuild.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+
+*/
+void xml_ctx_doc_changed(XmlCtx *ctx);
+
 /*
 
     This Function executes an xpath against xml context document.
 
+    The compiled form of xpath is kept in a bounded per context cache, so
+    repeated executions of the same expression text skip the xpath compiler.
+    This is used by all xpath based functions of this context.
+
     Parameter:
 
     name            description
@@ -199,6 +415,108 @@ void free_xml_ctx_src(XmlCtx **ctx);
 */
 xmlXPathObjectPtr xml_ctx_xpath( const XmlCtx *ctx, const char *xpath);
 
+/*
+
+    This Function executes an xpath relative to a node of the xml context document,
+    like xml_ctx_xpath otherwise. A NULL node is the document itself.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    node            context node of the xpath, node of ctx document or NULL
+    xpath           xpath for execution
+
+    returns a xmlXPathObjectPtr with xpath result
+*/
+xmlXPathObjectPtr xml_ctx_xpath_node(const XmlCtx *ctx, xmlNodePtr node, const char *xpath);
+
+/*
+
+    This Functions executes a prepared query (see xpath_query_new) against xml context
+    document. The variables bound at the query are used as xpath variables, there is
+    no string formatting or xpath compilation per execution. A query can be executed
+    against any number of contexts. The result handling is the same as for the
+    matching xpath string variants, like xml_ctx_exist or xml_ctx_get_attr.
+
+    The compiled query keeps the functions of its last execution, so it is compiled
+    again once it is executed with other functions (see xml_ctx_xpath_register_func).
+
+    Example:
+        XPathQuery *query = xpath_query_new("/breeds/group/breed[@name = $name]");
+
+        xpath_query_bind_str(query, "name", "Die Tulamiden");
+        bool exist = xml_ctx_query_exist(ctx, query);
+
+        xpath_query_bind_str(query, "name", "Die Thorwaler");
+        xmlChar *image = xml_ctx_query_get_attr(ctx, (unsigned char *)"image", query);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    query           prepared query with bound variables
+    attr_name       name of attribute to read from first result node
+    result          target for numeric result
+
+    xml_ctx_query returns a xmlXPathObjectPtr with xpath result
+*/
+xmlXPathObjectPtr xml_ctx_query(const XmlCtx *ctx, XPathQuery *query);
+bool xml_ctx_query_exist(XmlCtx *ctx, XPathQuery *query);
+xmlChar * xml_ctx_query_get_attr(XmlCtx *ctx, const unsigned char *attr_name, XPathQuery *query);
+int xml_ctx_query_tod(XmlCtx *ctx, double *result, XPathQuery *query);
+void xml_ctx_query_remove(XmlCtx *ctx, XPathQuery *query);
+
+/*
+
+    This Function registers a custom xpath function at the evaluation context
+    of the xml context. The evaluation context is created once per xml context
+    and already knows all xpath 1.0 functions and the extensions "regexmatch",
+    "in_range", "max", "min", "avg" and "total", an allocation free sum. Functions
+    registered here stay available for all following xpath executions of this
+    context until it will be freed. An already registered function with same
+    name and namespace will be replaced, NULL as func removes it. The userData
+    of the evaluation context is reserved for the XPathFuncCache of the
+    extension functions.
+
+    Example:
+        xml_ctx_xpath_register_func(ctx, "twice", twice_xpath_func);
+        xmlXPathObjectPtr res = xml_ctx_xpath(ctx, "//talent[@value = twice(3)]");
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    name            function name used inside of xpath expressions
+    ns_uri          namespace uri of the function, NULL for no namespace
+    func            xpath function implementation
+
+    returns 0 on success, otherwise -1
+*/
+int xml_ctx_xpath_register_func(XmlCtx *ctx, const char *name, xmlXPathFunction func);
+int xml_ctx_xpath_register_func_ns(XmlCtx *ctx, const char *name, const char *ns_uri, xmlXPathFunction func);
+
+/*
+
+    This Functions reads the statistic of the compiled xpath cache or change the
+    maximum number of cached expressions. Without any execution the stats are zero
+    and the capacity is XML_CTX_XPATH_CACHE_SIZE.
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    stats           target of the cache statistic
+    capacity        new maximum of cached expressions, at least 1
+
+*/
+void xml_ctx_xpath_cache_stats(const XmlCtx *ctx, XPathCompCacheStats *stats);
+void xml_ctx_xpath_cache_resize(XmlCtx *ctx, size_t capacity);
+
 /*
 
     This Function executes an xpath against xml context document.
@@ -246,8 +564,34 @@ void xml_ctx_rem_nodes_xpres(xmlXPathObjectPtr xpres);
 void xml_ctx_remove(XmlCtx *ctx, const char *xpath);
 void xml_ctx_remove_format(XmlCtx *ctx, const char *xpath_format, ...);
 
+/*
+
+    This Functions look for the first node of xpath in document order.
+
+    Restricted location paths (see xml_path.h), optionally followed by /@name, are not
+    evaluated completely. The document is walked until the first match, so a //
+    expression with an early match does not visit the whole document. Other
+    expressions are evaluated by xml_ctx_xpath. The same first match is used by
+    xml_ctx_get_attr. The results are the same like of xpath, names do not match
+    elements or attributes of a namespace.
+
+    xml_ctx_exist           returns true if xpath has a node
+    xml_ctx_exist_format    xml_ctx_exist of a formatted xpath
+    xml_ctx_first           returns the first node of xpath or NULL, the node is part
+                            of the context document
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             pointer to xml context pointer
+    xpath           xpath for execution
+    xpath_format    format of xpath, like printf
+
+*/
 bool xml_ctx_exist(XmlCtx *ctx, const char *xpath);
 bool xml_ctx_exist_format(XmlCtx *ctx, const char *xpath_format, ...);
+xmlNodePtr xml_ctx_first(const XmlCtx *ctx, const char *xpath);
 
 bool xml_xpath_has_result(xmlXPathObjectPtr xpathobj);
 
@@ -0,0 +1,181 @@
+#include "xml_view.h"
+
+static bool __xml_view_set(XmlStrView *view, const xmlChar *str) {
+
+    view->str = str;
+    view->len = ( str != NULL ? xmlStrlen(str) : 0 );
+
+    return ( str != NULL );
+}
+
+/* keeps a value of several nodes once by the context, until the document changes */
+static bool __xml_view_keep(XmlCtx *ctx, XmlStrView *view, xmlChar *value) {
+
+    const xmlChar *kept = NULL;
+
+    if ( value != NULL ) {
+
+        /* views do not outlast changes, so their values are released with the next view */
+        if ( ctx->views != NULL && ctx->views_version != ctx->version ) {
+            xmlDictFree(ctx->views);
+            ctx->views = NULL;
+        }
+
+        if ( ctx->views == NULL ) {
+            ctx->views = xmlDictCreate();
+            ctx->views_version = ctx->version;
+        }
+
+        if ( ctx->views != NULL ) {
+            kept = xmlDictLookup(ctx->views, value, -1);
+        }
+
+        xmlFree(value);
+    }
+
+    return __xml_view_set(view, kept);
+}
+
+/* value of child list in place: single text, empty without children, NULL otherwise */
+static const xmlChar * __xml_view_children(xmlNodePtr node) {
+
+    xmlNodePtr child = node->children;
+
+    if ( child == NULL ) {
+        return (const xmlChar *)"";
+    }
+
+    if ( child->next == NULL && ( child->type == XML_TEXT_NODE || child->type == XML_CDATA_SECTION_NODE ) ) {
+        return ( child->content != NULL ? child->content : (const xmlChar *)"" );
+    }
+
+    return NULL;
+}
+
+bool xml_node_attr_view(XmlCtx *ctx, xmlNodePtr node, const unsigned char *attr_name, XmlStrView *view) {
+
+    if ( view == NULL ) {
+        return false;
+    }
+
+    __xml_view_set(view, NULL);
+
+    if ( ctx == NULL || node == NULL || node->type != XML_ELEMENT_NODE || attr_name == NULL ) {
+        return false;
+    }
+
+    /* like xmlGetProp, including default values of the DTD */
+    xmlAttrPtr attr = xmlHasProp(node, attr_name);
+
+    if ( attr == NULL ) {
+        return false;
+    }
+
+    if ( attr->type == XML_ATTRIBUTE_DECL ) {
+        return __xml_view_set(view, ((xmlAttributePtr)attr)->defaultValue);
+    }
+
+    const xmlChar *value = __xml_view_children((xmlNodePtr)attr);
+
+    if ( value != NULL ) {
+        return __xml_view_set(view, value);
+    }
+
+    return __xml_view_keep(ctx, view, xmlNodeListGetString(node->doc, attr->children, 1));
+}
+
+bool xml_node_text_view(XmlCtx *ctx, xmlNodePtr node, XmlStrView *view) {
+
+    if ( view == NULL ) {
+        return false;
+    }
+
+    __xml_view_set(view, NULL);
+
+    if ( ctx == NULL || node == NULL ) {
+        return false;
+    }
+
+    const xmlChar *value = NULL;
+
+    switch ( node->type ) {
+        case XML_ELEMENT_NODE:
+        case XML_ATTRIBUTE_NODE:
+            value = __xml_view_children(node);
+            break;
+        case XML_TEXT_NODE:
+        case XML_CDATA_SECTION_NODE:
+        case XML_COMMENT_NODE:
+        case XML_PI_NODE:
+            value = ( node->content != NULL ? node->content : (const xmlChar *)"" );
+            break;
+        default:
+            break;
+    }
+
+    if ( value != NULL ) {
+        return __xml_view_set(view, value);
+    }
+
+    return __xml_view_keep(ctx, view, xmlNodeGetContent(node));
+}
+
+bool xml_ctx_get_attr_view(XmlCtx *ctx, const unsigned char *attr_name, const char *xpath, XmlStrView *view) {
+
+    xmlNodePtr node = ( ctx != NULL && xpath != NULL ? xml_ctx_first(ctx, xpath) : NULL );
+
+    return xml_node_attr_view(ctx, node, attr_name, view);
+}
+
+bool xml_ctx_get_attr_view_format(XmlCtx *ctx, const unsigned char *attr_name, XmlStrView *view, const char *xpath_format, ...) {
+
+    va_list args;
+    va_start(args, xpath_format);
+
+    char *gen_xpath = format_string_va_new(xpath_format, args);
+
+    va_end(args);
+
+    const bool found = xml_ctx_get_attr_view(ctx, attr_name, gen_xpath, view);
+
+    free(gen_xpath);
+
+    return found;
+}
+
+bool xml_ctx_get_text_view(XmlCtx *ctx, const char *xpath, XmlStrView *view) {
+
+    xmlNodePtr node = ( ctx != NULL && xpath != NULL ? xml_ctx_first(ctx, xpath) : NULL );
+
+    return xml_node_text_view(ctx, node, view);
+}
+
+int xml_ctx_get_attrs(XmlCtx *ctx, const char *xpath, const unsigned char * const attr_names[], int cnt, XmlStrView views[]) {
+
+    xmlNodePtr node = ( ctx != NULL && xpath != NULL ? xml_ctx_first(ctx, xpath) : NULL );
+    int found = 0;
+
+    for ( int curname = 0; views != NULL && curname < cnt; ++curname ) {
+        if ( xml_node_attr_view(ctx, node, attr_names[curname], &views[curname]) ) {
+            ++found;
+        }
+    }
+
+    return ( node != NULL ? found : -1 );
+}
+
+int xml_ctx_get_attrs_format(XmlCtx *ctx, const unsigned char * const attr_names[], int cnt, XmlStrView views[], const char *xpath_format, ...) {
+
+    va_list args;
+    va_start(args, xpath_format);
+
+    char *gen_xpath = format_string_va_new(xpath_format, args);
+
+    va_end(args);
+
+    const int found = xml_ctx_get_attrs(ctx, gen_xpath, attr_names, cnt, views);
+
+    free(gen_xpath);
+
+    return found;
+}
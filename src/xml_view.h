@@ -0,0 +1,112 @@
+#ifndef XML_VIEW_H
+#define XML_VIEW_H
+
+#if 0
+    Borrowed views of attribute values and texts.
+
+    A view points into the document of the context instead of a copy, so nothing
+    has to be freed. Values stored in one piece, which are most values, are referenced
+    directly. Values of several nodes, like texts with entity references, are kept
+    once by the context, until the first view after a change of the document
+    (see xml_ctx_doc_changed) releases them.
+
+    Views are valid until the node or the document is changed or freed.
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+#include <libxml/tree.h>
+#include <libxml/dict.h>
+
+#include "xml_utils.h"
+
+typedef struct {
+    const xmlChar   *str;       /* terminated value or NULL */
+    int             len;        /* length of value in bytes */
+} XmlStrView;
+
+/*
+
+    This Functions return views of the attribute or text of a node.
+
+    xml_node_attr_view      value of attribute attr_name of element node, like xmlGetProp
+    xml_node_text_view      value of an attribute node or text of an element or text
+                            node, like xmlNodeGetContent
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context of node
+    node            node of ctx document
+    attr_name       name of attribute
+    view            target view, {NULL, 0} if there is no value
+
+    returns true if there is a value
+*/
+bool xml_node_attr_view(XmlCtx *ctx, xmlNodePtr node, const unsigned char *attr_name, XmlStrView *view);
+bool xml_node_text_view(XmlCtx *ctx, xmlNodePtr node, XmlStrView *view);
+
+/*
+
+    This Functions return views of the first node of xpath, see xml_ctx_first.
+
+    xml_ctx_get_attr_view           like xml_ctx_get_attr without copy
+    xml_ctx_get_attr_view_format    xml_ctx_get_attr_view of a formatted xpath
+    xml_ctx_get_text_view           like xml_node_text_view
+
+    Example:
+        XmlStrView value;
+
+        if ( xml_ctx_get_attr_view_format(ctx, (const unsigned char *)"value", &value, "//talent[@name = '%s']", name) ) {
+            printf("%.*s\n", value.len, value.str);
+        }
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context
+    attr_name       name of attribute
+    xpath           xpath for execution
+    xpath_format    format of xpath, like printf
+    view            target view, {NULL, 0} if there is no value
+
+    returns true if there is a value
+*/
+bool xml_ctx_get_attr_view(XmlCtx *ctx, const unsigned char *attr_name, const char *xpath, XmlStrView *view);
+bool xml_ctx_get_attr_view_format(XmlCtx *ctx, const unsigned char *attr_name, XmlStrView *view, const char *xpath_format, ...);
+bool xml_ctx_get_text_view(XmlCtx *ctx, const char *xpath, XmlStrView *view);
+
+/*
+
+    This Functions return views of several attributes of the first node of xpath. The
+    node is searched once.
+
+    Example:
+        static const unsigned char * const names[] = { "name", "value", "dice", "type" };
+        XmlStrView views[4];
+
+        int cnt = xml_ctx_get_attrs(ctx, "//weapon[@name = 'Dolch']", names, 4, views);
+
+    Parameter:
+
+    name            description
+    ------------------------------------------------------------
+    ctx             xml context
+    xpath           xpath for execution
+    xpath_format    format of xpath, like printf
+    attr_names      names of attributes
+    cnt             number of attr_names
+    views           target of cnt views, views[i] for attr_names[i], {NULL, 0} for
+                    missing attributes
+
+    returns number of found attributes or -1 if there is no node
+*/
+int xml_ctx_get_attrs(XmlCtx *ctx, const char *xpath, const unsigned char * const attr_names[], int cnt, XmlStrView views[]);
+int xml_ctx_get_attrs_format(XmlCtx *ctx, const unsigned char * const attr_names[], int cnt, XmlStrView views[], const char *xpath_format, ...);
+
+#endif
@@ -1,5 +1,335 @@
+#include <stdatomic.h>
+
 #include "xpath_utils.h"
 
+/* source of function set ids, unique over all threads */
+static atomic_ulong _xpath_func_set_ids = 0;
+
+static void _xpath_func_cache_regex_free(void *payload, const xmlChar *name) {
+	(void)(name);
+	pcre2_code_free((pcre2_code *)payload);
+}
+
+static bool _xpath_func_cache_regex_match(XPathFuncCache *cache, const xmlChar *regex, const xmlChar *text) {
+
+	pcre2_code *code = xmlHashLookup(cache->regex, regex);
+
+	if (code == NULL) {
+		int errornumber;
+		PCRE2_SIZE erroroffset;
+
+		code = pcre2_compile((PCRE2_SPTR)regex, PCRE2_ZERO_TERMINATED, 0, &errornumber, &erroroffset, NULL);
+
+		if (code == NULL) {
+			return false;
+		}
+
+		/* without jit support pcre2_match falls back to the interpreter */
+		pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+
+		if (xmlHashSize(cache->regex) >= XPATH_REGEX_CACHE_SIZE) {
+			xmlHashFree(cache->regex, _xpath_func_cache_regex_free);
+			cache->regex = xmlHashCreate(XPATH_REGEX_CACHE_SIZE);
+		}
+
+		xmlHashAddEntry(cache->regex, regex, code);
+	}
+
+	return pcre2_match(code, (PCRE2_SPTR)text, PCRE2_ZERO_TERMINATED, 0, 0, cache->match_data, NULL) >= 0;
+}
+
+static const xmlChar * _xpath_skip_blanks(const xmlChar *str) {
+	while (xmlIsBlank_ch(*str)) {
+		++str;
+	}
+	return str;
+}
+
+static const xmlChar * _xpath_parse_digits(const xmlChar *str, long long *result) {
+	const xmlChar *start = str;
+	long long value = 0;
+
+	while (*str >= '0' && *str <= '9' && (str - start) < 18) {
+		value = value * 10 + (*str - '0');
+		++str;
+	}
+
+	*result = value;
+
+	return ( str != start && !(*str >= '0' && *str <= '9') ? str : NULL );
+}
+
+/* parses an integer with optional minus surrounded by blanks, nothing else */
+static bool _xpath_parse_ll(const xmlChar *str, long long *result) {
+	str = _xpath_skip_blanks(str);
+
+	bool negative = (*str == '-');
+
+	if (negative) {
+		++str;
+	}
+
+	str = _xpath_parse_digits(str, result);
+
+	if (str == NULL || *_xpath_skip_blanks(str) != '\0') {
+		return false;
+	}
+
+	if (negative) {
+		*result = -*result;
+	}
+
+	return true;
+}
+
+/* parses a decimal with optional minus and up to 15 digits surrounded by blanks,
+   mantissa and power of ten are exact, so the one division rounds correctly */
+static bool _xpath_parse_decimal(const xmlChar *str, double *result) {
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+	str = _xpath_skip_blanks(str);
+
+	bool negative = (*str == '-');
+
+	if (negative) {
+		++str;
+	}
+
+	long long mantissa = 0;
+	int digits = 0;
+	int fraction = -1;
+
+	for (;; ++str) {
+		if (*str >= '0' && *str <= '9') {
+			if (++digits > 15) {
+				return false;
+			}
+			mantissa = mantissa * 10 + (*str - '0');
+			fraction += (fraction >= 0);
+		} else if (*str == '.' && fraction < 0) {
+			fraction = 0;
+		} else {
+			break;
+		}
+	}
+
+	if (digits == 0 || *_xpath_skip_blanks(str) != '\0') {
+		return false;
+	}
+
+	const double value = (double)mantissa / powers[( fraction > 0 ? fraction : 0 )];
+
+	*result = ( negative ? -value : value );
+
+	return true;
+}
+
+/* text of node if it is stored in one piece, otherwise NULL */
+static const xmlChar * _xpath_node_text(xmlNodePtr node) {
+	const xmlChar *text = NULL;
+
+	switch(node->type) {
+		case XML_ATTRIBUTE_NODE:
+		case XML_ELEMENT_NODE: {
+			xmlNodePtr child = node->children;
+
+			if (child == NULL) {
+				text = (const xmlChar *)"";
+			} else if (child->next == NULL && (child->type == XML_TEXT_NODE || child->type == XML_CDATA_SECTION_NODE)) {
+				text = child->content;
+			}
+			break;
+		}
+		case XML_TEXT_NODE:
+		case XML_CDATA_SECTION_NODE:
+		case XML_COMMENT_NODE:
+		case XML_PI_NODE:
+			text = node->content;
+			break;
+		default:
+			break;
+	}
+
+	return text;
+}
+
+double xpath_str_to_number(const xmlChar *str) {
+	long long value;
+
+	if (str == NULL) {
+		return xmlXPathNAN;
+	}
+
+	if (_xpath_parse_ll(str, &value) && value > -(1LL << 53) && value < (1LL << 53)) {
+		return (double)value;
+	}
+
+	double decimal;
+
+	if (_xpath_parse_decimal(str, &decimal)) {
+		return decimal;
+	}
+
+	return xmlXPathStringEvalNumber(str);
+}
+
+double xpath_node_to_number(xmlNodePtr node) {
+	const xmlChar *text = _xpath_node_text(node);
+
+	return ( text != NULL ? xpath_str_to_number(text) : xmlXPathCastNodeToNumber(node) );
+}
+
+int xpath_str_to_int64(const xmlChar *str, int64_t *result) {
+
+	if (str == NULL) {
+		return -1;
+	}
+
+	const xmlChar *cur = _xpath_skip_blanks(str);
+	const bool negative = (*cur == '-');
+	const unsigned long long limit = ( negative ? 9223372036854775808ULL : 9223372036854775807ULL );
+	const xmlChar *start = ( negative ? ++cur : cur );
+
+	unsigned long long value = 0;
+	bool overflow = false;
+
+	for (; *cur >= '0' && *cur <= '9'; ++cur) {
+		const unsigned int digit = (unsigned int)(*cur - '0');
+		overflow = overflow || value > (limit - digit) / 10;
+		value = value * 10 + digit;
+	}
+
+	if (cur != start && *_xpath_skip_blanks(cur) == '\0') {
+		if (overflow) {
+			return 1;
+		}
+		*result = ( !negative ? (int64_t)value : ( value == limit ? INT64_MIN : -(int64_t)value ) );
+		return 0;
+	}
+
+	/* numbers like 12.0 are integral too */
+	const double number = xpath_str_to_number(str);
+
+	if (isnan(number) || number != floor(number)) {
+		return -1;
+	}
+
+	if (number >= 9223372036854775808.0 || number < -9223372036854775808.0) {
+		return 1;
+	}
+
+	*result = (int64_t)number;
+
+	return 0;
+}
+
+int xpath_node_to_int64(xmlNodePtr node, int64_t *result) {
+	const xmlChar *text = _xpath_node_text(node);
+
+	if (text != NULL) {
+		return xpath_str_to_int64(text, result);
+	}
+
+	xmlChar *value = xmlXPathCastNodeToString(node);
+	const int error = xpath_str_to_int64(value, result);
+	xmlFree(value);
+
+	return error;
+}
+
+/* parses a plain decimal integer like regex_range_match writes it, without sign, blanks
+   or leading zeros, returns the first character after the digits or NULL */
+static const xmlChar * _xpath_parse_plain(const xmlChar *str, long long *result) {
+
+	if (str[0] == '0' && str[1] >= '0' && str[1] <= '9') {
+		return NULL;
+	}
+
+	return _xpath_parse_digits(str, result);
+}
+
+/* only ranges of plain integers "from" or "from-to" are numeric, all others keep the
+   regex semantic of regex_range_match */
+static const XPathRange * _xpath_range_parse(const xmlChar *range, XPathRange *result) {
+	const xmlChar *cur = _xpath_parse_plain(range, &result->from);
+
+	result->numeric = false;
+
+	if (cur != NULL) {
+		result->to = result->from;
+
+		if (*cur == '-') {
+			cur = _xpath_parse_plain(cur + 1, &result->to);
+		}
+
+		result->numeric = ( cur != NULL && *cur == '\0' && result->from <= result->to );
+	}
+
+	return result;
+}
+
+/* value of a numeric range compare, plain integers only like the range */
+static bool _xpath_range_value(const xmlChar *value, long long *result) {
+	const xmlChar *cur = _xpath_parse_plain(value, result);
+	return ( cur != NULL && *cur == '\0' );
+}
+
+static void _xpath_func_cache_range_free(void *payload, const xmlChar *name) {
+	(void)(name);
+	free(payload);
+}
+
+static const XPathRange * _xpath_func_cache_range(XPathFuncCache *cache, const xmlChar *range) {
+
+	XPathRange *parsed = xmlHashLookup(cache->ranges, range);
+
+	if (parsed == NULL) {
+		parsed = malloc(sizeof(XPathRange));
+		_xpath_range_parse(range, parsed);
+
+		if (xmlHashSize(cache->ranges) >= XPATH_RANGE_CACHE_SIZE) {
+			xmlHashFree(cache->ranges, _xpath_func_cache_range_free);
+			cache->ranges = xmlHashCreate(XPATH_RANGE_CACHE_SIZE);
+		}
+
+		xmlHashAddEntry(cache->ranges, range, parsed);
+	}
+
+	return parsed;
+}
+
+XPathFuncCache* xpath_func_cache_new() {
+	XPathFuncCache *cache = malloc(sizeof(XPathFuncCache));
+
+	cache->regex = xmlHashCreate(XPATH_REGEX_CACHE_SIZE);
+	/* only match or not is of interest, so one offset pair is enough */
+	cache->match_data = pcre2_match_data_create(1, NULL);
+	cache->ranges = xmlHashCreate(XPATH_RANGE_CACHE_SIZE);
+	cache->owner = NULL;
+	cache->funcs = atomic_fetch_add(&_xpath_func_set_ids, 1) + 1;
+
+	return cache;
+}
+
+void xpath_func_cache_funcs_changed(XPathFuncCache *cache) {
+	if (cache != NULL) {
+		cache->funcs = atomic_fetch_add(&_xpath_func_set_ids, 1) + 1;
+	}
+}
+
+void xpath_func_cache_free(XPathFuncCache **cache) {
+	if (cache != NULL && *cache != NULL) {
+		XPathFuncCache *todelete = *cache;
+
+		xmlHashFree(todelete->regex, _xpath_func_cache_regex_free);
+		pcre2_match_data_free(todelete->match_data);
+		xmlHashFree(todelete->ranges, _xpath_func_cache_range_free);
+		free(todelete);
+
+		*cache = NULL;
+	}
+}
+
 void regexmatch_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
 	if ( nargs != 2 ) return;
 	
@@ -14,7 +344,9 @@ void regexmatch_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
         return;
     }
 	
-	bool match = regex_match(regex, text);
+	XPathFuncCache *cache = ctxt->context->userData;
+
+	bool match = ( cache != NULL ? _xpath_func_cache_regex_match(cache, regex, text) : regex_match(regex, text) );
 	
 	xmlFree(regex);
 	xmlFree(text);
@@ -22,9 +354,19 @@ void regexmatch_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
 	xmlXPathReturnBoolean(ctxt, match);
 }
 
-void max_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
+typedef enum {
+	XPATH_AGGR_MAX,
+	XPATH_AGGR_MIN,
+	XPATH_AGGR_SUM,
+	XPATH_AGGR_AVG
+} XPathAggregate;
 
-	(void)(nargs);
+static void _xpath_aggregate(xmlXPathParserContextPtr ctxt, int nargs, XPathAggregate aggregate) {
+
+	if ( nargs != 1 ) {
+		xmlXPathSetArityError(ctxt);
+		return;
+	}
 
 	xmlNodeSetPtr nodes = xmlXPathPopNodeSet(ctxt);
 	
@@ -32,29 +374,60 @@ void max_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
 		xmlXPathFreeNodeSet(nodes);
         return;
     }
-	
-	long long max_val = 0;
 
-	for (int curnode = 0; curnode < nodes->nodeNr; ++curnode) { 
-		xmlNodePtr curNode = nodes->nodeTab[curnode];
-		if (curNode->type == XML_ATTRIBUTE_NODE) {
+	const int cntNodes = (nodes != NULL ? nodes->nodeNr : 0);
 
-			xmlChar *sattr = xmlGetProp(curNode->parent, curNode->name);
-			
-			long long value = atoll((const char *)sattr);
+	double result = ( aggregate == XPATH_AGGR_SUM ? 0. : xmlXPathNAN );
 
-			max_val = (value > max_val ? value : max_val);
+	for (int curnode = 0; curnode < cntNodes; ++curnode) { 
 
-			if (sattr != NULL) {
-				xmlFree(sattr);
-			}
+		double value = xpath_node_to_number(nodes->nodeTab[curnode]);
+
+		if (xmlXPathIsNaN(value)) {
+			result = value;
+			break;
+		}
+
+		if (curnode == 0 && aggregate != XPATH_AGGR_SUM) {
+			result = value;
+			continue;
+		}
+
+		switch(aggregate) {
+			case XPATH_AGGR_MAX:	result = ( value > result ? value : result );
+									break;
+			case XPATH_AGGR_MIN:	result = ( value < result ? value : result );
+									break;
+			case XPATH_AGGR_SUM:
+			case XPATH_AGGR_AVG:	result += value;
+									break;
 		}
 		
 	}
 
+	if (aggregate == XPATH_AGGR_AVG && cntNodes > 0) {
+		result /= cntNodes;
+	}
+
 	xmlXPathFreeNodeSet(nodes);
 
-	xmlXPathReturnNumber(ctxt, max_val);
+	xmlXPathReturnNumber(ctxt, result);
+}
+
+void max_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
+	_xpath_aggregate(ctxt, nargs, XPATH_AGGR_MAX);
+}
+
+void min_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
+	_xpath_aggregate(ctxt, nargs, XPATH_AGGR_MIN);
+}
+
+void sum_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
+	_xpath_aggregate(ctxt, nargs, XPATH_AGGR_SUM);
+}
+
+void avg_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
+	_xpath_aggregate(ctxt, nargs, XPATH_AGGR_AVG);
 }
 
 void str_in_range_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
@@ -67,15 +440,291 @@ void str_in_range_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
 	
 	xmlChar *range = xmlXPathPopString(ctxt);
     if (xmlXPathCheckError(ctxt) || (range == NULL)) {
-		xmlFree(range);
+		xmlFree(value);
         return;
     }
 	
 
-	bool match = regex_range_match((const unsigned char *)range, (const unsigned char *)value);
+	XPathFuncCache *cache = ctxt->context->userData;
+
+	XPathRange parsed;
+	const XPathRange *irange = ( cache != NULL ? _xpath_func_cache_range(cache, range) : _xpath_range_parse(range, &parsed) );
+
+	long long ivalue;
+	bool match;
+
+	if ( irange->numeric && _xpath_range_value(value, &ivalue) ) {
+		match = ( ivalue >= irange->from && ivalue <= irange->to );
+	} else {
+		match = regex_range_match((const unsigned char *)range, (const unsigned char *)value);
+	}
 
 	xmlFree(range);
 	xmlFree(value);
 
 	xmlXPathReturnBoolean(ctxt, match);
-}
\ No newline at end of file
+}
+
+static void _xpath_comp_entry_unlink(XPathCompCache *cache, XPathCompEntry *entry) {
+	if (entry->prev != NULL) {
+		entry->prev->next = entry->next;
+	} else {
+		cache->head = entry->next;
+	}
+
+	if (entry->next != NULL) {
+		entry->next->prev = entry->prev;
+	} else {
+		cache->tail = entry->prev;
+	}
+
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+static void _xpath_comp_entry_push_front(XPathCompCache *cache, XPathCompEntry *entry) {
+	entry->prev = NULL;
+	entry->next = cache->head;
+
+	if (cache->head != NULL) {
+		cache->head->prev = entry;
+	}
+
+	cache->head = entry;
+
+	if (cache->tail == NULL) {
+		cache->tail = entry;
+	}
+}
+
+static void _xpath_comp_entry_free(XPathCompEntry *entry) {
+	xmlXPathFreeCompExpr(entry->comp);
+	xmlFree(entry->expr);
+	free(entry);
+}
+
+static void _xpath_comp_cache_evict(XPathCompCache *cache, size_t capacity) {
+	while (cache->stats.size > capacity && cache->tail != NULL) {
+		XPathCompEntry *victim = cache->tail;
+
+		_xpath_comp_entry_unlink(cache, victim);
+		xmlHashRemoveEntry(cache->table, victim->expr, NULL);
+		_xpath_comp_entry_free(victim);
+
+		--cache->stats.size;
+		++cache->stats.evictions;
+	}
+}
+
+XPathCompCache* xpath_comp_cache_new(size_t capacity) {
+	XPathCompCache *cache = malloc(sizeof(XPathCompCache));
+
+	cache->table = xmlHashCreate((int)(capacity < 1024 ? capacity : 1024));
+	cache->head = NULL;
+	cache->tail = NULL;
+
+	memset(&cache->stats, 0, sizeof(XPathCompCacheStats));
+	cache->stats.capacity = (capacity > 0 ? capacity : 1);
+
+	return cache;
+}
+
+xmlXPathCompExprPtr xpath_comp_cache_get(XPathCompCache *cache, const xmlChar *xpath) {
+
+	XPathCompEntry *entry = xmlHashLookup(cache->table, xpath);
+
+	if (entry != NULL) {
+		++cache->stats.hits;
+
+		if (entry != cache->head) {
+			_xpath_comp_entry_unlink(cache, entry);
+			_xpath_comp_entry_push_front(cache, entry);
+		}
+
+		return entry->comp;
+	}
+
+	++cache->stats.misses;
+
+	xmlXPathCompExprPtr comp = xmlXPathCompile(xpath);
+
+	if (comp == NULL) {
+		return NULL;
+	}
+
+	_xpath_comp_cache_evict(cache, cache->stats.capacity - 1);
+
+	entry = malloc(sizeof(XPathCompEntry));
+	entry->expr = xmlStrdup(xpath);
+	entry->comp = comp;
+
+	xmlHashAddEntry(cache->table, entry->expr, entry);
+	_xpath_comp_entry_push_front(cache, entry);
+
+	++cache->stats.size;
+
+	return comp;
+}
+
+void xpath_comp_cache_resize(XPathCompCache *cache, size_t capacity) {
+	if (cache != NULL) {
+		cache->stats.capacity = (capacity > 0 ? capacity : 1);
+		_xpath_comp_cache_evict(cache, cache->stats.capacity);
+	}
+}
+
+void xpath_comp_cache_clear(XPathCompCache *cache) {
+	if (cache != NULL) {
+		_xpath_comp_cache_evict(cache, 0);
+	}
+}
+
+void xpath_comp_cache_free(XPathCompCache **cache) {
+	if (cache != NULL && *cache != NULL) {
+		XPathCompCache *todelete = *cache;
+
+		XPathCompEntry *entry = todelete->head;
+
+		while (entry != NULL) {
+			XPathCompEntry *next = entry->next;
+			_xpath_comp_entry_free(entry);
+			entry = next;
+		}
+
+		xmlHashFree(todelete->table, NULL);
+		free(todelete);
+
+		*cache = NULL;
+	}
+}
+
+static XPathQueryVar* _xpath_query_var(XPathQuery *query, const xmlChar *name) {
+	for (int curvar = 0; curvar < query->var_cnt; ++curvar) {
+		if (xmlStrEqual(query->vars[curvar].name, name)) {
+			return &query->vars[curvar];
+		}
+	}
+	return NULL;
+}
+
+static void _xpath_query_bind(XPathQuery *query, const char *name, xmlXPathObjectPtr value) {
+
+	if (query == NULL || name == NULL) {
+		xmlXPathFreeObject(value);
+		return;
+	}
+
+	XPathQueryVar *var = _xpath_query_var(query, (const xmlChar *)name);
+
+	if (var == NULL) {
+		if (query->var_cnt == query->var_max) {
+			query->var_max = (query->var_max == 0 ? 4 : query->var_max * 2);
+			query->vars = realloc(query->vars, query->var_max * sizeof(XPathQueryVar));
+		}
+
+		var = &query->vars[query->var_cnt++];
+		var->name = xmlStrdup((const xmlChar *)name);
+		var->value = NULL;
+	}
+
+	xmlXPathFreeObject(var->value);
+	var->value = value;
+}
+
+XPathQuery* xpath_query_new(const char *xpath) {
+
+	XPathQuery *query = NULL;
+
+	if (xpath != NULL) {
+		xmlXPathCompExprPtr comp = xmlXPathCompile((const xmlChar *)xpath);
+
+		if (comp != NULL) {
+			query = malloc(sizeof(XPathQuery));
+			query->xpath = xmlStrdup((const xmlChar *)xpath);
+			query->comp = comp;
+			query->funcs = 0;
+			query->vars = NULL;
+			query->var_cnt = 0;
+			query->var_max = 0;
+		}
+	}
+
+	return query;
+}
+
+void xpath_query_bind_str(XPathQuery *query, const char *name, const char *value) {
+	_xpath_query_bind(query, name, xmlXPathNewCString(value != NULL ? value : ""));
+}
+
+void xpath_query_bind_num(XPathQuery *query, const char *name, double value) {
+	_xpath_query_bind(query, name, xmlXPathNewFloat(value));
+}
+
+void xpath_query_bind_nodes(XPathQuery *query, const char *name, xmlNodeSetPtr nodes) {
+	_xpath_query_bind(query, name, xmlXPathWrapNodeSet(xmlXPathNodeSetMerge(NULL, nodes)));
+}
+
+void xpath_query_bind_node(XPathQuery *query, const char *name, xmlNodePtr node) {
+	_xpath_query_bind(query, name, xmlXPathNewNodeSet(node));
+}
+
+void xpath_query_clear(XPathQuery *query) {
+	if (query != NULL) {
+		for (int curvar = 0; curvar < query->var_cnt; ++curvar) {
+			xmlFree(query->vars[curvar].name);
+			xmlXPathFreeObject(query->vars[curvar].value);
+		}
+		query->var_cnt = 0;
+	}
+}
+
+void xpath_query_free(XPathQuery **query) {
+	if (query != NULL && *query != NULL) {
+		XPathQuery *todelete = *query;
+
+		xpath_query_clear(todelete);
+		free(todelete->vars);
+		xmlXPathFreeCompExpr(todelete->comp);
+		xmlFree(todelete->xpath);
+		free(todelete);
+
+		*query = NULL;
+	}
+}
+
+xmlXPathCompExprPtr xpath_query_comp(XPathQuery *query, const XPathFuncCache *cache) {
+
+	if (query == NULL) {
+		return NULL;
+	}
+
+	const unsigned long funcs = ( cache != NULL ? cache->funcs : 0 );
+
+	if (query->funcs != funcs) {
+
+		/* functions resolved for another function set must not be reused */
+		if (query->funcs != 0) {
+			xmlXPathCompExprPtr comp = xmlXPathCompile(query->xpath);
+
+			if (comp != NULL) {
+				xmlXPathFreeCompExpr(query->comp);
+				query->comp = comp;
+			}
+		}
+
+		query->funcs = funcs;
+	}
+
+	return query->comp;
+}
+
+xmlXPathObjectPtr xpath_query_var_lookup(void *data, const xmlChar *name, const xmlChar *ns_uri) {
+
+	XPathQueryVar *var = NULL;
+
+	if (data != NULL && ns_uri == NULL) {
+		var = _xpath_query_var((XPathQuery *)data, name);
+	}
+
+	return (var != NULL ? xmlXPathObjectCopy(var->value) : NULL);
+}
@@ -5,14 +5,209 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <math.h>
 
+#include <libxml/chvalid.h>
+#include <libxml/hash.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 
 #include "regex_utils.h"
 
+#ifndef PCRE2_CODE_UNIT_WIDTH
+	#define PCRE2_CODE_UNIT_WIDTH 8
+#endif
+#include <pcre2.h>
+
+#define XPATH_REGEX_CACHE_SIZE 64	/* maximum number of compiled regexmatch patterns */
+#define XPATH_RANGE_CACHE_SIZE 256	/* maximum number of parsed in_range ranges */
+
+typedef struct _xpath_comp_entry {
+	xmlChar						*expr;	/* expression text, key of the entry */
+	xmlXPathCompExprPtr			comp;	/* compiled expression */
+	struct _xpath_comp_entry	*prev;	/* more recently used entry */
+	struct _xpath_comp_entry	*next;	/* less recently used entry */
+} XPathCompEntry;
+
+typedef struct {
+	size_t	hits;		/* lookups answered from cache */
+	size_t	misses;		/* lookups which needs a compilation */
+	size_t	evictions;	/* entries dropped because of capacity */
+	size_t	size;		/* current number of cached expressions */
+	size_t	capacity;	/* maximum number of cached expressions */
+} XPathCompCacheStats;
+
+typedef struct {
+	xmlHashTablePtr		table;	/* expression text => XPathCompEntry */
+	XPathCompEntry		*head;	/* most recently used */
+	XPathCompEntry		*tail;	/* least recently used, next to evict */
+	XPathCompCacheStats	stats;
+} XPathCompCache;
+
+typedef struct {
+	bool		numeric;	/* range is a plain integer interval like "1-3" or "20" */
+	long long	from;		/* first value of interval */
+	long long	to;			/* last value of interval */
+} XPathRange;
+
+typedef struct {
+	xmlHashTablePtr		regex;			/* regexmatch pattern => jit compiled pcre2_code */
+	pcre2_match_data	*match_data;	/* match block shared by all patterns */
+	xmlHashTablePtr		ranges;			/* in_range range => parsed XPathRange */
+	void				*owner;			/* owner of the evaluation context, like a XmlCtx */
+	unsigned long		funcs;			/* unique id of the registered function set */
+} XPathFuncCache;
+
+typedef struct {
+	xmlChar				*name;	/* variable name without leading $ */
+	xmlXPathObjectPtr	value;	/* bound value */
+} XPathQueryVar;
+
+typedef struct {
+	xmlChar				*xpath;		/* expression text for recompilation */
+	xmlXPathCompExprPtr	comp;		/* compiled expression */
+	unsigned long		funcs;		/* function set resolved by comp, 0 before first use */
+	XPathQueryVar		*vars;		/* bound variables */
+	int					var_cnt;	/* number of bound variables */
+	int					var_max;	/* allocated variable slots */
+} XPathQuery;
+
+/*
+	Extension functions for xpath evaluation contexts.
+
+	If the userData of the xpath context is set to a XPathFuncCache the functions
+	keep their per call work there, like "regexmatch" keeps the compiled and jit-ed
+	patterns and "in_range" the parsed ranges. Without this they work on their own,
+	but slower.
+
+	"in_range(range, value)" compares integer intervals like "1-3" or "20" without
+	regex. Only plain integers without sign, blanks or leading zeros are compared
+	this way, other ranges and values are matched by regex_range_match.
+
+	"max(nodes)", "min(nodes)", "total(nodes)" and "avg(nodes)" read the values of
+	attribute, element and text nodes in place. Non numeric values result in NaN,
+	like number() does. An empty node set results in NaN, except for total with 0.
+	"total" has the semantic of the xpath 1.0 function "sum", which can not be
+	replaced, since libxml2 2.12 calls its own functions before registered ones.
+
+	Example:
+		xmlXPathRegisterFunc(xpathCtx, (const xmlChar *)"regexmatch", regexmatch_xpath_func);
+		xpathCtx->userData = xpath_func_cache_new();
+*/
+XPathFuncCache* xpath_func_cache_new();
+void xpath_func_cache_free(XPathFuncCache **cache);
+
+/*
+	Compiled expressions keep the functions resolved by their first evaluation. Every
+	XPathFuncCache gets its own function set id, which has to be renewed by
+	"xpath_func_cache_funcs_changed" whenever functions of its xpath context are
+	registered or removed, so prepared queries know when to recompile.
+*/
+void xpath_func_cache_funcs_changed(XPathFuncCache *cache);
+
 void regexmatch_xpath_func(xmlXPathParserContextPtr ctxt, int nargs);
 void max_xpath_func(xmlXPathParserContextPtr ctxt, int nargs);
+void min_xpath_func(xmlXPathParserContextPtr ctxt, int nargs);
+void sum_xpath_func(xmlXPathParserContextPtr ctxt, int nargs);
+void avg_xpath_func(xmlXPathParserContextPtr ctxt, int nargs);
 void str_in_range_xpath_func(xmlXPathParserContextPtr ctxt, int nargs);
 
+/*
+	Number conversion like the xpath function number(), but without copy of the
+	node value if possible. Plain integer strings are parsed without floating point
+	parser.
+
+	Parameter			Decription
+	---------			-----------------------------------------
+	str					string to convert
+	node				attribute, element or text node to convert
+
+	returns the numeric value or NaN
+*/
+double xpath_str_to_number(const xmlChar *str);
+double xpath_node_to_number(xmlNodePtr node);
+
+/*
+	Integer conversion of numbers like the xpath function number(). Values with
+	fraction digits other than 0 are no integers.
+
+	Parameter			Decription
+	---------			-----------------------------------------
+	str					string to convert
+	node				attribute, element or text node to convert
+	result				target of the value, only set on success
+
+	returns 0 on success, -1 if the value is no integer, 1 if it is out of range
+*/
+int xpath_str_to_int64(const xmlChar *str, int64_t *result);
+int xpath_node_to_int64(xmlNodePtr node, int64_t *result);
+
+/*
+	Bounded LRU cache of compiled xpath expressions keyed by expression text.
+
+	"xpath_comp_cache_get" returns the compiled expression of xpath or NULL if
+	the expression is invalid. The returned pointer is owned by the cache and
+	stays valid until the next call of "xpath_comp_cache_get", "xpath_comp_cache_resize",
+	"xpath_comp_cache_clear" or "xpath_comp_cache_free" on the same cache.
+
+	Compiled expressions remember resolved xpath functions, so the cache has to be
+	cleared if a function gets replaced at the evaluation context.
+
+	Parameter			Decription
+	---------			-----------------------------------------
+	capacity			maximum number of cached expressions, at least 1
+	cache				cache to use
+	xpath				expression text
+*/
+XPathCompCache* xpath_comp_cache_new(size_t capacity);
+xmlXPathCompExprPtr xpath_comp_cache_get(XPathCompCache *cache, const xmlChar *xpath);
+void xpath_comp_cache_resize(XPathCompCache *cache, size_t capacity);
+void xpath_comp_cache_clear(XPathCompCache *cache);
+void xpath_comp_cache_free(XPathCompCache **cache);
+
+/*
+	Prepared xpath query. The expression is compiled once by "xpath_query_new" and
+	may contain variables like $name or $value. Values are bound by name and stay
+	bound until they get replaced or "xpath_query_clear" is called, so a query can be
+	executed many times with different values, without formatting or compiling a
+	new expression. Execution against a document happens by xml_ctx_query*.
+
+	Example:
+		XPathQuery *query = xpath_query_new("/breeds/group/breed[@name = $name]");
+		xpath_query_bind_str(query, "name", "Die Tulamiden");
+
+	"xpath_query_bind_nodes" copies the node set, but not the nodes.
+
+	The compiled expression keeps the functions resolved by its first evaluation.
+	"xpath_query_comp" returns it for evaluation with the functions of cache and
+	recompiles the expression if it was evaluated with another function set before,
+	like another context or the same context before a function registration.
+
+	Parameter			Decription
+	---------			-----------------------------------------
+	xpath				xpath expression with variables
+	query				prepared query
+	name				variable name without leading $
+	value				value to bind
+	nodes				node set to bind
+	cache				function cache of the evaluation context or NULL
+
+	"xpath_query_new" returns a new query or NULL if xpath is invalid
+*/
+XPathQuery* xpath_query_new(const char *xpath);
+void xpath_query_bind_str(XPathQuery *query, const char *name, const char *value);
+void xpath_query_bind_num(XPathQuery *query, const char *name, double value);
+void xpath_query_bind_nodes(XPathQuery *query, const char *name, xmlNodeSetPtr nodes);
+void xpath_query_bind_node(XPathQuery *query, const char *name, xmlNodePtr node);
+void xpath_query_clear(XPathQuery *query);
+void xpath_query_free(XPathQuery **query);
+xmlXPathCompExprPtr xpath_query_comp(XPathQuery *query, const XPathFuncCache *cache);
+
+/*
+	Variable lookup function for xmlXPathRegisterVariableLookup, data has to be the
+	XPathQuery. It returns a copy of the bound value or NULL for unbound variables.
+*/
+xmlXPathObjectPtr xpath_query_var_lookup(void *data, const xmlChar *name, const xmlChar *ns_uri);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_batch.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+static const char * const test_xml_batch_paths[] = {
+	"/hero/talents/group/talent[@name = 'Dolche']/@value",
+	"/hero/talents/group/talent[@name = 'Säbel']/@inc",
+	"/hero/talents/group/talent[@name = 'Klettern']/@test",
+	"/hero/talents/group[@name = 'Kampf']/talent",
+	"/hero/talents/group/talent[@inc = 'D']/..",
+	"/hero/talents/group/talent[last()]",
+	"/hero/attributes/attribute[@shortname = 'MU']/@value",
+	"/hero/attributes/attribute[@shortname = 'SO']/@value",
+	"/hero/attributes/attribute",
+	"/hero/@age",
+	"/hero/config/base-gp/@value",
+	"/hero/notfound/@value",
+	"//talent[@name = 'Raufen']/@inc",
+	"count(/hero/talents/group/talent)",
+	"/hero/attributes/attribute[1]/@value + 2",
+	"/hero/procontainer/group | /hero/contracontainer/group"
+};
+
+#define TEST_XML_BATCH_CNT ((int)(sizeof(test_xml_batch_paths) / sizeof(test_xml_batch_paths[0])))
+
+static bool test_xml_batch_same_nodes(xmlXPathObjectPtr batch, xmlXPathObjectPtr single) {
+
+	if ( batch == NULL || single == NULL || batch->type != single->type ) {
+		return false;
+	}
+
+	if ( batch->type != XPATH_NODESET ) {
+		return xmlXPathCastToNumber(batch) == xmlXPathCastToNumber(single);
+	}
+
+	const int cnt = ( batch->nodesetval != NULL ? batch->nodesetval->nodeNr : 0 );
+
+	if ( cnt != ( single->nodesetval != NULL ? single->nodesetval->nodeNr : 0 ) ) {
+		return false;
+	}
+
+	for ( int curnode = 0; curnode < cnt; ++curnode ) {
+		if ( batch->nodesetval->nodeTab[curnode] != single->nodesetval->nodeTab[curnode] ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void test_xml_batch_kinds() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "basehero");
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	const XmlBatchKind kinds[] = { XML_BATCH_NODESET, XML_BATCH_STRING, XML_BATCH_NUMBER, XML_BATCH_BOOLEAN, XML_BATCH_EXISTS };
+
+	for ( size_t curkind = 0; curkind < sizeof(kinds) / sizeof(kinds[0]); ++curkind ) {
+
+		XmlBatchQuery queries[TEST_XML_BATCH_CNT];
+
+		for ( int curquery = 0; curquery < TEST_XML_BATCH_CNT; ++curquery ) {
+			queries[curquery] = (XmlBatchQuery){ .xpath = test_xml_batch_paths[curquery], .kind = kinds[curkind] };
+		}
+
+		assert(xml_ctx_batch(ctx, queries, TEST_XML_BATCH_CNT) == 0);
+
+		for ( int curquery = 0; curquery < TEST_XML_BATCH_CNT; ++curquery ) {
+
+			XmlBatchQuery *query = &queries[curquery];
+			xmlXPathObjectPtr single = xml_ctx_xpath(ctx, query->xpath);
+
+			DEBUG_LOG_ARGS("kind: %i group: %i %s\n", query->kind, query->group, query->xpath);
+
+			assert(query->valid);
+
+			switch ( query->kind ) {
+				case XML_BATCH_NODESET:
+					assert(test_xml_batch_same_nodes(query->nodes, single));
+					break;
+				case XML_BATCH_STRING: {
+					xmlChar *expected = xmlXPathCastToString(single);
+					assert(xmlStrEqual(query->string, expected));
+					xmlFree(expected);
+					break;
+				}
+				case XML_BATCH_NUMBER: {
+					const double expected = xmlXPathCastToNumber(single);
+					assert(query->number == expected || ( isnan(query->number) && isnan(expected) ));
+					break;
+				}
+				case XML_BATCH_BOOLEAN:
+					assert(query->boolean == ( xmlXPathCastToBoolean(single) != 0 ));
+					break;
+				case XML_BATCH_EXISTS:
+					assert(query->boolean == xml_ctx_exist(ctx, query->xpath));
+					break;
+			}
+
+			xmlXPathFreeObject(single);
+		}
+
+		/* shared leading paths */
+		assert(queries[0].group >= 0 && queries[0].group == queries[1].group && queries[1].group == queries[2].group);
+		assert(queries[6].group >= 0 && queries[6].group == queries[7].group && queries[6].group != queries[0].group);
+		assert(queries[13].group == -1 && queries[14].group == -1 && queries[15].group == -1);
+
+		xml_batch_free(queries, TEST_XML_BATCH_CNT);
+		assert(queries[0].nodes == NULL && queries[0].string == NULL);
+	}
+
+	free_xml_ctx_src(&ctx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_batch_invalid() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "breeds");
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	XmlBatchQuery queries[] = {
+		{ .xpath = "/breeds/group/breed[@name = 'Die Tulamiden']/gp/@value", .kind = XML_BATCH_NUMBER },
+		{ .xpath = "/breeds/group/breed[", .kind = XML_BATCH_STRING },
+		{ .xpath = "/breeds/group/breed[@name = 'Die Tulamiden']/@name", .kind = XML_BATCH_STRING },
+		{ .xpath = "/breeds/group/notfound()", .kind = XML_BATCH_EXISTS },
+		{ .xpath = NULL, .kind = XML_BATCH_NODESET }
+	};
+
+	assert(xml_ctx_batch(ctx, queries, 5) == 3);
+
+	assert(queries[0].valid && queries[0].number == 0.);
+	assert(!queries[1].valid && queries[1].string == NULL);
+	assert(queries[2].valid && strcmp((const char *)queries[2].string, "Die Tulamiden") == 0);
+	assert(!queries[3].valid && !queries[3].boolean);
+	assert(!queries[4].valid && queries[4].nodes == NULL);
+
+	xml_batch_free(queries, 5);
+
+	assert(xml_ctx_batch(ctx, queries, 0) == 0);
+
+	XmlCtx *empty = xml_ctx_new_file("notfound.xml");
+	assert(xml_ctx_batch(empty, queries, 5) == -1);
+	free_xml_ctx_src(&empty);
+
+	free_xml_ctx_src(&ctx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int
+main()
+{
+
+	DEBUG_LOG(">> Start xml batch tests:\n");
+
+	test_xml_batch_kinds();
+
+	test_xml_batch_invalid();
+
+	DEBUG_LOG("<< end xml batch tests:\n");
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_cache.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+
+static void test_xml_cache_get() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlCache *cache = xml_cache_new(XML_CTX_OPT_COMPACT_READONLY, 0);
+
+	XmlCtx *first = xml_cache_get(cache, ar, "breeds");
+	XmlCtx *second = xml_cache_get(cache, ar, "breeds");
+	XmlCtx *talents = xml_cache_get(cache, ar, "talents");
+
+	assert(first != NULL && first == second);
+	assert(talents != NULL && talents != first);
+	assert(xml_ctx_exist(first, "/breeds"));
+
+	assert(xml_cache_get(cache, ar, "notfound") == NULL);
+
+	XmlCacheStats stats;
+	xml_cache_stats(cache, &stats);
+
+	DEBUG_LOG_ARGS("hits: %zu parses: %zu used: %zu\n", stats.hits, stats.parses, stats.used);
+
+	assert(stats.hits == 1 && stats.parses == 2 && stats.evictions == 0 && stats.failed == 1);
+	assert(xmlHashSize(cache->entries) == 2);
+	assert(stats.used > 0 && stats.budget == 0);
+
+	xml_cache_release(cache, &first);
+	xml_cache_release(cache, &second);
+	xml_cache_release(cache, &talents);
+	assert(first == NULL && second == NULL && talents == NULL);
+
+	/* unlimited budget keeps unused documents */
+	first = xml_cache_get(cache, ar, "breeds");
+	xml_cache_stats(cache, &stats);
+	assert(stats.hits == 2 && stats.parses == 2);
+	xml_cache_release(cache, &first);
+
+	/* documents of an archive are freed before the archive, except those with handles */
+	talents = xml_cache_get(cache, ar, "talents");
+
+	assert(xml_cache_archive_free(cache, ar) == 1);
+	assert(xmlHashSize(cache->entries) == 1);
+
+	xml_cache_stats(cache, &stats);
+	const size_t talentsUsed = stats.used;
+
+	xml_cache_release(cache, &talents);
+
+	assert(xml_cache_archive_free(cache, ar) == 0);
+	assert(xmlHashSize(cache->entries) == 0 && cache->head == NULL && cache->tail == NULL);
+
+	xml_cache_stats(cache, &stats);
+	assert(stats.used == 0 && talentsUsed > 0);
+
+	first = xml_cache_get(cache, ar, "breeds");
+	xml_cache_stats(cache, &stats);
+	assert(first != NULL && stats.parses == 3);
+	xml_cache_release(cache, &first);
+
+	xml_cache_free(&cache);
+	assert(cache == NULL);
+
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_cache_budget() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlCache *cache = xml_cache_new(XML_CTX_OPT_NONE, 0);
+
+	XmlCacheStats stats;
+
+	XmlCtx *breeds = xml_cache_get(cache, ar, "breeds");
+	xml_cache_stats(cache, &stats);
+	const size_t breedsSize = stats.used;
+
+	XmlCtx *talents = xml_cache_get(cache, ar, "talents");
+	xml_cache_stats(cache, &stats);
+	const size_t talentsSize = stats.used - breedsSize;
+
+	/* documents in use are never evicted */
+	xml_cache_set_budget(cache, 1);
+	xml_cache_stats(cache, &stats);
+	assert(stats.evictions == 0 && stats.used == breedsSize + talentsSize);
+
+	/* budget for talents only, breeds is least recently used */
+	xml_cache_set_budget(cache, talentsSize);
+	xml_cache_release(cache, &breeds);
+	xml_cache_release(cache, &talents);
+
+	xml_cache_stats(cache, &stats);
+	assert(stats.evictions == 1 && stats.used == talentsSize);
+
+	talents = xml_cache_get(cache, ar, "talents");
+	xml_cache_stats(cache, &stats);
+	assert(stats.parses == 2 && stats.hits == 1);
+
+	/* cold document is parsed again */
+	breeds = xml_cache_get(cache, ar, "breeds");
+	assert(breeds != NULL && xml_ctx_exist(breeds, "/breeds"));
+	xml_cache_stats(cache, &stats);
+	assert(stats.parses == 3);
+
+	xml_cache_release(cache, &breeds);
+	xml_cache_release(cache, &talents);
+
+	xml_cache_stats(cache, &stats);
+	assert(stats.used <= talentsSize);
+
+	xml_cache_free(&cache);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int 
+main() 
+{
+
+	DEBUG_LOG(">> Start xml cache tests:\n");
+
+	test_xml_cache_get();
+
+	test_xml_cache_budget();
+	
+	DEBUG_LOG("<< end xml cache tests:\n");
+
+	return 0;
+}
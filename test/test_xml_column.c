@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_column.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+static void test_xml_column_values() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] =
+		"<mods>"
+			"<mod value=\"3\"/><mod value=\" -12 \"/><mod value=\"2.5\"/><mod value=\"\"/>"
+			"<mod value=\"abc\"/><mod value=\"99999999999999999999\"/><mod value=\"12.0\"/>"
+			"<mod value=\"-0.125\"/><mod value=\"1e3\"/><mod>7</mod>"
+		"</mods>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	double dValues[16];
+	int64_t lValues[16];
+	XmlColumnError errors[16];
+
+	assert(xml_ctx_column_double(ctx, "/mods/mod/@value | /mods/mod[not(@value)]", 0, dValues, errors, 16) == 10);
+
+	assert(dValues[0] == 3. && errors[0] == XML_COLUMN_OK);
+	assert(dValues[1] == -12. && errors[1] == XML_COLUMN_OK);
+	assert(dValues[2] == 2.5 && errors[2] == XML_COLUMN_OK);
+	assert(isnan(dValues[3]) && errors[3] == XML_COLUMN_EMPTY);
+	assert(isnan(dValues[4]) && errors[4] == XML_COLUMN_INVALID);
+	assert(dValues[5] > 9.99e19 && errors[5] == XML_COLUMN_OK);
+	assert(dValues[6] == 12. && errors[6] == XML_COLUMN_OK);
+	assert(dValues[7] == -0.125 && errors[7] == XML_COLUMN_OK);
+	assert(dValues[8] == 1000. && errors[8] == XML_COLUMN_OK);
+	assert(dValues[9] == 7. && errors[9] == XML_COLUMN_OK);
+
+	assert(xml_ctx_column_int64(ctx, "/mods/mod/@value | /mods/mod[not(@value)]", 0, lValues, errors, 16) == 10);
+
+	assert(lValues[0] == 3 && errors[0] == XML_COLUMN_OK);
+	assert(lValues[1] == -12 && errors[1] == XML_COLUMN_OK);
+	assert(lValues[2] == 0 && errors[2] == XML_COLUMN_INVALID);
+	assert(lValues[3] == 0 && errors[3] == XML_COLUMN_EMPTY);
+	assert(lValues[4] == 0 && errors[4] == XML_COLUMN_INVALID);
+	assert(lValues[5] == 0 && errors[5] == XML_COLUMN_RANGE);
+	assert(lValues[6] == 12 && errors[6] == XML_COLUMN_OK);
+	assert(lValues[7] == 0 && errors[7] == XML_COLUMN_INVALID);
+	assert(lValues[8] == 1000 && errors[8] == XML_COLUMN_OK);
+	assert(lValues[9] == 7 && errors[9] == XML_COLUMN_OK);
+
+	/* only max values are written, errors are optional */
+	lValues[2] = -1;
+	assert(xml_ctx_column_int64(ctx, "/mods/mod/@value", 0, lValues, NULL, 2) == 9);
+	assert(lValues[0] == 3 && lValues[1] == -12 && lValues[2] == -1);
+
+	assert(xml_ctx_column_double(ctx, "/mods/notfound", 0, dValues, errors, 16) == 0);
+	assert(xml_ctx_column_double(ctx, "count(/mods/mod)", 0, dValues, errors, 16) == -1);
+	assert(xml_ctx_column_double(ctx, "/mods/mod[", XML_COLUMN_CACHE, dValues, errors, 16) == -1);
+
+	free_xml_ctx_src(&ctx);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_column_cache() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "basehero");
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	const char *xpath = "/hero/attributes/attribute/@value";
+	int64_t values[16];
+	int64_t cached[16];
+	XmlColumnError errors[16];
+
+	const int cnt = xml_ctx_column_int64(ctx, xpath, 0, values, errors, 16);
+
+	assert(cnt == 9);
+	assert(xml_ctx_column_int64(ctx, xpath, XML_COLUMN_CACHE, cached, errors, 16) == cnt);
+	assert(memcmp(values, cached, cnt * sizeof(int64_t)) == 0);
+	assert(ctx->columns != NULL && ctx->columns->next == NULL && ctx->columns->version == ctx->version);
+
+	for ( int curvalue = 0; curvalue < cnt; ++curvalue ) {
+		long expected = -1;
+		assert(xml_ctx_xpath_tol_format(ctx, &expected, "(%s)[%i]", xpath, curvalue + 1) == 0);
+		assert(values[curvalue] == expected && errors[curvalue] == XML_COLUMN_OK);
+	}
+
+	/* same column again, other type is another column */
+	const XmlColumn *column = ctx->columns;
+	assert(xml_ctx_column_int64(ctx, xpath, XML_COLUMN_CACHE, cached, errors, 16) == cnt);
+	assert(ctx->columns == column);
+
+	double dValues[16];
+	assert(xml_ctx_column_double(ctx, xpath, XML_COLUMN_CACHE, dValues, errors, 16) == cnt);
+	assert(ctx->columns != column && ctx->columns->next == column);
+	assert(dValues[0] == 8. && dValues[8] == 0.);
+
+	/* changes outdate the column */
+	xml_ctx_set_attr_str_xpath(ctx, (const unsigned char *)"14", "/hero/attributes/attribute[@shortname = 'MU']/@value");
+
+	assert(xml_ctx_column_int64(ctx, xpath, XML_COLUMN_CACHE, cached, errors, 16) == cnt);
+	assert(cached[0] == 14 && column->version == ctx->version);
+
+	xml_ctx_column_cache_free(ctx);
+	assert(ctx->columns == NULL);
+
+	free_xml_ctx_src(&ctx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int
+main()
+{
+
+	DEBUG_LOG(">> Start xml column tests:\n");
+
+	test_xml_column_values();
+
+	test_xml_column_cache();
+
+	DEBUG_LOG("<< end xml column tests:\n");
+
+	return 0;
+}
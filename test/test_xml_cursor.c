@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_cursor.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+typedef struct {
+	xmlNodePtr	nodes[512];
+	int			cnt;
+	int			stop;
+} TestXmlCursorNodes;
+
+static bool test_xml_cursor_collect(xmlNodePtr node, void *data) {
+	TestXmlCursorNodes *collected = data;
+	collected->nodes[collected->cnt++] = node;
+	return ( collected->cnt != collected->stop );
+}
+
+static bool test_xml_cursor_contains(xmlNodeSetPtr set, xmlNodePtr node) {
+	for ( int curnode = 0; set != NULL && curnode < set->nodeNr; ++curnode ) {
+		if ( set->nodeTab[curnode] == node ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* same nodes like xml_ctx_xpath, ordered compares the order too */
+static bool test_xml_cursor_same(XmlCtx *ctx, const char *xpath, int flags) {
+
+	TestXmlCursorNodes collected = { .cnt = 0, .stop = -1 };
+	const int cnt = xml_ctx_xpath_each_opts(ctx, xpath, flags, test_xml_cursor_collect, &collected);
+
+	xmlXPathObjectPtr expected = xml_ctx_xpath(ctx, xpath);
+	xmlNodeSetPtr set = expected->nodesetval;
+	bool same = ( cnt == collected.cnt && cnt == ( set != NULL ? set->nodeNr : 0 ) );
+
+	for ( int curnode = 0; same && curnode < cnt; ++curnode ) {
+		same = ( flags & XML_CURSOR_UNORDERED ? test_xml_cursor_contains(set, collected.nodes[curnode])
+											  : set->nodeTab[curnode] == collected.nodes[curnode] );
+	}
+
+	DEBUG_LOG_ARGS("%s (%i): %i nodes %s\n", xpath, flags, cnt, ( same ? "same" : "different" ));
+
+	xmlXPathFreeObject(expected);
+
+	return same;
+}
+
+static void test_xml_cursor_each() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "talents");
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	const char * const xpaths[] = {
+		"/talents/group/talent",
+		"//talent[@inc = 'D']",
+		"//group[@inc]//*",
+		"//notfound",
+		"/talents/group[2]/talent",
+		"//talent/@name",
+		"/talents/group[@inc = 'B']/talent[@value]/@inc",
+		"//talent[@inc = 'B']/..",
+		"/talents/group/talent[last()] | //group"
+	};
+
+	for ( size_t curxpath = 0; curxpath < sizeof(xpaths) / sizeof(xpaths[0]); ++curxpath ) {
+		assert(test_xml_cursor_same(ctx, xpaths[curxpath], XML_CURSOR_ORDERED));
+		assert(test_xml_cursor_same(ctx, xpaths[curxpath], XML_CURSOR_UNORDERED));
+	}
+
+	/* stop by callback */
+	TestXmlCursorNodes collected = { .cnt = 0, .stop = 3 };
+	assert(xml_ctx_xpath_each(ctx, "//talent", test_xml_cursor_collect, &collected) == 3);
+	assert(xmlStrEqual(collected.nodes[2]->name, (const xmlChar *)"talent"));
+
+	assert(xml_ctx_xpath_each(ctx, "//talent", NULL, NULL) == 132);
+	assert(xml_ctx_xpath_each(ctx, "count(//talent)", NULL, NULL) == -1);
+	assert(xml_ctx_xpath_each(ctx, "//talent[", NULL, NULL) == -1);
+	assert(xml_ctx_xpath_each_opts(ctx, "//talent/@name[", XML_CURSOR_UNORDERED, NULL, NULL) == -1);
+
+	/* steps with local axes are split like their abbreviations */
+	const char * const axes[] = {
+		"//talent[@inc = 'D']/self::talent/attribute::name",
+		"//group/child::talent",
+		"//group/self::node()/talent/@value"
+	};
+
+	for ( size_t curxpath = 0; curxpath < sizeof(axes) / sizeof(axes[0]); ++curxpath ) {
+		XmlCursor *cursor = xml_ctx_cursor_new(ctx, axes[curxpath], XML_CURSOR_UNORDERED);
+		assert(cursor != NULL && cursor->rest != NULL);
+		xml_cursor_free(&cursor);
+
+		assert(test_xml_cursor_same(ctx, axes[curxpath], XML_CURSOR_UNORDERED));
+	}
+
+	/* other axes are not local to the walked elements */
+	XmlCursor *cursor = xml_ctx_cursor_new(ctx, "//group/descendant::talent", XML_CURSOR_UNORDERED);
+	assert(cursor != NULL && cursor->rest == NULL);
+	xml_cursor_free(&cursor);
+
+	/* rests which are no location steps fail like the complete expression */
+	assert(xml_ctx_xpath_each_opts(ctx, "//talent/count(@value)", XML_CURSOR_UNORDERED, NULL, NULL) == -1);
+	assert(xml_ctx_cursor_new(ctx, "//talent/string(@name)", XML_CURSOR_UNORDERED) == NULL);
+
+	free_xml_ctx_src(&ctx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_cursor_namespace() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] =
+		"<a xmlns='urn:x'><b/><b/><c xmlns='' xmlns:p='urn:p'><b/><p:b/></c></a>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	/* like xpath, names only match elements without namespace */
+	assert(xml_ctx_xpath_each(ctx, "/a/b", NULL, NULL) == 0);
+	assert(xml_ctx_xpath_each(ctx, "//b", NULL, NULL) == 1);
+	assert(!xml_ctx_exist(ctx, "/a/b"));
+
+	const char * const xpaths[] = { "/a/b", "//b", "//*", "/*/*", "/*/c/*", "//c/b" };
+
+	for ( size_t curxpath = 0; curxpath < sizeof(xpaths) / sizeof(xpaths[0]); ++curxpath ) {
+		assert(test_xml_cursor_same(ctx, xpaths[curxpath], XML_CURSOR_ORDERED));
+		assert(test_xml_cursor_same(ctx, xpaths[curxpath], XML_CURSOR_UNORDERED));
+	}
+
+	free_xml_ctx_src(&ctx);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_cursor_fetch() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "talents");
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	const char * const xpaths[] = { "//talent", "//talent/@name", "(//talent)[position() > 2]" };
+	const int flags[] = { XML_CURSOR_ORDERED, XML_CURSOR_UNORDERED, XML_CURSOR_ORDERED };
+
+	for ( size_t curxpath = 0; curxpath < sizeof(xpaths) / sizeof(xpaths[0]); ++curxpath ) {
+
+		xmlXPathObjectPtr expected = xml_ctx_xpath(ctx, xpaths[curxpath]);
+		xmlNodeSetPtr set = expected->nodesetval;
+
+		XmlCursor *cursor = xml_ctx_cursor_new(ctx, xpaths[curxpath], flags[curxpath]);
+		xmlNodePtr page[20];
+
+		assert(cursor != NULL);
+
+		/* nodes 40 to 59 and 60 to 79 */
+		assert(xml_cursor_fetch(cursor, 40, 20, page) == 20);
+		assert(page[0] == set->nodeTab[40] && page[19] == set->nodeTab[59]);
+		assert(xml_cursor_fetch(cursor, 0, 20, page) == 20);
+		assert(page[0] == set->nodeTab[60] && page[19] == set->nodeTab[79]);
+
+		assert(xml_cursor_next(cursor) == set->nodeTab[80]);
+
+		/* last page */
+		const int left = set->nodeNr - 81;
+		assert(xml_cursor_fetch(cursor, left - 5, 20, page) == 5);
+		assert(page[4] == set->nodeTab[set->nodeNr - 1]);
+		assert(xml_cursor_next(cursor) == NULL);
+		assert(xml_cursor_fetch(cursor, 0, 20, page) == 0);
+
+		xml_cursor_free(&cursor);
+		assert(cursor == NULL);
+
+		xmlXPathFreeObject(expected);
+	}
+
+	assert(xml_ctx_cursor_new(ctx, "sum(//talent/@value)", XML_CURSOR_ORDERED) == NULL);
+
+	free_xml_ctx_src(&ctx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int
+main()
+{
+
+	DEBUG_LOG(">> Start xml cursor tests:\n");
+
+	test_xml_cursor_each();
+
+	test_xml_cursor_namespace();
+
+	test_xml_cursor_fetch();
+
+	DEBUG_LOG("<< end xml cursor tests:\n");
+
+	return 0;
+}
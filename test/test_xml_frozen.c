@@ -0,0 +1,171 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_frozen.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+static bool test_xml_frozen_same_count(XmlCtx *ctx, XmlFrozen *frozen, const char *path) {
+
+	char xpath[256];
+	snprintf(xpath, sizeof(xpath), "count(%s)", path);
+
+	double expected = -1.;
+	xml_ctx_xpath_tod(ctx, &expected, xpath);
+
+	const int cnt = xml_frozen_count(frozen, path);
+
+	DEBUG_LOG_ARGS("%s: %.0f %i\n", path, expected, cnt);
+
+	return expected == (double)cnt;
+}
+
+static void test_xml_frozen_select() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "breeds");
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	XmlFrozen *frozen = xml_ctx_freeze(ctx);
+
+	assert(frozen != NULL && frozen->owned != NULL && frozen->mapped == NULL);
+	assert(strcmp(xml_frozen_name(frozen, 0), "breeds") == 0);
+	assert(frozen->nodes[0].parent == -1);
+
+	DEBUG_LOG_ARGS("nodes: %u attrs: %u names: %u strings: %u size: %zu\n", frozen->header->node_cnt,
+		frozen->header->attr_cnt, frozen->header->name_cnt, frozen->header->string_size, frozen->size);
+
+	assert(test_xml_frozen_same_count(ctx, frozen, "//*"));
+	assert(test_xml_frozen_same_count(ctx, frozen, "/breeds/group/breed"));
+	assert(test_xml_frozen_same_count(ctx, frozen, "//color"));
+	assert(test_xml_frozen_same_count(ctx, frozen, "/breeds//breed[@name = 'Die Tulamiden']//culture"));
+	assert(test_xml_frozen_same_count(ctx, frozen, "//group[@name]"));
+	assert(xml_frozen_count(frozen, "//notfound") == 0);
+	assert(xml_frozen_count(frozen, "breed[") == -1);
+
+	XmlFrozenNodes breeds;
+	assert(xml_frozen_select(frozen, "/breeds/group/breed[@name = 'Die Tulamiden']", &breeds) == 0);
+	assert(breeds.cnt == 1);
+
+	const int32_t breed = breeds.nodes[0];
+	assert(strcmp(xml_frozen_name(frozen, breed), "breed") == 0);
+	assert(strcmp(xml_frozen_attr(frozen, breed, "name"), "Die Tulamiden") == 0);
+	assert(xml_frozen_attr(frozen, breed, "notfound") == NULL);
+	assert(strcmp(xml_frozen_attr(frozen, frozen->nodes[breed].parent, "name"), "Tulamiden") == 0);
+	assert(strcmp(xml_frozen_name(frozen, frozen->nodes[breed].first_child), "gp") == 0);
+
+	xml_frozen_nodes_free(&breeds);
+	assert(breeds.nodes == NULL && breeds.cnt == 0);
+
+	assert(strcmp(xml_frozen_value(frozen, "//breed[@name = 'Die Tulamiden']/gp/@value"), "0") == 0);
+	assert(xml_frozen_value(frozen, "//breed[@name = 'Die Tulamiden']/gp/@notfound") == NULL);
+	assert(xml_frozen_value(frozen, "//breed[@name = 'Die Tulamiden']/gp") == NULL);
+
+	xml_frozen_free(&frozen);
+	assert(frozen == NULL);
+
+	free_xml_ctx(&ctx);
+	xml_source_free(&source);
+
+	/* text of elements */
+	source = xml_source_from_resname(ar, "cultures");
+	ctx = xml_ctx_new(source);
+	frozen = xml_ctx_freeze(ctx);
+
+	assert(strcmp(xml_frozen_value(frozen, "//culture[@name = 'Mittelländische Städte']/shortdescription/text()"), "small test description") == 0);
+	assert(xml_frozen_text(frozen, 0) == NULL);
+
+	xml_frozen_free(&frozen);
+	free_xml_ctx(&ctx);
+	xml_source_free(&source);
+
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_frozen_map() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "talents");
+	XmlCtx *ctx = xml_ctx_new(source);
+	const char *frozenFile = "test_xml_frozen.xfrz";
+
+	XmlFrozen *frozen = xml_ctx_freeze(ctx);
+	assert(xml_frozen_save(frozen, frozenFile) == 0);
+
+	XmlFrozen *mapped = xml_frozen_map(frozenFile);
+
+	assert(mapped != NULL && mapped->mapped != NULL && mapped->owned == NULL);
+	assert(mapped->size == frozen->size);
+	assert(test_xml_frozen_same_count(ctx, mapped, "//talent"));
+	assert(strcmp(xml_frozen_value(mapped, "//talent[@name = 'Dolche']/@inc"), "D") == 0);
+
+	xml_frozen_free(&mapped);
+
+	/* damaged blocks */
+	unsigned char *data = malloc(frozen->size);
+	memcpy(data, frozen->header, frozen->size);
+
+	assert(xml_frozen_from_memory(data, frozen->size - 1) == NULL);
+
+	XmlFrozenNode *nodes = (XmlFrozenNode *)(data + sizeof(XmlFrozenHeader));
+	nodes[1].next_sibling = 1;
+	assert(xml_frozen_from_memory(data, frozen->size) == NULL);
+	nodes[1].next_sibling = frozen->nodes[1].next_sibling;
+
+	mapped = xml_frozen_from_memory(data, frozen->size);
+	assert(mapped != NULL && mapped->owned == NULL);
+	xml_frozen_free(&mapped);
+
+	free(data);
+
+	assert(xml_frozen_map("notfound.xfrz") == NULL);
+
+	remove(frozenFile);
+
+	xml_frozen_free(&frozen);
+	free_xml_ctx(&ctx);
+	xml_source_free(&source);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int
+main()
+{
+
+	DEBUG_LOG(">> Start xml frozen tests:\n");
+
+	test_xml_frozen_select();
+
+	test_xml_frozen_map();
+
+	DEBUG_LOG("<< end xml frozen tests:\n");
+
+	return 0;
+}
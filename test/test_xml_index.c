@@ -0,0 +1,322 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_index.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+static void test_xml_index_lookup() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "talents");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	assert(xml_ctx_index_lookup(nCtx, "talent", "Dolche", NULL) == 0);
+
+	assert(xml_ctx_index_create(nCtx, "talent", "talent", "name") == 0);
+
+	xmlNodePtr *nodes = NULL;
+	int cnt = xml_ctx_index_lookup(nCtx, "talent", "Dolche", &nodes);
+
+	assert(cnt == 1);
+	assert(xmlStrEqual(nodes[0]->name, (const xmlChar *)"talent"));
+
+	xmlXPathObjectPtr found = xml_ctx_xpath(nCtx, "//talent[@name = 'Dolche']");
+	assert(xml_xpath_has_result(found) && found->nodesetval->nodeTab[0] == nodes[0]);
+	xmlXPathFreeObject(found);
+
+	assert(xml_ctx_index_lookup(nCtx, "talent", "notfound", &nodes) == 0 && nodes == NULL);
+	assert(xml_ctx_index_lookup(nCtx, "notfound", "Dolche", &nodes) == 0);
+
+	assert(xml_ctx_index_create(nCtx, "type", "*", "type") == 0);
+
+	double cntBase = 0, cntIndexed = 0;
+	assert(xml_ctx_xpath_tod(nCtx, &cntBase, "count(//*[@type = 'base'])") == 0);
+	assert(xml_ctx_xpath_tod(nCtx, &cntIndexed, "count(key('type', 'base'))") == 0);
+	assert(cntBase > 1 && cntBase == cntIndexed);
+	assert(xml_ctx_index_lookup(nCtx, "type", "base", NULL) == (int)cntBase);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_index_xpath() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "talents");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	xml_ctx_index_create(nCtx, "talent", "talent", "name");
+
+	assert(xml_ctx_exist(nCtx, "key('talent', 'Dolche')[@inc = 'D']"));
+	assert(!xml_ctx_exist(nCtx, "key('talent', 'Dolche')[@inc = 'C']"));
+	assert(!xml_ctx_exist(nCtx, "key('talent', 'notfound')"));
+	assert(!xml_ctx_exist(nCtx, "key('notfound', 'Dolche')"));
+
+	double cnt = 0;
+	assert(xml_ctx_xpath_tod(nCtx, &cnt, "count(key('talent', //group[@name = 'Kampf']/talent[position() < 4]/@name))") == 0);
+	assert(cnt == 3.);
+
+	xmlChar *inc = xml_ctx_get_attr(nCtx, (const unsigned char *)"inc", "key('talent', 'Raufen')");
+	assert(inc != NULL && xmlStrEqual(inc, (const xmlChar *)"C"));
+	xmlFree(inc);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_index_invalidation() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "talents");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	xml_ctx_index_create(nCtx, "talent", "talent", "name");
+
+	assert(xml_ctx_index_lookup(nCtx, "talent", "Dolche", NULL) == 1);
+
+	xml_ctx_set_attr_str_xpath(nCtx, (const unsigned char *)"Messer", "//talent[@name = 'Dolche']/@name");
+
+	assert(xml_ctx_index_lookup(nCtx, "talent", "Dolche", NULL) == 0);
+	assert(xml_ctx_index_lookup(nCtx, "talent", "Messer", NULL) == 1);
+
+	xml_ctx_remove(nCtx, "key('talent', 'Messer')");
+
+	assert(xml_ctx_index_lookup(nCtx, "talent", "Messer", NULL) == 0);
+	assert(!xml_ctx_exist(nCtx, "key('talent', 'Messer')"));
+
+	XmlCtx *hCtx = xml_ctx_new_empty_root_name("talents");
+	xml_ctx_index_create(hCtx, "talent", "talent", "name");
+	assert(xml_ctx_index_lookup(hCtx, "talent", "Raufen", NULL) == 0);
+
+	xml_ctx_nodes_add_xpath(nCtx, "key('talent', 'Raufen')", hCtx, "/talents");
+	assert(xml_ctx_index_lookup(hCtx, "talent", "Raufen", NULL) == 1);
+
+	xml_ctx_index_free(hCtx, "talent");
+	assert(xml_ctx_index_lookup(hCtx, "talent", "Raufen", NULL) == 0);
+
+	free_xml_ctx_src(&hCtx);
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_index_numeric() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "equipments");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	assert(xml_ctx_numindex_range(nCtx, "weight", 0., 100., NULL) == 0);
+	assert(!xml_ctx_numindex_min(nCtx, "weight", NULL));
+
+	assert(xml_ctx_numindex_create(nCtx, "weight", "eq", "weight") == 0);
+
+	const XmlNumIndexEntry *entries = NULL;
+	double cntExpected = 0;
+
+	int cnt = xml_ctx_numindex_range(nCtx, "weight", 10., 60., &entries);
+	assert(xml_ctx_xpath_tod(nCtx, &cntExpected, "count(//eq[@weight >= 10 and @weight <= 60])") == 0);
+	assert(cnt > 1 && cnt == (int)cntExpected);
+
+	for (int cur = 0; cur < cnt; ++cur) {
+		assert(entries[cur].value >= 10. && entries[cur].value <= 60.);
+		assert(cur == 0 || entries[cur - 1].value <= entries[cur].value);
+	}
+
+	assert(xml_ctx_numindex_range(nCtx, "weight", 60., 10., &entries) == 0 && entries == NULL);
+
+	XmlNumIndexEntry min, max;
+	double minExpected = 0, maxExpected = 0;
+	assert(xml_ctx_numindex_min(nCtx, "weight", &min) && xml_ctx_numindex_max(nCtx, "weight", &max));
+	assert(xml_ctx_xpath_tod(nCtx, &minExpected, "min(//eq/@weight[number(.) = number(.)])") == 0);
+	assert(xml_ctx_xpath_tod(nCtx, &maxExpected, "max(//eq/@weight[number(.) = number(.)])") == 0);
+	assert(min.value == minExpected && max.value == maxExpected);
+
+	cnt = xml_ctx_numindex_top(nCtx, "weight", 3, &entries);
+	assert(cnt == 3 && entries[2].value == maxExpected && entries[0].value <= entries[1].value);
+
+	cnt = xml_ctx_numindex_bottom(nCtx, "weight", 3, &entries);
+	assert(cnt == 3 && entries[0].value == minExpected);
+
+	xml_ctx_numindex_free(nCtx, "weight");
+	assert(!xml_ctx_numindex_max(nCtx, "weight", NULL));
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_index_numeric_update() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "equipments");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	xml_ctx_numindex_create(nCtx, "weight", "eq", "weight");
+	xml_ctx_index_create(nCtx, "eq", "eq", "name");
+
+	const XmlNumIndexEntry *entries = NULL;
+	xmlNodePtr *nodes = NULL;
+	const int cntBefore = xml_ctx_numindex_range(nCtx, "weight", -1e9, 1e9, NULL);
+	const unsigned long version = nCtx->version;
+
+	xml_ctx_set_attr_str_xpath(nCtx, (const unsigned char *)"123456", "//eq[@name = 'Schultergurt']/@weight");
+
+	/* index was updated in place, no rebuild needed */
+	assert(nCtx->version != version);
+	assert(xml_ctx_numindex_top(nCtx, "weight", 1, &entries) == 1);
+	assert(entries[0].value == 123456.);
+	assert(xml_ctx_index_lookup(nCtx, "eq", "Schultergurt", &nodes) == 1 && entries[0].node == nodes[0]);
+	assert(xml_ctx_numindex_range(nCtx, "weight", -1e9, 1e9, NULL) == cntBefore);
+	assert(xml_ctx_numindex_range(nCtx, "weight", 123456., 123456., NULL) == 1);
+
+	xml_ctx_set_attr_str_xpath(nCtx, (const unsigned char *)"none", "//eq[@name = 'Schultergurt']/@weight");
+	assert(xml_ctx_numindex_range(nCtx, "weight", -1e9, 1e9, NULL) == cntBefore - 1);
+	assert(xml_ctx_numindex_range(nCtx, "weight", 123456., 123456., NULL) == 0);
+
+	xml_ctx_set_attr_str_xpath(nCtx, (const unsigned char *)"Gurt", "//eq[@name = 'Schultergurt']/@name");
+	assert(xml_ctx_index_lookup(nCtx, "eq", "Schultergurt", NULL) == 0);
+	assert(xml_ctx_index_lookup(nCtx, "eq", "Gurt", NULL) == 1);
+
+	double cntExpected = 0;
+	xml_ctx_set_attr_str_xpath(nCtx, (const unsigned char *)"1", "//eq[@weight = 40]/@weight");
+	assert(xml_ctx_xpath_tod(nCtx, &cntExpected, "count(//eq[@weight = 1])") == 0);
+	assert(xml_ctx_numindex_range(nCtx, "weight", 1., 1., &entries) == (int)cntExpected);
+	assert(xml_ctx_numindex_range(nCtx, "weight", 40., 40., NULL) == 0);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_index_numeric_move() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] =
+		"<items><item w=\"0\"/><item w=\"1\"/><item w=\"2\"/><item w=\"3\"/><item w=\"9\"/></items>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	assert(xml_ctx_numindex_create(nCtx, "w", "item", "w") == 0);
+
+	/* smallest value moves into the middle of the range */
+	xml_ctx_set_attr_str_xpath(nCtx, (const unsigned char *)"5", "/items/item[@w = 0]/@w");
+
+	const XmlNumIndexEntry *entries = NULL;
+	const double expected[] = { 1., 2., 3., 5., 9. };
+
+	assert(xml_ctx_numindex_bottom(nCtx, "w", 5, &entries) == 5);
+	for ( int curentry = 0; curentry < 5; ++curentry ) {
+		assert(entries[curentry].value == expected[curentry]);
+	}
+
+	assert(xml_ctx_numindex_range(nCtx, "w", 4., 6., &entries) == 1 && entries[0].value == 5.);
+	assert(xml_ctx_numindex_top(nCtx, "w", 1, &entries) == 1 && entries[0].value == 9.);
+
+	XmlNumIndexEntry min, max;
+	assert(xml_ctx_numindex_min(nCtx, "w", &min) && min.value == 1.);
+	assert(xml_ctx_numindex_max(nCtx, "w", &max) && max.value == 9.);
+
+	free_xml_ctx_src(&nCtx);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_index_namespace() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] =
+		"<items xmlns:x=\"urn:x\">"
+			"<item id=\"a\" w=\"1\"/><x:item id=\"a\" w=\"2\"/><item x:id=\"a\" x:w=\"3\"/>"
+			"<x:other id=\"a\" w=\"4\"/>"
+		"</items>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	/* key() finds the same elements like the xpath over names */
+	assert(xml_ctx_index_create(nCtx, "item", "item", "id") == 0);
+	assert(xml_ctx_index_create(nCtx, "all", "*", "id") == 0);
+
+	double cnt = 0;
+	assert(xml_ctx_xpath_tod(nCtx, &cnt, "count(key('item', 'a'))") == 0 && cnt == 1.);
+	assert(xml_ctx_xpath_tod(nCtx, &cnt, "count(//item[@id = 'a'])") == 0 && cnt == 1.);
+	assert(xml_ctx_xpath_tod(nCtx, &cnt, "count(key('all', 'a'))") == 0 && cnt == 3.);
+	assert(xml_ctx_xpath_tod(nCtx, &cnt, "count(//*[@id = 'a'])") == 0 && cnt == 3.);
+
+	assert(xml_ctx_numindex_create(nCtx, "w", "item", "w") == 0);
+
+	const XmlNumIndexEntry *entries = NULL;
+	assert(xml_ctx_numindex_bottom(nCtx, "w", 4, &entries) == 1 && entries[0].value == 1.);
+
+	/* changes of elements in a namespace keep out of the index */
+	xml_ctx_set_attr_str_xpath(nCtx, (const unsigned char *)"5", "/items/*[@w = 2]/@w");
+
+	assert(xml_ctx_numindex_bottom(nCtx, "w", 4, &entries) == 1 && entries[0].value == 1.);
+	assert(xml_ctx_xpath_tod(nCtx, &cnt, "count(key('item', 'a'))") == 0 && cnt == 1.);
+
+	free_xml_ctx_src(&nCtx);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int 
+main() 
+{
+
+	DEBUG_LOG(">> Start xml index tests:\n");
+	
+	test_xml_index_lookup();
+
+	test_xml_index_xpath();
+
+	test_xml_index_invalidation();
+
+	test_xml_index_numeric();
+
+	test_xml_index_numeric_update();
+
+	test_xml_index_numeric_move();
+
+	test_xml_index_namespace();
+	
+	DEBUG_LOG("<< end xml index tests:\n");
+
+	return 0;
+}
+
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_load.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+static const char * const test_xml_load_names[] = {
+	"armor", "basehero", "breeds", "creatures", "cultures", "equipments", "herbs", "liturgies",
+	"procontra", "professions", "specialabilities", "spells", "talents", "towns", "weapons"
+};
+
+#define TEST_XML_LOAD_CNT ((int)(sizeof(test_xml_load_names) / sizeof(test_xml_load_names[0])))
+
+static double test_xml_load_elements(XmlCtx *ctx) {
+	double cnt = -1.;
+	xml_ctx_xpath_tod(ctx, &cnt, "count(//*)");
+	return cnt;
+}
+
+static void test_xml_load_many() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	const int threads[] = { 0, 1, 4 };
+
+	for ( size_t curthreads = 0; curthreads < sizeof(threads) / sizeof(threads[0]); ++curthreads ) {
+
+		XmlCtx *ctxs[TEST_XML_LOAD_CNT];
+
+		const int success = xml_ctx_new_many(ar, test_xml_load_names, TEST_XML_LOAD_CNT, XML_CTX_OPT_NONE, threads[curthreads], ctxs);
+
+		DEBUG_LOG_ARGS("threads: %i parsed: %i\n", threads[curthreads], success);
+
+		assert(success == TEST_XML_LOAD_CNT);
+
+		for ( int curctx = 0; curctx < TEST_XML_LOAD_CNT; ++curctx ) {
+
+			XmlSource *source = xml_source_from_resname(ar, test_xml_load_names[curctx]);
+			XmlCtx *expected = xml_ctx_new(source);
+
+			assert(ctxs[curctx]->state.state_no == XML_CTX_SUCCESS && ctxs[curctx]->doc != NULL);
+			assert(test_xml_load_elements(ctxs[curctx]) == test_xml_load_elements(expected));
+
+			free_xml_ctx_src(&expected);
+			free_xml_ctx_src(&ctxs[curctx]);
+		}
+	}
+
+	/* missing resources have an error state */
+	const char * const names[] = { "breeds", "notfound", "talents" };
+	XmlCtx *ctxs[3];
+
+	assert(xml_ctx_new_many(ar, names, 3, XML_CTX_OPT_COMPACT_READONLY, 2, ctxs) == 2);
+	assert(ctxs[0]->doc != NULL && xml_ctx_exist(ctxs[0], "/breeds"));
+	assert(ctxs[1]->doc == NULL && ctxs[1]->state.state_no == XML_CTX_ERROR);
+	assert(ctxs[2]->doc != NULL && xml_ctx_exist(ctxs[2], "/talents"));
+
+	for ( int curctx = 0; curctx < 3; ++curctx ) {
+		free_xml_ctx_src(&ctxs[curctx]);
+	}
+
+	assert(xml_ctx_new_many(ar, names, 0, XML_CTX_OPT_NONE, 0, ctxs) == 0);
+
+	/* all documents of the index are parsed concurrently */
+	xml_source_archive_index(ar);
+
+	XmlCtx *indexed[TEST_XML_LOAD_CNT];
+	assert(xml_ctx_new_many(ar, test_xml_load_names, TEST_XML_LOAD_CNT, XML_CTX_OPT_NONE, 4, indexed) == TEST_XML_LOAD_CNT);
+
+	for ( int curctx = 0; curctx < TEST_XML_LOAD_CNT; ++curctx ) {
+		assert(indexed[curctx]->src->type == RESOURCE_FILE_INDEXED);
+		free_xml_ctx_src(&indexed[curctx]);
+	}
+
+	xml_source_archive_index_free(ar);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_load_matching() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+
+	XmlCtxList all;
+	const int success = xml_ctx_new_matching(ar, "^xml/.*\\.xml$", XML_CTX_OPT_COMPACT_READONLY, 0, &all);
+
+	DEBUG_LOG_ARGS("matching: %i parsed: %i\n", all.cnt, success);
+
+	assert(all.cnt == TEST_XML_LOAD_CNT && success == TEST_XML_LOAD_CNT);
+
+	for ( int curctx = 0; curctx < all.cnt; ++curctx ) {
+		assert(all.ctxs[curctx]->doc != NULL);
+		assert(all.ctxs[curctx]->src->type == RESOURCE_FILE);
+		DEBUG_LOG_ARGS("%s: %.0f elements\n", all.ctxs[curctx]->src->data.resfile->name, test_xml_load_elements(all.ctxs[curctx]));
+	}
+
+	xml_ctx_list_free(&all);
+	assert(all.ctxs == NULL && all.cnt == 0);
+
+	assert(xml_ctx_new_matching(ar, "^notfound$", XML_CTX_OPT_NONE, 0, &all) == 0);
+	assert(all.cnt == 0);
+	xml_ctx_list_free(&all);
+
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int
+main()
+{
+
+	DEBUG_LOG(">> Start xml load tests:\n");
+
+	test_xml_load_many();
+
+	test_xml_load_matching();
+
+	DEBUG_LOG("<< end xml load tests:\n");
+
+	return 0;
+}
@@ -0,0 +1,188 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_record.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+typedef struct {
+	char	name[10];
+	char	*unit;
+	int		price;
+	double	weight;
+} Eq;
+
+typedef struct {
+	char	*name;
+	char	inc[2];
+	int		value;
+} Talent;
+
+static const XmlRecordField eq_fields[] = {
+	XML_RECORD_FIELD(Eq, name, "name", XML_RECORD_CHARS),
+	XML_RECORD_FIELD(Eq, unit, "price_unit", XML_RECORD_STRING),
+	XML_RECORD_FIELD(Eq, price, "price", XML_RECORD_INT),
+	XML_RECORD_FIELD(Eq, weight, "weight", XML_RECORD_DOUBLE)
+};
+
+static const XmlRecordField talent_fields[] = {
+	XML_RECORD_FIELD(Talent, name, "name", XML_RECORD_STRING),
+	XML_RECORD_FIELD(Talent, inc, "inc", XML_RECORD_CHARS),
+	XML_RECORD_FIELD(Talent, value, "value", XML_RECORD_INT)
+};
+
+static void test_xml_record_extract() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "equipments");
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	XmlRecordDesc descs[] = {
+		{ "//eq", sizeof(Eq), eq_fields, 4 },
+		{ "/equipments/group[@id = 'weapon_armory_utils']/eq", sizeof(Eq), eq_fields, 4 }
+	};
+	XmlRecords records[2];
+
+	assert(xml_record_extract(source, descs, 2, records) == 0);
+
+	double cntExpected = 0;
+	assert(xml_ctx_xpath_tod(nCtx, &cntExpected, "count(//eq)") == 0);
+	assert(records[0].cnt == (int)cntExpected);
+	assert(xml_ctx_xpath_tod(nCtx, &cntExpected, "count(/equipments/group[@id = 'weapon_armory_utils']/eq)") == 0);
+	assert(records[1].cnt == (int)cntExpected && records[1].cnt < records[0].cnt);
+
+	Eq *eqs = records[0].records;
+
+	/* <eq name="Schwertgürtel" weight="40" price="15" price_unit="S" /> */
+	/* truncated to 9 bytes without cutting "ü" */
+	assert(strcmp(eqs[0].name, "Schwertg") == 0);
+	assert(strcmp(eqs[0].unit, "S") == 0);
+	assert(eqs[0].price == 15 && eqs[0].weight == 40.);
+
+	assert(strcmp(eqs[1].name, "Schwertg") == 0);
+	assert(strcmp(eqs[1].unit, "S") == 0);
+
+	/* <eq name="Schwertscheide" weight="60" price="15+" price_unit="S" /> */
+	assert(strcmp(eqs[3].name, "Schwertsc") == 0 && eqs[3].price == 0);
+	assert(records[0].errors > 0);
+
+	for (int cur = 0; cur < records[1].cnt; ++cur) {
+		assert(memcmp(&((Eq*)records[1].records)[cur], &eqs[cur], offsetof(Eq, unit)) == 0);
+	}
+
+	xml_records_free(&records[0]);
+	xml_records_free(&records[1]);
+	assert(records[0].records == NULL && records[0].cnt == 0 && records[0].strings == NULL);
+
+	assert(xml_record_extract(source, (XmlRecordDesc[]){ { "eq", sizeof(Eq), eq_fields, 4 } }, 1, records) == -1);
+	assert(records[0].cnt == 0);
+	xml_records_free(&records[0]);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_record_talents() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "talents");
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	XmlRecordDesc desc = { "//talent[@type = 'base']", sizeof(Talent), talent_fields, 3 };
+	XmlRecords records;
+
+	assert(xml_record_extract(source, &desc, 1, &records) == 0);
+
+	double cntExpected = 0;
+	assert(xml_ctx_xpath_tod(nCtx, &cntExpected, "count(//talent[@type = 'base'])") == 0);
+	assert(records.cnt == (int)cntExpected);
+	assert(records.errors == 0);
+
+	Talent *talents = records.records;
+
+	for (int cur = 0; cur < records.cnt; ++cur) {
+		assert(talents[cur].name != NULL && strlen(talents[cur].inc) == 1);
+	}
+
+	assert(strcmp(talents[0].name, "Dolche") == 0 && talents[0].inc[0] == 'D' && talents[0].value == 0);
+	assert(strcmp(talents[2].name, "Raufen") == 0 && talents[2].inc[0] == 'C');
+
+	xml_records_free(&records);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_record_escaped() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] =
+		"<talents>"
+			"<talent name=\"Hieb &amp; Stich\" inc=\"&#68;\" value=\"&#51;\" type=\"a &amp; b\"/>"
+			"<talent name=\"&lt;Raufen&gt;\" inc=\"C\" value=\"1\" type=\"a &amp; b\"/>"
+			"<talent name=\"Dolche\" inc=\"D\" value=\"2\" type=\"a b\"/>"
+		"</talents>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+
+	/* predicates and values see the replaced text like xpath */
+	XmlRecordDesc desc = { "//talent[@type = 'a & b']", sizeof(Talent), talent_fields, 3 };
+	XmlRecords records;
+
+	assert(xml_record_extract(source, &desc, 1, &records) == 0);
+	assert(records.cnt == 2 && records.errors == 0);
+
+	Talent *talents = records.records;
+
+	assert(strcmp(talents[0].name, "Hieb & Stich") == 0 && talents[0].inc[0] == 'D' && talents[0].value == 3);
+	assert(strcmp(talents[1].name, "<Raufen>") == 0);
+
+	xml_records_free(&records);
+	xml_source_free(&source);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int 
+main() 
+{
+
+	DEBUG_LOG(">> Start xml record tests:\n");
+
+	test_xml_record_extract();
+
+	test_xml_record_talents();
+
+	test_xml_record_escaped();
+	
+	DEBUG_LOG("<< end xml record tests:\n");
+
+	return 0;
+}
@@ -0,0 +1,240 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_snapshot.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+static bool test_xml_snapshot_same(XmlCtx *first, XmlCtx *second, const char *xpath) {
+
+	double firstValue = -1., secondValue = -2.;
+
+	xml_ctx_xpath_tod(first, &firstValue, xpath);
+	xml_ctx_xpath_tod(second, &secondValue, xpath);
+
+	DEBUG_LOG_ARGS("%s: %.0f %.0f\n", xpath, firstValue, secondValue);
+
+	return firstValue == secondValue;
+}
+
+static void test_xml_snapshot_roundtrip() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	const char *names[] = { "breeds", "talents", "basehero" };
+
+	for ( size_t curname = 0; curname < sizeof(names) / sizeof(names[0]); ++curname ) {
+
+		XmlSource* source = xml_source_from_resname(ar, names[curname]);
+		XmlCtx *ctx = xml_ctx_new(source);
+
+		size_t size = 0;
+		unsigned char *snapshot = xml_snapshot_write(ctx, &size);
+
+		DEBUG_LOG_ARGS("%s: xml %zu snapshot %zu bytes\n", names[curname], *source->src_size, size);
+
+		assert(snapshot != NULL && size > 0);
+		assert(xml_snapshot_current(snapshot, size, source));
+
+		XmlCtx *loaded = xml_snapshot_load(snapshot, size);
+
+		assert(loaded->doc != NULL && loaded->state.state_no == XML_CTX_SUCCESS);
+		assert(test_xml_snapshot_same(ctx, loaded, "count(//node())"));
+		assert(test_xml_snapshot_same(ctx, loaded, "count(//*)"));
+		assert(test_xml_snapshot_same(ctx, loaded, "count(//@*)"));
+		assert(test_xml_snapshot_same(ctx, loaded, "string-length(string(/*))"));
+		assert(test_xml_snapshot_same(ctx, loaded, "sum(//@*[number(.) = number(.)])"));
+		assert(xmlStrEqual(xmlDocGetRootElement(ctx->doc)->name, xmlDocGetRootElement(loaded->doc)->name));
+
+		free_xml_ctx(&loaded);
+		free(snapshot);
+		free_xml_ctx(&ctx);
+		xml_source_free(&source);
+	}
+
+	/* loaded documents behave like parsed ones */
+	XmlSource* source = xml_source_from_resname(ar, "talents");
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	size_t size = 0;
+	unsigned char *snapshot = xml_snapshot_write(ctx, &size);
+	XmlCtx *loaded = xml_snapshot_load(snapshot, size);
+
+	xml_ctx_set_attr_str_xpath(loaded, (const unsigned char *)"3", "/talents/group/talent[@name = 'Dolche']/@value");
+
+	double value = 0.;
+	assert(xml_ctx_xpath_tod(loaded, &value, "/talents/group/talent[@name = 'Dolche']/@value") == 0 && value == 3.);
+
+	free_xml_ctx(&loaded);
+	free(snapshot);
+	free_xml_ctx(&ctx);
+	xml_source_free(&source);
+
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_snapshot_stale() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* breeds = xml_source_from_resname(ar, "breeds");
+	XmlSource* talents = xml_source_from_resname(ar, "talents");
+	XmlCtx *ctx = xml_ctx_new(breeds);
+
+	size_t size = 0;
+	unsigned char *snapshot = xml_snapshot_write(ctx, &size);
+
+	/* snapshot of other xml */
+	assert(xml_snapshot_current(snapshot, size, breeds));
+	assert(!xml_snapshot_current(snapshot, size, talents));
+
+	/* damaged payload */
+	snapshot[size / 2] ^= 0xFF;
+	assert(!xml_snapshot_current(snapshot, size, breeds));
+
+	XmlCtx *loaded = xml_snapshot_load(snapshot, size);
+	assert(loaded->doc == NULL && loaded->state.state_no == XML_CTX_ERROR);
+	free_xml_ctx(&loaded);
+
+	snapshot[size / 2] ^= 0xFF;
+
+	/* other format version */
+	snapshot[4] = XML_SNAPSHOT_VERSION + 1;
+	assert(!xml_snapshot_current(snapshot, size, breeds));
+	snapshot[4] = XML_SNAPSHOT_VERSION;
+
+	/* truncated */
+	loaded = xml_snapshot_load(snapshot, size - 1);
+	assert(loaded->doc == NULL && loaded->state.state_no == XML_CTX_ERROR);
+	free_xml_ctx(&loaded);
+
+	loaded = xml_snapshot_load(snapshot, size);
+	assert(loaded->doc != NULL);
+	free_xml_ctx(&loaded);
+
+	free(snapshot);
+	free_xml_ctx(&ctx);
+	xml_source_free(&talents);
+	xml_source_free(&breeds);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_snapshot_file() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	#ifdef OS_WINDOWS
+		const char *xmlFile = "data\\xml\\basehero.xml";
+	#else
+		const char *xmlFile = "data/xml/basehero.xml";
+	#endif
+	const char *snapshotFile = "test_xml_snapshot.xsnap";
+
+	XmlSource *source = xml_source_from_file_mapped(xmlFile);
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	assert(xml_snapshot_save(ctx, snapshotFile) == 0);
+
+	XmlCtx *loaded = xml_snapshot_load_file(snapshotFile);
+
+	assert(loaded->doc != NULL);
+	assert(test_xml_snapshot_same(ctx, loaded, "count(//node())"));
+
+	free_xml_ctx(&loaded);
+
+	loaded = xml_snapshot_load_file("notfound.xsnap");
+	assert(loaded->doc == NULL && loaded->state.state_no == XML_CTX_ERROR);
+	free_xml_ctx(&loaded);
+
+	remove(snapshotFile);
+
+	free_xml_ctx(&ctx);
+	xml_source_free(&source);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_snapshot_escaped() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] =
+		"<talents><talent name=\"Hieb &amp; Stich\" note=\"&lt;&quot;a&quot;&gt; &#38;amp;\">x &amp; y</talent></talents>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	const char *snapshotFile = "test_xml_snapshot_escaped.xsnap";
+
+	assert(xml_snapshot_save(ctx, snapshotFile) == 0);
+
+	XmlCtx *loaded = xml_snapshot_load_file(snapshotFile);
+
+	assert(loaded->doc != NULL);
+
+	/* attribute values keep their text, without escaping them again */
+	const unsigned char *attrs[] = { (const unsigned char *)"name", (const unsigned char *)"note" };
+
+	for ( size_t curattr = 0; curattr < sizeof(attrs) / sizeof(attrs[0]); ++curattr ) {
+		xmlChar *expected = xml_ctx_get_attr(ctx, attrs[curattr], "/talents/talent");
+		xmlChar *value = xml_ctx_get_attr(loaded, attrs[curattr], "/talents/talent");
+
+		DEBUG_LOG_ARGS("%s: %s %s\n", attrs[curattr], expected, value);
+		assert(expected != NULL && xmlStrEqual(expected, value));
+
+		xmlFree(value);
+		xmlFree(expected);
+	}
+
+	assert(xml_ctx_exist(loaded, "/talents/talent[@name = 'Hieb & Stich' and . = 'x & y']"));
+
+	free_xml_ctx(&loaded);
+
+	remove(snapshotFile);
+
+	free_xml_ctx_src(&ctx);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int
+main()
+{
+
+	DEBUG_LOG(">> Start xml snapshot tests:\n");
+
+	test_xml_snapshot_roundtrip();
+
+	test_xml_snapshot_stale();
+
+	test_xml_snapshot_file();
+
+	test_xml_snapshot_escaped();
+
+	DEBUG_LOG("<< end xml snapshot tests:\n");
+
+	return 0;
+}
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "defs.h"
 #include "xml_source.h"
@@ -84,6 +85,181 @@ static void test_xml_source() {
 }
 
 
+static void test_xml_source_mapped() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	#ifdef OS_WINDOWS
+		const char *file = "data\\xml\\talents.xml";
+	#else
+		const char *file = "data/xml/talents.xml";
+	#endif
+
+	XmlSource* result = xml_source_from_file_mapped(file);
+
+	assert(result != NULL);
+	assert(result->type == MAPPED_FILE);
+	assert(result->data.mapped != NULL);
+	assert(result->src_data == result->data.mapped->addr);
+	assert(*result->src_size == result->data.mapped->size);
+
+	DEBUG_LOG_ARGS("mapped size %zu\n", *result->src_size);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* archived = xml_source_from_resname(ar, "talents");
+
+	assert(*result->src_size == *archived->src_size);
+	assert(memcmp(result->src_data, archived->src_data, *result->src_size) == 0);
+
+	xml_source_free(&archived);
+	xml_source_free(&result);
+	assert(result == NULL);
+
+	assert(xml_source_from_file_mapped("data/xml/notfound.xml") == NULL);
+	assert(xml_source_from_file_mapped(NULL) == NULL);
+
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_source_memory() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] = "<talents><talent name=\"Dolche\" /></talents>";
+	const size_t size = sizeof(payload) - 1;
+
+	XmlSource* result = xml_source_from_memory(payload, size, XML_SOURCE_BORROWED);
+
+	assert(result != NULL);
+	assert(result->type == MEMORY);
+	assert(result->src_data == payload);
+	assert(*result->src_size == size);
+	assert(result->data.memory->ownership == XML_SOURCE_BORROWED);
+
+	xml_source_free(&result);
+	assert(result == NULL);
+
+	unsigned char *owned = malloc(size);
+	memcpy(owned, payload, size);
+
+	result = xml_source_from_memory(owned, size, XML_SOURCE_OWNED);
+
+	assert(result != NULL);
+	assert(result->src_data == owned);
+	assert(result->data.memory->ownership == XML_SOURCE_OWNED);
+
+	/* frees owned too */
+	xml_source_free(&result);
+
+	assert(xml_source_from_memory(NULL, size, XML_SOURCE_BORROWED) == NULL);
+	assert(xml_source_from_memory(payload, 0, XML_SOURCE_BORROWED) == NULL);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_source_archive_index() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+
+	const int cnt = xml_source_archive_index(ar);
+
+	DEBUG_LOG_ARGS("indexed files: %i\n", cnt);
+
+	assert(cnt > 0);
+	assert(xml_source_archive_index(ar) == cnt);
+	assert(xml_source_archive_index(NULL) == -1);
+
+	XmlSource* first = xml_source_from_resname(ar, "talents");
+	XmlSource* second = xml_source_from_resname(ar, "talents");
+
+	assert(first != NULL && first->type == RESOURCE_FILE_INDEXED);
+	assert(strcmp(first->data.resfile->complete, "xml/talents.xml") == 0);
+
+	/* decompressed once, shared by all sources */
+	assert(first->data.resfile == second->data.resfile);
+	assert(first->src_data == second->src_data);
+
+	xml_source_free(&first);
+	assert(second->src_data == second->data.resfile->data);
+	assert(*second->src_size == second->data.resfile->file_size);
+	xml_source_free(&second);
+
+	assert(xml_source_from_resname(ar, "notfound") == NULL);
+
+	XmlSource* stylesheet = xml_source_from_resname_full(ar, "xslt/", "test_breed", "xsl");
+	assert(stylesheet != NULL && stylesheet->type == RESOURCE_FILE_INDEXED);
+	xml_source_free(&stylesheet);
+
+	xml_source_archive_index_free(ar);
+
+	/* searched again without index */
+	first = xml_source_from_resname(ar, "talents");
+	assert(first != NULL && first->type == RESOURCE_FILE);
+	xml_source_free(&first);
+
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+#define TEST_XML_SOURCE_THREADS 8
+#define TEST_XML_SOURCE_ROUNDS 50
+
+typedef struct {
+	ArchiveResource		*ar;		/* indexed archive of all threads */
+	int					cnt;		/* indexed files */
+	const ResourceFile	*talents;	/* indexed file of talents */
+	int					failures;	/* wrong lookups of thread */
+} TestXmlSourceThread;
+
+static void* test_xml_source_index_thread(void *data) {
+
+	TestXmlSourceThread *run = data;
+
+	for ( int curround = 0; curround < TEST_XML_SOURCE_ROUNDS; ++curround ) {
+
+		XmlSource *talents = xml_source_from_resname(run->ar, "talents");
+
+		if ( talents == NULL || talents->data.resfile != run->talents || xml_source_archive_index(run->ar) != run->cnt ) {
+			++run->failures;
+		}
+
+		xml_source_free(&talents);
+	}
+
+	return NULL;
+}
+
+static void test_xml_source_archive_index_threads() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+
+	const int cnt = xml_source_archive_index(ar);
+	XmlSource *talents = xml_source_from_resname(ar, "talents");
+
+	pthread_t threads[TEST_XML_SOURCE_THREADS];
+	TestXmlSourceThread runs[TEST_XML_SOURCE_THREADS];
+
+	for ( int curthread = 0; curthread < TEST_XML_SOURCE_THREADS; ++curthread ) {
+		TestXmlSourceThread run = { ar, cnt, talents->data.resfile, 0 };
+		runs[curthread] = run;
+		assert(pthread_create(&threads[curthread], NULL, test_xml_source_index_thread, &runs[curthread]) == 0);
+	}
+
+	for ( int curthread = 0; curthread < TEST_XML_SOURCE_THREADS; ++curthread ) {
+		pthread_join(threads[curthread], NULL);
+		assert(runs[curthread].failures == 0);
+	}
+
+	xml_source_free(&talents);
+	xml_source_archive_index_free(ar);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
 int 
 main() 
 {
@@ -91,6 +267,14 @@ main()
 	DEBUG_LOG(">> Start xml source tests:\n");
 	
 	test_xml_source();
+
+	test_xml_source_mapped();
+
+	test_xml_source_memory();
+
+	test_xml_source_archive_index();
+
+	test_xml_source_archive_index_threads();
 	
 	DEBUG_LOG("<< end xml source tests:\n");
 	return 0;
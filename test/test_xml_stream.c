@@ -0,0 +1,252 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_path.h"
+#include "xml_stream.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+typedef struct {
+	int cnt;
+	int stop_at;
+	xmlChar *first_name;
+} StreamResult;
+
+static bool __collect_stream(xmlNodePtr node, void *data) {
+	StreamResult *result = data;
+
+	if ( result->cnt == 0 ) {
+		result->first_name = xmlGetProp(node, (const xmlChar*)"name");
+	}
+
+	++result->cnt;
+
+	return result->stop_at == 0 || result->cnt < result->stop_at;
+}
+
+static void test_xml_path_parse() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	XmlPath *path = xml_path_new("/talents/group//talent[@type = 'base'][@inc=\"D\" and @name]");
+
+	assert(path != NULL && path->step_cnt == 3);
+	assert(!path->steps[0].descendant && xmlStrEqual(path->steps[0].name, (const xmlChar*)"talents"));
+	assert(!path->steps[1].descendant && path->steps[1].pred_cnt == 0);
+	assert(path->steps[2].descendant && path->steps[2].pred_cnt == 3);
+	assert(xmlStrEqual(path->steps[2].preds[1].value, (const xmlChar*)"D"));
+	assert(path->steps[2].preds[2].value == NULL);
+
+	xml_path_free(&path);
+	assert(path == NULL);
+
+	path = xml_path_new("//*");
+	assert(path != NULL && path->step_cnt == 1 && path->steps[0].name == NULL);
+	xml_path_free(&path);
+
+	assert(xml_path_new(NULL) == NULL);
+	assert(xml_path_new("talents/talent") == NULL);
+	assert(xml_path_new("/talents/talent[1]") == NULL);
+	assert(xml_path_new("/talents/talent[@name = 'x'") == NULL);
+	assert(xml_path_new("/talents/talent/@name") == NULL);
+	assert(xml_path_new("/talents/talent | /talents/group") == NULL);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_stream_source() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "talents");
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	const char *paths[] = {
+		"//talent",
+		"/talents/group/talent",
+		"/talents//talent[@type = 'base']",
+		"//group[@name = 'Kampf']/talent[@inc = 'D']",
+		"//*[@usage]",
+		"/talents/talent",
+		"//group"
+	};
+
+	for (size_t curpath = 0; curpath < sizeof(paths) / sizeof(paths[0]); ++curpath) {
+
+		StreamResult result = { 0, 0, NULL };
+		double cntExpected = -1;
+
+		int cnt = xml_stream_source(source, paths[curpath], __collect_stream, &result);
+
+		char countExpr[128];
+		snprintf(countExpr, sizeof(countExpr), "count(%s)", paths[curpath]);
+		assert(xml_ctx_xpath_tod(nCtx, &cntExpected, countExpr) == 0);
+
+		DEBUG_LOG_ARGS("path: %s stream: %i dom: %f\n", paths[curpath], cnt, cntExpected);
+
+		assert(cnt == result.cnt);
+		assert(cnt == (int)cntExpected);
+
+		xmlFree(result.first_name);
+	}
+
+	StreamResult result = { 0, 2, NULL };
+	assert(xml_stream_source(source, "//talent[@type = 'base']", __collect_stream, &result) == 2);
+	assert(xmlStrEqual(result.first_name, (const xmlChar*)"Dolche"));
+	xmlFree(result.first_name);
+
+	assert(xml_stream_source(source, "talent", __collect_stream, &result) == -1);
+	assert(xml_stream_source(NULL, "//talent", __collect_stream, &result) == -1);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_stream_namespace() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] =
+		"<a xmlns='urn:x'><b/><b/><c xmlns='' xmlns:p='urn:p' p:n='1'><b n='2'/><p:b/></c></a>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	const char *paths[] = { "/a/b", "//b", "/a/*", "/*/*/b", "//*[@n]", "//*[@xmlns]", "//c/*" };
+
+	for (size_t curpath = 0; curpath < sizeof(paths) / sizeof(paths[0]); ++curpath) {
+
+		StreamResult result = { 0, 0, NULL };
+		double cntExpected = -1;
+
+		int cnt = xml_stream_source(source, paths[curpath], __collect_stream, &result);
+
+		char countExpr[128];
+		snprintf(countExpr, sizeof(countExpr), "count(%s)", paths[curpath]);
+		assert(xml_ctx_xpath_tod(nCtx, &cntExpected, countExpr) == 0);
+
+		DEBUG_LOG_ARGS("path: %s stream: %i dom: %f\n", paths[curpath], cnt, cntExpected);
+
+		assert(cnt == (int)cntExpected);
+
+		xmlFree(result.first_name);
+	}
+
+	free_xml_ctx_src(&nCtx);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_stream_error() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char broken[] = "<talents>\n<talent name='Dolche'/>\n<talent>\n</talents>";
+	static const unsigned char valid[] = "<talents><talent name='Dolche'/></talents>";
+
+	XmlSource *source = xml_source_from_memory(broken, sizeof(broken) - 1, XML_SOURCE_BORROWED);
+	StreamResult result = { 0, 0, NULL };
+	xmlError error;
+
+	/* the error is captured instead of printed */
+	assert(xml_stream_source_error(source, "//talent", __collect_stream, &result, &error) == -1);
+	assert(error.code != XML_ERR_OK && error.level >= XML_ERR_ERROR && error.line == 4);
+
+	DEBUG_LOG_ARGS("error line %i: %s", error.line, error.message);
+
+	xmlFree(result.first_name);
+	xmlResetError(&error);
+	xml_source_free(&source);
+
+	source = xml_source_from_memory(valid, sizeof(valid) - 1, XML_SOURCE_BORROWED);
+
+	assert(xml_stream_source_error(source, "//talent", NULL, NULL, &error) == -1);
+	result = (StreamResult){ 0, 0, NULL };
+	assert(xml_stream_source_error(source, "//talent", __collect_stream, &result, &error) == 1);
+	assert(error.code == XML_ERR_OK);
+	xmlFree(result.first_name);
+
+	xml_source_free(&source);
+
+	assert(xml_stream_file_error("notfound.xml", "//talent", __collect_stream, NULL, &error) == -1);
+	xmlResetError(&error);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_path_node() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "talents");
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	XmlPath *path = xml_path_new("/talents/group[@name = 'Kampf']");
+
+	xmlNodePtr root = xmlDocGetRootElement(nCtx->doc);
+	XmlPathState rootState = xml_path_step_node(path, xml_path_start(path), root);
+
+	assert(!xml_path_matched(path, rootState) && !xml_path_dead(path, rootState));
+
+	int cntMatched = 0;
+
+	for (xmlNodePtr child = root->children; child != NULL; child = child->next) {
+
+		if ( child->type != XML_ELEMENT_NODE ) continue;
+
+		XmlPathState state = xml_path_step_node(path, rootState, child);
+
+		if ( xml_path_matched(path, state) ) ++cntMatched;
+
+		assert(xml_path_dead(path, state));
+	}
+
+	assert(cntMatched == 1);
+
+	xml_path_free(&path);
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int 
+main() 
+{
+
+	DEBUG_LOG(">> Start xml stream tests:\n");
+
+	test_xml_path_parse();
+
+	test_xml_path_node();
+
+	test_xml_stream_source();
+
+	test_xml_stream_namespace();
+
+	test_xml_stream_error();
+	
+	DEBUG_LOG("<< end xml stream tests:\n");
+
+	return 0;
+}
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "defs.h"
 #include "xml_source.h"
@@ -261,6 +262,128 @@ static void test_xml_ctx_xpath() {
 	DEBUG_LOG("<<<\n");
 }
 
+/* restricted paths of xml_ctx_exist are not compiled */
+static bool test_xml_ctx_xpath_exist(XmlCtx *ctx, const char *xpath) {
+	xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
+	bool exist = xml_xpath_has_result(found);
+	xmlXPathFreeObject(found);
+	return exist;
+}
+
+static void test_xml_ctx_xpath_cache() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "breeds");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	XPathCompCacheStats stats;
+	xml_ctx_xpath_cache_stats(nCtx, &stats);
+
+	assert(stats.hits == 0 && stats.misses == 0 && stats.size == 0);
+	assert(stats.capacity == XML_CTX_XPATH_CACHE_SIZE);
+
+	for (int i = 0; i < 3; ++i) {
+		assert(test_xml_ctx_xpath_exist(nCtx, "/breeds/group/breed[@name='Die Tulamiden']"));
+	}
+
+	xml_ctx_xpath_cache_stats(nCtx, &stats);
+
+	assert(stats.misses == 1 && stats.hits == 2 && stats.size == 1);
+
+	xml_ctx_xpath_cache_resize(nCtx, 1);
+
+	assert(test_xml_ctx_xpath_exist(nCtx, "/breeds/group"));
+	assert(!test_xml_ctx_xpath_exist(nCtx, "/breeds/nogroup"));
+	assert(test_xml_ctx_xpath_exist(nCtx, "/breeds/group"));
+
+	xml_ctx_xpath_cache_stats(nCtx, &stats);
+
+	assert(stats.misses == 4 && stats.hits == 2 && stats.size == 1 && stats.evictions == 3);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void __twice_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
+	if ( nargs != 1 ) return;
+
+	double value = xmlXPathPopNumber(ctxt);
+
+	xmlXPathReturnNumber(ctxt, value * 2.);
+}
+
+static void __half_xpath_func(xmlXPathParserContextPtr ctxt, int nargs) {
+	if ( nargs != 1 ) return;
+
+	double value = xmlXPathPopNumber(ctxt);
+
+	xmlXPathReturnNumber(ctxt, value / 2.);
+}
+
+static void test_xml_ctx_xpath_register_func() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "basehero");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	assert(xml_ctx_xpath_register_func(nCtx, "twice", __twice_xpath_func) == 0);
+
+	double dResult = 0;
+	int errNo = xml_ctx_xpath_tod(nCtx, &dResult, "twice(//hero/@age)");
+
+	assert(errNo == 0);
+	assert(dResult == 40.0);
+
+	assert(xml_ctx_exist(nCtx, "//hero[twice(@age) = 40]"));
+
+	assert(xml_ctx_xpath_register_func(nCtx, "twice", __half_xpath_func) == 0);
+
+	errNo = xml_ctx_xpath_tod(nCtx, &dResult, "twice(//hero/@age)");
+
+	assert(errNo == 0);
+	assert(dResult == 10.0);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_ctx_xpath_regexmatch_cache() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "talents");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	const char *xpath = "count(//*[regexmatch(@name,'^Sch')])";
+
+	xmlXPathContextPtr rawCtx = xmlXPathNewContext(nCtx->doc);
+	xmlXPathRegisterFunc(rawCtx, (const xmlChar *)"regexmatch", regexmatch_xpath_func);
+	xmlXPathObjectPtr uncached = xmlXPathEvalExpression((const xmlChar *)xpath, rawCtx);
+
+	double cached = 0.;
+
+	for (int i = 0; i < 2; ++i) {
+		assert(xml_ctx_xpath_tod(nCtx, &cached, xpath) == 0);
+		assert(cached > 0. && cached == uncached->floatval);
+	}
+
+	assert(xmlHashSize(((XPathFuncCache *)nCtx->xpath_ctx->userData)->regex) == 1);
+
+	xmlXPathFreeObject(uncached);
+	xmlXPathFreeContext(rawCtx);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
 static void test_xml_ctx_xpath_format() {
 	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
 
@@ -289,6 +412,82 @@ static void test_xml_ctx_xpath_format() {
 	DEBUG_LOG("<<<\n");
 }
 
+static void test_xml_ctx_query() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "breeds");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	XPathQuery *query = xpath_query_new("/breeds/group/breed[@name = $name]");
+
+	assert(query != NULL);
+
+	xpath_query_bind_str(query, "name", "Die Tulamiden");
+	assert(xml_ctx_query_exist(nCtx, query));
+
+	xmlXPathObjectPtr found = xml_ctx_query(nCtx, query);
+	assert(xml_xpath_has_result(found) && found->nodesetval->nodeNr == 1);
+
+	xpath_query_bind_str(query, "name", "Die Unbekannten");
+	assert(!xml_ctx_query_exist(nCtx, query));
+
+	xpath_query_bind_nodes(query, "name", found->nodesetval);
+	assert(!xml_ctx_query_exist(nCtx, query));
+
+	xpath_query_bind_node(query, "name", xmlHasProp(found->nodesetval->nodeTab[0], (const xmlChar *)"name")->children);
+	xmlChar *image = xml_ctx_query_get_attr(nCtx, (const unsigned char *)"image", query);
+	assert(image != NULL);
+	xmlFree(image);
+
+	xmlXPathFreeObject(found);
+
+	xpath_query_clear(query);
+	assert(query->var_cnt == 0);
+
+	xpath_query_free(&query);
+	assert(query == NULL);
+
+	query = xpath_query_new("count(/breeds/group/breed[gp/@value >= $min])");
+
+	double all = 0., some = 0.;
+	xpath_query_bind_num(query, "min", -1000.);
+	assert(xml_ctx_query_tod(nCtx, &all, query) == 0);
+	xpath_query_bind_num(query, "min", 1.);
+	assert(xml_ctx_query_tod(nCtx, &some, query) == 0);
+
+	assert(all > 0. && some < all);
+
+	xpath_query_free(&query);
+
+	/* a query follows the functions of the context it is executed on */
+	XmlCtx *twiceCtx = xml_ctx_new(xml_source_from_resname(ar, "basehero"));
+	XmlCtx *halfCtx = xml_ctx_new(xml_source_from_resname(ar, "basehero"));
+	double value = 0.;
+
+	assert(xml_ctx_xpath_register_func(twiceCtx, "scale", __twice_xpath_func) == 0);
+	assert(xml_ctx_xpath_register_func(halfCtx, "scale", __half_xpath_func) == 0);
+
+	query = xpath_query_new("scale(//hero/@age)");
+
+	assert(xml_ctx_query_tod(twiceCtx, &value, query) == 0 && value == 40.);
+	assert(xml_ctx_query_tod(halfCtx, &value, query) == 0 && value == 10.);
+	assert(xml_ctx_query_tod(twiceCtx, &value, query) == 0 && value == 40.);
+
+	assert(xml_ctx_xpath_register_func(twiceCtx, "scale", __half_xpath_func) == 0);
+	assert(xml_ctx_query_tod(twiceCtx, &value, query) == 0 && value == 10.);
+
+	xpath_query_free(&query);
+
+	free_xml_ctx_src(&twiceCtx);
+	free_xml_ctx_src(&halfCtx);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
 static void test_xml_ctx_add_node_xpath() {
 	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
 
@@ -383,9 +582,61 @@ static void test_xml_ctx_xpath_in_range()
 
 	__search_and_dum_range_assert(nCtx, "/breeds/*//color[in_range(@value,'22')]", false);
 
+	xmlXPathContextPtr rawCtx = xmlXPathNewContext(nCtx->doc);
+	xmlXPathRegisterFunc(rawCtx, (const xmlChar *)"in_range", str_in_range_xpath_func);
+
+	const char *values[] = { "0", "1", " 3 ", "7", "12", "19", "20", "21", "-1", "W20", "abc" };
+
+	for (size_t curval = 0; curval < sizeof(values)/sizeof(values[0]); ++curval) {
+		char xpath[128];
+		snprintf(xpath, sizeof(xpath), "count(/breeds/*//color[in_range(@value,'%s')])", values[curval]);
+
+		double cached = -1.;
+		xmlXPathObjectPtr uncached = xmlXPathEvalExpression((const xmlChar *)xpath, rawCtx);
+
+		assert(xml_ctx_xpath_tod(nCtx, &cached, xpath) == 0);
+		assert(cached == uncached->floatval);
+
+		xmlXPathFreeObject(uncached);
+	}
+
+	xmlXPathFreeContext(rawCtx);
+
 	free_xml_ctx_src(&nCtx);
 	archive_resource_free(&ar);
 
+	/* ranges and values outside of plain integers keep the result of regex_range_match */
+	static const unsigned char payload[] =
+		"<colors>"
+			"<color value=\"2\"/><color value=\"1-3\"/><color value=\"02\"/><color value=\" 2 \"/>"
+			"<color value=\"1 - 3\"/><color value=\"2-02\"/><color value=\"3-1\"/>"
+		"</colors>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *mCtx = xml_ctx_new(source);
+
+	const char *ranges[] = { "2", "1-3", "02", " 2 ", "1 - 3", "2-02", "3-1" };
+	const char *plain[] = { "2", "02", " 2 ", "+2", "3" };
+
+	for (size_t curval = 0; curval < sizeof(plain)/sizeof(plain[0]); ++curval) {
+		char xpath[128];
+		snprintf(xpath, sizeof(xpath), "count(//color[in_range(@value,'%s')])", plain[curval]);
+
+		double expected = 0.;
+		for (size_t currange = 0; currange < sizeof(ranges)/sizeof(ranges[0]); ++currange) {
+			if (regex_range_match((const unsigned char *)ranges[currange], (const unsigned char *)plain[curval])) {
+				++expected;
+			}
+		}
+
+		double found = -1.;
+		assert(xml_ctx_xpath_tod(mCtx, &found, xpath) == 0);
+		DEBUG_LOG_ARGS("value '%s' => %f of %f\n", plain[curval], found, expected);
+		assert(found == expected);
+	}
+
+	free_xml_ctx_src(&mCtx);
+
 	DEBUG_LOG("<<<\n");
 }
 
@@ -553,6 +804,11 @@ static void test_xml_ctx_xpath_to_float()
 	assert(errNo == 0);
 	assert(fResult == 64.f);
 
+	errNo = xml_ctx_xpath_tof(nCtx, &fResult, "//hero/@age div 8");
+
+	assert(errNo == 0);
+	assert(fResult == 2.5f);
+
 	errNo = xml_ctx_xpath_tof(nCtx, &fResult, "//hero/attributes/attribute");
 	assert(errNo == 1);
 
@@ -562,6 +818,506 @@ static void test_xml_ctx_xpath_to_float()
 	DEBUG_LOG("<<<\n");
 }
 
+static void test_xml_ctx_xpath_aggregates()
+{
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* result = xml_source_from_resname(ar, "basehero");
+	XmlCtx *nCtx = xml_ctx_new(result);
+
+	double dResult = 0;
+
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "max(/hero/attributes/attribute/@value)") == 0);
+	assert(dResult == 8.0);
+
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "min(/hero/attributes/attribute/@value)") == 0);
+	assert(dResult == 0.0);
+
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "total(/hero/attributes/attribute/@value)") == 0);
+	assert(dResult == 64.0);
+
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "avg(/hero/attributes/attribute/@value)") == 0);
+	assert(dResult == 64.0 / 9.0);
+
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "total(/hero/notfound/@value)") == 0);
+	assert(dResult == 0.0);
+
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "max(/hero/notfound/@value)") == 1);
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "avg(/hero/notfound/@value)") == 1);
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "min(/hero/attributes/attribute/@name)") == 1);
+
+	free_xml_ctx_src(&nCtx);
+
+	nCtx = xml_ctx_new_empty_root_name("values");
+	xmlNodePtr root = xmlDocGetRootElement(nCtx->doc);
+	xmlNewChild(root, NULL, (const xmlChar *)"value", (const xmlChar *)"-7");
+	xmlNewChild(root, NULL, (const xmlChar *)"value", (const xmlChar *)" -2.5 ");
+	xmlNewChild(root, NULL, (const xmlChar *)"value", (const xmlChar *)"-11");
+
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "max(/values/value)") == 0);
+	assert(dResult == -2.5);
+
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "min(/values/value/text())") == 0);
+	assert(dResult == -11.0);
+
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "total(/values/value)") == 0);
+	assert(dResult == -20.5);
+
+	/* same result like the xpath 1.0 function */
+	assert(xml_ctx_xpath_tod(nCtx, &dResult, "sum(/values/value)") == 0);
+	assert(dResult == -20.5);
+
+	free_xml_ctx_src(&nCtx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_ctx_mapped() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	#ifdef OS_WINDOWS
+		XmlSource *source = xml_source_from_file_mapped("data\\xml\\basehero.xml");
+	#else
+		XmlSource *source = xml_source_from_file_mapped("data/xml/basehero.xml");
+	#endif
+
+	assert(source != NULL);
+
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	assert(nCtx->src == source);
+	assert(nCtx->doc != NULL);
+	assert(nCtx->state.state_no == XML_CTX_SUCCESS);
+	assert(xml_ctx_exist(nCtx, "/hero"));
+
+	free_xml_ctx_src(&nCtx);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_ctx_memory() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] = "<talents><talent name=\"Dolche\" value=\"3\" /></talents>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	assert(nCtx->doc != NULL);
+	assert(nCtx->state.state_no == XML_CTX_SUCCESS);
+
+	double value = 0;
+	assert(xml_ctx_xpath_tod(nCtx, &value, "/talents/talent[@name = 'Dolche']/@value") == 0 && value == 3.);
+
+	free_xml_ctx_src(&nCtx);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_ctx_new_opts() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "breeds");
+
+	XmlCtx *fullCtx = xml_ctx_new(source);
+	XmlCtx *compactCtx = xml_ctx_new_opts(source, XML_CTX_OPT_COMPACT_READONLY);
+	XmlCtx *nodictCtx = xml_ctx_new_opts(source, XML_CTX_OPT_NODICT | XML_CTX_OPT_HUGE);
+
+	assert(compactCtx->doc != NULL && compactCtx->state.state_no == XML_CTX_SUCCESS);
+	assert(nodictCtx->doc != NULL && nodictCtx->doc->dict == NULL);
+
+	double cntFull = 0, cntCompact = 0, cntElemFull = 0, cntElemCompact = 0;
+	xml_ctx_xpath_tod(fullCtx, &cntFull, "count(//node())");
+	xml_ctx_xpath_tod(compactCtx, &cntCompact, "count(//node())");
+	xml_ctx_xpath_tod(fullCtx, &cntElemFull, "count(//*)");
+	xml_ctx_xpath_tod(compactCtx, &cntElemCompact, "count(//*)");
+
+	DEBUG_LOG_ARGS("nodes full: %.0f compact: %.0f elements: %.0f\n", cntFull, cntCompact, cntElemFull);
+
+	assert(cntElemFull == cntElemCompact);
+	assert(cntCompact < cntFull * 0.75);
+
+	/* same answers */
+	double valueFull = 0, valueCompact = 0;
+	xml_ctx_xpath_tod(fullCtx, &valueFull, "count(//*[@name])");
+	xml_ctx_xpath_tod(compactCtx, &valueCompact, "count(//*[@name])");
+	assert(valueFull == valueCompact);
+
+	free_xml_ctx(&fullCtx);
+	free_xml_ctx(&compactCtx);
+	free_xml_ctx(&nodictCtx);
+
+	#ifdef OS_WINDOWS
+		XmlCtx *fileCtx = xml_ctx_new_file_opts("data\\xml\\basehero.xml", XML_CTX_OPT_NOBLANKS);
+	#else
+		XmlCtx *fileCtx = xml_ctx_new_file_opts("data/xml/basehero.xml", XML_CTX_OPT_NOBLANKS);
+	#endif
+
+	assert(fileCtx->doc != NULL);
+	assert(!xml_ctx_exist(fileCtx, "/hero/text()"));
+
+	free_xml_ctx(&fileCtx);
+
+	xml_source_free(&source);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_ctx_shared_dict() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+
+	XmlCtx *talentsCtx = xml_ctx_new_archive(ar, "talents", XML_CTX_OPT_INTERN_VALUES);
+	XmlCtx *talents2Ctx = xml_ctx_new_archive(ar, "talents", XML_CTX_OPT_NONE);
+	XmlCtx *breedsCtx = xml_ctx_new_archive(ar, "breeds", XML_CTX_OPT_COMPACT_READONLY);
+
+	assert(talentsCtx->doc != NULL && talents2Ctx->doc != NULL && breedsCtx->doc != NULL);
+	assert(talentsCtx->doc->dict == xml_ctx_archive_dict(ar));
+	assert(talentsCtx->doc->dict == talents2Ctx->doc->dict);
+	assert(talentsCtx->doc->dict == breedsCtx->doc->dict);
+
+	/* names are pointer equal, also between different documents */
+	xmlNodePtr talentsRoot = xmlDocGetRootElement(talentsCtx->doc);
+	xmlNodePtr breedsRoot = xmlDocGetRootElement(breedsCtx->doc);
+	assert(talentsRoot->name == xmlDocGetRootElement(talents2Ctx->doc)->name);
+	assert(xmlDictOwns(breedsCtx->doc->dict, breedsRoot->name) == 1);
+	assert(xmlHasProp(xml_ctx_first(talentsCtx, "//talent"), (const xmlChar*)"name")->name ==
+		   xmlHasProp(xml_ctx_first(breedsCtx, "//breed"), (const xmlChar*)"name")->name);
+
+	xmlXPathObjectPtr first = xml_ctx_xpath(talentsCtx, "//talent[@name = 'Dolche']");
+	xmlXPathObjectPtr second = xml_ctx_xpath(talentsCtx, "//talent[@name = 'Hiebwaffen']");
+	assert(xml_xpath_has_result(first) && xml_xpath_has_result(second));
+
+	xmlNodePtr firstNode = first->nodesetval->nodeTab[0];
+	xmlNodePtr secondNode = second->nodesetval->nodeTab[0];
+	xmlAttrPtr firstType = xmlHasProp(firstNode, (const xmlChar*)"type");
+	xmlAttrPtr secondType = xmlHasProp(secondNode, (const xmlChar*)"type");
+
+	/* interned values */
+	assert(firstType->children->content == secondType->children->content);
+	assert(xmlDictOwns(talentsCtx->doc->dict, firstType->children->content) == 1);
+
+	xmlXPathFreeObject(first);
+	xmlXPathFreeObject(second);
+
+	/* interned values could be changed */
+	xml_ctx_set_attr_str_xpath(talentsCtx, (const unsigned char*)"special", "//talent[@name = 'Dolche']/@type");
+	assert(xml_ctx_exist(talentsCtx, "//talent[@name = 'Dolche'][@type = 'special']"));
+	assert(xml_ctx_exist(talentsCtx, "//talent[@name = 'Hiebwaffen'][@type = 'base']"));
+
+	xml_ctx_remove(talentsCtx, "//talent[@type = 'base']");
+
+	/* documents keep the dictionary */
+	xml_ctx_archive_dict_free(ar);
+
+	/* copies between archive contexts keep the interned names */
+	xml_ctx_nodes_add_xpath(talents2Ctx, "//talent[@inc = 'D']", breedsCtx, "/breeds");
+	assert(xml_ctx_exist(breedsCtx, "/breeds/talent[@name = 'Dolche']"));
+	assert(xml_ctx_first(breedsCtx, "/breeds/talent")->name == xml_ctx_first(talents2Ctx, "//talent")->name);
+	assert(xmlDictOwns(breedsCtx->doc->dict, xml_ctx_first(breedsCtx, "/breeds/talent")->name) == 1);
+
+	free_xml_ctx_src(&talentsCtx);
+	free_xml_ctx_src(&talents2Ctx);
+	free_xml_ctx_src(&breedsCtx);
+
+	assert(xml_ctx_archive_dict(NULL) == NULL);
+
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_ctx_parse_error() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char broken[] = "<talents>\n<talent name=\"Dolche\">\n</talents>";
+	static const unsigned char valid[] = "<talents><talent name=\"Dolche\" /></talents>";
+
+	XmlSource *source = xml_source_from_memory(broken, sizeof(broken) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *nCtx = xml_ctx_new(source);
+
+	assert(nCtx->doc == NULL && nCtx->state.state_no == XML_CTX_ERROR);
+
+	const xmlError *error = xml_ctx_error(nCtx);
+	assert(error != NULL && error->level == XML_ERR_FATAL && error->line == 3);
+
+	DEBUG_LOG_ARGS("line %i: %s", error->line, error->message);
+
+	free_xml_ctx_src(&nCtx);
+
+	/* former errors do not fail following parses */
+	source = xml_source_from_memory(valid, sizeof(valid) - 1, XML_SOURCE_BORROWED);
+	nCtx = xml_ctx_new(source);
+
+	assert(nCtx->doc != NULL && nCtx->state.state_no == XML_CTX_SUCCESS);
+	assert(xml_ctx_error(nCtx) == NULL);
+
+	free_xml_ctx_src(&nCtx);
+
+	/* well formed documents with errors are kept, with the first error */
+	static const unsigned char namespaced[] = "<talents>\n<x:talent name=\"Dolche\" />\n<y:talent name=\"Raufen\" /></talents>";
+
+	source = xml_source_from_memory(namespaced, sizeof(namespaced) - 1, XML_SOURCE_BORROWED);
+	nCtx = xml_ctx_new(source);
+
+	assert(nCtx->doc != NULL && nCtx->state.state_no == XML_CTX_SUCCESS);
+
+	error = xml_ctx_error(nCtx);
+	assert(error != NULL && error->level == XML_ERR_ERROR && error->line == 2);
+
+	free_xml_ctx_src(&nCtx);
+
+	/* the first error is kept, not the last one */
+	static const unsigned char twice[] = "<talents>\n<x:talent name=\"Dolche\" />\n<talent></talents>";
+
+	source = xml_source_from_memory(twice, sizeof(twice) - 1, XML_SOURCE_BORROWED);
+	nCtx = xml_ctx_new(source);
+
+	assert(nCtx->doc == NULL && nCtx->state.state_no == XML_CTX_ERROR);
+
+	error = xml_ctx_error(nCtx);
+	assert(error != NULL && error->level == XML_ERR_ERROR && error->line == 2);
+
+	free_xml_ctx_src(&nCtx);
+
+	#ifdef OS_WINDOWS
+		nCtx = xml_ctx_new_file("data\\xml\\basehero.xml");
+	#else
+		nCtx = xml_ctx_new_file("data/xml/basehero.xml");
+	#endif
+
+	assert(nCtx->doc != NULL && nCtx->state.state_no == XML_CTX_SUCCESS);
+	assert(xml_ctx_error(nCtx) == NULL);
+
+	free_xml_ctx(&nCtx);
+
+	assert(xml_ctx_error(NULL) == NULL);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static xmlNodePtr test_xml_ctx_first_expected(XmlCtx *ctx, const char *xpath) {
+	xmlXPathObjectPtr found = xml_ctx_xpath(ctx, xpath);
+	xmlNodePtr first = ( xml_xpath_has_result(found) ? found->nodesetval->nodeTab[0] : NULL );
+	xmlXPathFreeObject(found);
+	return first;
+}
+
+static void test_xml_ctx_first() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "talents");
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	const char * const xpaths[] = {
+		"//talent",
+		"//talent[@inc = 'B']",
+		"/talents/group[@name = 'Wissen']/talent",
+		"//group//talent[@test]/@test",
+		"//talent[@inc = 'B']/@name",
+		"//talent/@notfound",
+		"//notfound",
+		"/talents/group[3]/talent",
+		"(//talent)[last()]",
+		"//talent[@inc = 'B']/..",
+		"//talent/@*"
+	};
+
+	for ( size_t curxpath = 0; curxpath < sizeof(xpaths) / sizeof(xpaths[0]); ++curxpath ) {
+
+		xmlNodePtr expected = test_xml_ctx_first_expected(ctx, xpaths[curxpath]);
+
+		DEBUG_LOG_ARGS("%s: %s\n", xpaths[curxpath], ( expected != NULL ? (const char *)expected->name : "none" ));
+
+		assert(xml_ctx_first(ctx, xpaths[curxpath]) == expected);
+		assert(xml_ctx_exist(ctx, xpaths[curxpath]) == ( expected != NULL ));
+	}
+
+	xmlChar *inc = xml_ctx_get_attr(ctx, (const unsigned char *)"inc", "//talent[@name = 'Raufen']");
+	assert(xmlStrEqual(inc, (const xmlChar *)"C"));
+	xmlFree(inc);
+
+	inc = xml_ctx_get_attr_format(ctx, (const unsigned char *)"inc", "//talent[@name = '%s']", "Dolche");
+	assert(xmlStrEqual(inc, (const xmlChar *)"D"));
+	xmlFree(inc);
+
+	assert(xml_ctx_get_attr(ctx, (const unsigned char *)"inc", "//talent/@name") == NULL);
+	assert(xml_ctx_exist_format(ctx, "//group[@name = '%s']", "Natur"));
+	assert(!xml_ctx_exist_format(ctx, "//group[@name = '%s']", "notfound"));
+	assert(xml_ctx_first(ctx, "count(//talent)") == NULL);
+	assert(xml_ctx_first(ctx, NULL) == NULL);
+
+	free_xml_ctx_src(&ctx);
+
+	/* names do not match elements of a namespace */
+	static const unsigned char payload[] = "<talents xmlns=\"urn:talents\"><talent name=\"Dolche\" /></talents>";
+
+	source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	ctx = xml_ctx_new(source);
+
+	assert(!xml_ctx_exist(ctx, "//talent"));
+	assert(xml_ctx_first(ctx, "/*/*/@name") == test_xml_ctx_first_expected(ctx, "/*/*/@name"));
+
+	free_xml_ctx_src(&ctx);
+
+	/* names do not match attributes of a namespace */
+	static const unsigned char nsAttrs[] = "<r xmlns:x=\"urn:x\"><e x:a=\"1\"/><e x:a=\"2\" a=\"3\"/></r>";
+	const char * const nsXpaths[] = { "/r/e[@a]", "/r/e/@a", "//e[@a = '1']", "//e[@a = '3']", "/r/e[@a]/@a" };
+
+	source = xml_source_from_memory(nsAttrs, sizeof(nsAttrs) - 1, XML_SOURCE_BORROWED);
+	ctx = xml_ctx_new(source);
+
+	for ( size_t curxpath = 0; curxpath < sizeof(nsXpaths) / sizeof(nsXpaths[0]); ++curxpath ) {
+
+		xmlNodePtr expected = test_xml_ctx_first_expected(ctx, nsXpaths[curxpath]);
+
+		assert(xml_ctx_first(ctx, nsXpaths[curxpath]) == expected);
+		assert(xml_ctx_exist(ctx, nsXpaths[curxpath]) == ( expected != NULL ));
+	}
+
+	assert(!xml_ctx_exist(ctx, "//e[@a = '1']"));
+	assert(xml_ctx_first(ctx, "/r/e/@a")->ns == NULL);
+
+	free_xml_ctx_src(&ctx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+#define TEST_XML_CTX_THREADS 8
+#define TEST_XML_CTX_ROUNDS 25
+
+typedef struct {
+	const XmlSource	*valid;		/* shared by all threads */
+	const XmlSource	*broken;	/* shared by all threads */
+	double			expected;	/* elements of valid */
+	int				failures;	/* wrong results of thread */
+} TestXmlCtxThread;
+
+static void* test_xml_ctx_thread(void *arg) {
+
+	TestXmlCtxThread *run = arg;
+
+	for ( int round = 0; round < TEST_XML_CTX_ROUNDS; ++round ) {
+
+		/* errors of other threads and of the round before must not change the result */
+		XmlCtx *brokenCtx = xml_ctx_new(run->broken);
+		XmlCtx *validCtx = xml_ctx_new_opts(run->valid, ( round % 2 == 0 ? XML_CTX_OPT_NONE : XML_CTX_OPT_COMPACT_READONLY ));
+
+		double cnt = -1.;
+		xml_ctx_xpath_tod(validCtx, &cnt, "count(//*)");
+
+		if ( brokenCtx->state.state_no != XML_CTX_ERROR || xml_ctx_error(brokenCtx) == NULL ||
+			 validCtx->state.state_no != XML_CTX_SUCCESS || xml_ctx_error(validCtx) != NULL || cnt != run->expected ||
+			 !xml_ctx_exist(validCtx, "/breeds/group/breed[@name = 'Die Tulamiden']") ) {
+			++run->failures;
+		}
+
+		free_xml_ctx(&brokenCtx);
+		free_xml_ctx(&validCtx);
+	}
+
+	return NULL;
+}
+
+static void test_xml_ctx_threads() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char broken[] = "<breeds><group></breeds>";
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource *valid = xml_source_from_resname(ar, "breeds");
+	XmlSource *brokenSrc = xml_source_from_memory(broken, sizeof(broken) - 1, XML_SOURCE_BORROWED);
+
+	XmlCtx *expectedCtx = xml_ctx_new(valid);
+	double expected = 0.;
+	xml_ctx_xpath_tod(expectedCtx, &expected, "count(//*)");
+	free_xml_ctx(&expectedCtx);
+
+	pthread_t threads[TEST_XML_CTX_THREADS];
+	TestXmlCtxThread runs[TEST_XML_CTX_THREADS];
+
+	for ( int curthread = 0; curthread < TEST_XML_CTX_THREADS; ++curthread ) {
+		TestXmlCtxThread run = { valid, brokenSrc, expected, 0 };
+		runs[curthread] = run;
+		assert(pthread_create(&threads[curthread], NULL, test_xml_ctx_thread, &runs[curthread]) == 0);
+	}
+
+	for ( int curthread = 0; curthread < TEST_XML_CTX_THREADS; ++curthread ) {
+		pthread_join(threads[curthread], NULL);
+		DEBUG_LOG_ARGS("thread %i: %i failures\n", curthread, runs[curthread].failures);
+		assert(runs[curthread].failures == 0);
+	}
+
+	xml_source_free(&brokenSrc);
+	xml_source_free(&valid);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+typedef struct {
+	const ArchiveResource	*shared;	/* archive of all threads */
+	xmlDictPtr				dict;		/* dictionary of shared */
+	int						failures;	/* wrong dictionaries of thread */
+} TestXmlDictThread;
+
+static void* test_xml_ctx_archive_dict_thread(void *data) {
+
+	TestXmlDictThread *run = data;
+
+	/* own archives, identified by address only */
+	char own[TEST_XML_CTX_ROUNDS];
+
+	for ( int curround = 0; curround < TEST_XML_CTX_ROUNDS; ++curround ) {
+
+		const ArchiveResource *ar = (const ArchiveResource *)&own[curround];
+		xmlDictPtr dict = xml_ctx_archive_dict(ar);
+
+		if ( dict == NULL || dict == run->dict || xml_ctx_archive_dict(ar) != dict || xml_ctx_archive_dict(run->shared) != run->dict ) {
+			++run->failures;
+		}
+
+		xml_ctx_archive_dict_free(ar);
+	}
+
+	return NULL;
+}
+
+static void test_xml_ctx_archive_dict_threads() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	xmlDictPtr dict = xml_ctx_archive_dict(ar);
+
+	pthread_t threads[TEST_XML_CTX_THREADS];
+	TestXmlDictThread runs[TEST_XML_CTX_THREADS];
+
+	for ( int curthread = 0; curthread < TEST_XML_CTX_THREADS; ++curthread ) {
+		TestXmlDictThread run = { ar, dict, 0 };
+		runs[curthread] = run;
+		assert(pthread_create(&threads[curthread], NULL, test_xml_ctx_archive_dict_thread, &runs[curthread]) == 0);
+	}
+
+	for ( int curthread = 0; curthread < TEST_XML_CTX_THREADS; ++curthread ) {
+		pthread_join(threads[curthread], NULL);
+		assert(runs[curthread].failures == 0);
+	}
+
+	assert(xml_ctx_archive_dict(ar) == dict);
+
+	xml_ctx_archive_dict_free(ar);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
 int 
 main() 
 {
@@ -572,14 +1328,32 @@ main()
 
 	test_xml_ctx_file();
 
+	test_xml_ctx_mapped();
+
+	test_xml_ctx_memory();
+
+	test_xml_ctx_parse_error();
+
+	test_xml_ctx_new_opts();
+
+	test_xml_ctx_shared_dict();
+
 	test_xml_ctx_extra_src();
 
 	test_xml_ctx_incl_src();
 
 	test_xml_ctx_xpath();
 
+	test_xml_ctx_xpath_cache();
+
+	test_xml_ctx_xpath_register_func();
+
+	test_xml_ctx_xpath_regexmatch_cache();
+
 	test_xml_ctx_xpath_format();
 
+	test_xml_ctx_query();
+
 	test_xml_ctx_add_node_xpath();
 
 	test_xml_ctx_xpath_in_range();
@@ -594,6 +1368,14 @@ main()
 
 	test_xml_ctx_xpath_to_float();
 
+	test_xml_ctx_xpath_aggregates();
+
+	test_xml_ctx_first();
+
+	test_xml_ctx_threads();
+
+	test_xml_ctx_archive_dict_threads();
+
 	DEBUG_LOG("<< end xml utils tests:\n");
 
 	return 0;
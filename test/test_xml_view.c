@@ -0,0 +1,175 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "defs.h"
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_view.h"
+
+EXTERN_BLOB(zip_resource, 7z);
+
+#ifndef DEBUG_LOG_ARGS
+	#if debug != 0
+		#define DEBUG_LOG_ARGS(fmt, ...) printf((fmt), __VA_ARGS__)
+	#else
+		#define DEBUG_LOG_ARGS(fmt, ...)
+	#endif
+#endif
+
+#ifndef DEBUG_LOG
+	#if debug != 0
+		#define DEBUG_LOG(msg) printf((msg))
+	#else
+		#define DEBUG_LOG(msg)
+	#endif
+#endif
+
+static bool test_xml_view_equals(const XmlStrView *view, const char *expected) {
+	return ( view->str != NULL && view->len == (int)strlen(expected) && memcmp(view->str, expected, view->len) == 0 );
+}
+
+static void test_xml_view_attr() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	ArchiveResource* ar = archive_resource_memory(&_binary_zip_resource_7z_start, (size_t)&_binary_zip_resource_7z_end - (size_t)&_binary_zip_resource_7z_start);
+	XmlSource* source = xml_source_from_resname(ar, "talents");
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	XmlStrView view;
+
+	/* same values like xml_ctx_get_attr, in place */
+	xmlXPathObjectPtr talents = xml_ctx_xpath(ctx, "//talent");
+
+	for ( int curtalent = 0; curtalent < talents->nodesetval->nodeNr; ++curtalent ) {
+
+		xmlNodePtr talent = talents->nodesetval->nodeTab[curtalent];
+		xmlChar *expected = xmlGetProp(talent, (const xmlChar *)"name");
+
+		assert(xml_node_attr_view(ctx, talent, (const unsigned char *)"name", &view));
+		assert(test_xml_view_equals(&view, (const char *)expected));
+		assert(view.str == xmlHasProp(talent, (const xmlChar *)"name")->children->content);
+
+		xmlFree(expected);
+	}
+
+	xmlXPathFreeObject(talents);
+
+	assert(xml_ctx_get_attr_view(ctx, (const unsigned char *)"inc", "//talent[@name = 'Raufen']", &view));
+	assert(test_xml_view_equals(&view, "C"));
+
+	assert(xml_ctx_get_attr_view_format(ctx, (const unsigned char *)"inc", &view, "//talent[@name = '%s']", "Dolche"));
+	assert(test_xml_view_equals(&view, "D"));
+
+	assert(!xml_ctx_get_attr_view(ctx, (const unsigned char *)"notfound", "//talent[@name = 'Raufen']", &view));
+	assert(view.str == NULL && view.len == 0);
+	assert(!xml_ctx_get_attr_view(ctx, (const unsigned char *)"inc", "//notfound", &view));
+	assert(!xml_ctx_get_attr_view(ctx, (const unsigned char *)"inc", "//talent/@name", &view));
+
+	/* several attributes of one node */
+	static const unsigned char * const names[] = { (const unsigned char *)"name", (const unsigned char *)"notfound", (const unsigned char *)"inc" };
+	XmlStrView views[3];
+
+	assert(xml_ctx_get_attrs(ctx, "//talent[@name = 'Raufen']", names, 3, views) == 2);
+	assert(test_xml_view_equals(&views[0], "Raufen"));
+	assert(views[1].str == NULL && views[1].len == 0);
+	assert(test_xml_view_equals(&views[2], "C"));
+
+	assert(xml_ctx_get_attrs_format(ctx, names, 3, views, "//talent[@name = '%s']", "Dolche") == 2);
+	assert(test_xml_view_equals(&views[0], "Dolche") && test_xml_view_equals(&views[2], "D"));
+
+	assert(xml_ctx_get_attrs(ctx, "//notfound", names, 3, views) == -1);
+	assert(views[0].str == NULL && views[2].str == NULL);
+
+	assert(ctx->views == NULL);
+
+	free_xml_ctx_src(&ctx);
+	archive_resource_free(&ar);
+
+	DEBUG_LOG("<<<\n");
+}
+
+static void test_xml_view_text() {
+	DEBUG_LOG_ARGS(">>> %s => %s\n", __FILE__, __func__);
+
+	static const unsigned char payload[] =
+		"<!DOCTYPE weapons ["
+			"<!ENTITY dice \"W6\">"
+			"<!ATTLIST weapon type CDATA \"melee\">"
+		"]>"
+		"<weapons>"
+			"<weapon name=\"Dolch\" tp=\"1&dice;+1\"><info>kurz</info><note/><mixed>a<b/>c</mixed></weapon>"
+			"<weapon name=\"Bogen\" type=\"range\"><info><![CDATA[lang & weit]]></info></weapon>"
+		"</weapons>";
+
+	XmlSource *source = xml_source_from_memory(payload, sizeof(payload) - 1, XML_SOURCE_BORROWED);
+	XmlCtx *ctx = xml_ctx_new(source);
+
+	XmlStrView view;
+
+	assert(xml_ctx_get_text_view(ctx, "//weapon[@name = 'Dolch']/info", &view));
+	assert(test_xml_view_equals(&view, "kurz"));
+	assert(xml_ctx_get_text_view(ctx, "//weapon[@name = 'Bogen']/info", &view));
+	assert(test_xml_view_equals(&view, "lang & weit"));
+	assert(xml_ctx_get_text_view(ctx, "//weapon[@name = 'Dolch']/note", &view));
+	assert(test_xml_view_equals(&view, ""));
+	assert(xml_ctx_get_text_view(ctx, "//weapon[@name = 'Dolch']/@name", &view));
+	assert(test_xml_view_equals(&view, "Dolch"));
+	assert(xml_ctx_get_text_view(ctx, "//weapon[@name = 'Dolch']/info/text()", &view));
+	assert(test_xml_view_equals(&view, "kurz"));
+	assert(!xml_ctx_get_text_view(ctx, "//notfound", &view));
+	assert(ctx->views == NULL);
+
+	/* values of several nodes are kept by the context */
+	assert(xml_ctx_get_text_view(ctx, "//weapon[@name = 'Dolch']/mixed", &view));
+	assert(test_xml_view_equals(&view, "ac"));
+	assert(ctx->views != NULL);
+
+	static const unsigned char * const names[] = { (const unsigned char *)"name", (const unsigned char *)"tp", (const unsigned char *)"type" };
+	XmlStrView views[3];
+
+	assert(xml_ctx_get_attrs(ctx, "//weapon[@name = 'Dolch']", names, 3, views) == 3);
+	assert(test_xml_view_equals(&views[0], "Dolch"));
+	assert(test_xml_view_equals(&views[1], "1W6+1"));
+	assert(test_xml_view_equals(&views[2], "melee"));
+
+	/* kept values are the same until the document changes */
+	XmlStrView kept;
+	assert(xml_ctx_get_attr_view(ctx, (const unsigned char *)"tp", "//weapon[@name = 'Dolch']", &kept));
+	assert(kept.str == views[1].str);
+	assert(xmlDictSize(ctx->views) == 2 && ctx->views_version == ctx->version);
+
+	xml_ctx_set_attr_str_xpath(ctx, (const unsigned char *)"2W6", "//weapon[@name = 'Dolch']/@tp");
+
+	assert(xml_ctx_get_attr_view(ctx, (const unsigned char *)"tp", "//weapon[@name = 'Dolch']", &view));
+	assert(test_xml_view_equals(&view, "2W6"));
+
+	/* the next kept value releases the values of former versions */
+	assert(ctx->views_version != ctx->version);
+	assert(xml_ctx_get_text_view(ctx, "//weapon[@name = 'Dolch']/mixed", &view));
+	assert(test_xml_view_equals(&view, "ac"));
+	assert(xmlDictSize(ctx->views) == 1 && ctx->views_version == ctx->version);
+
+	assert(xml_ctx_get_attrs(ctx, "//weapon[@name = 'Bogen']", names, 3, views) == 2);
+	assert(test_xml_view_equals(&views[2], "range"));
+
+	free_xml_ctx_src(&ctx);
+
+	DEBUG_LOG("<<<\n");
+}
+
+int
+main()
+{
+
+	DEBUG_LOG(">> Start xml view tests:\n");
+
+	test_xml_view_attr();
+
+	test_xml_view_text();
+
+	DEBUG_LOG("<< end xml view tests:\n");
+
+	return 0;
+}
@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "xml_source.h"
+#include "xml_utils.h"
+#include "xml_snapshot.h"
+
+/*
+    Writes a snapshot of every xml file into the target directory, the snapshot of
+    path/name.xml is target/name.xsnap. Up to date snapshots are not written again.
+
+    usage: mksnapshot <target directory> <xml files...>
+*/
+
+static int mksnapshot(const char *target, const char *xml_file) {
+
+    const char *name = xml_file;
+
+    for ( const char *cur = xml_file; *cur != '\0'; ++cur ) {
+        if ( *cur == '/' || *cur == '\\' ) name = cur + 1;
+    }
+
+    const char *ext = strrchr(name, '.');
+    const int name_len = (int)( ext != NULL ? (size_t)(ext - name) : strlen(name) );
+
+    char snapshot_file[1024];
+    snprintf(snapshot_file, sizeof(snapshot_file), "%s/%.*s.xsnap", target, name_len, name);
+
+    XmlSource *source = xml_source_from_file_mapped(xml_file);
+
+    if ( source == NULL ) {
+        fprintf(stderr, "mksnapshot: could not read %s\n", xml_file);
+        return -1;
+    }
+
+    XmlSource *snapshot = xml_source_from_file_mapped(snapshot_file);
+    const bool current = ( snapshot != NULL && xml_snapshot_current(snapshot->src_data, *snapshot->src_size, source) );
+    xml_source_free(&snapshot);
+
+    int result = 0;
+
+    if ( !current ) {
+
+        XmlCtx *ctx = xml_ctx_new(source);
+
+        if ( ctx->state.state_no != XML_CTX_SUCCESS || xml_snapshot_save(ctx, snapshot_file) != 0 ) {
+            fprintf(stderr, "mksnapshot: could not write snapshot of %s\n", xml_file);
+            result = -1;
+        } else {
+            printf("mksnapshot: %s => %s\n", xml_file, snapshot_file);
+        }
+
+        free_xml_ctx(&ctx);
+    }
+
+    xml_source_free(&source);
+
+    return result;
+}
+
+int
+main(int argc, char *argv[])
+{
+    if ( argc < 2 ) {
+        fprintf(stderr, "usage: %s <target directory> <xml files...>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+
+    for ( int curfile = 2; curfile < argc; ++curfile ) {
+        if ( mksnapshot(argv[1], argv[curfile]) != 0 ) {
+            result = EXIT_FAILURE;
+        }
+    }
+
+    return result;
+}